@@ -1,6 +1,7 @@
 
 #include <iostream>
 #include <nlohmann/json.hpp>
+#include <thread>
 
 #include "analysis-config.h"
 #include "analysis-manager.h"
@@ -63,16 +64,31 @@ void FindRelevantFiles(std::string path, std::string prefix, std::string extensi
 }
 
 bool ImportFileSet(const std::set<std::filesystem::path> &fileSet,
-                   simdjson::ondemand::parser &parser, SimDataManager &dataManager)
+                   simdjson::ondemand::parser &parser, SimDataManager &dataManager,
+                   uint32_t importThreads, bool printProgress = true)
 {
+  if (importThreads > 1 && fileSet.size() > 1)
+  {
+    if (printProgress)
+      std::cout << "Importing " << fileSet.size() << " files using " << importThreads
+                << " threads..." << std::flush;
+    std::vector<std::string> files(fileSet.begin(), fileSet.end());
+    if (dataManager.ImportResults(files, importThreads) > 1)
+      return false;
+    if (printProgress)
+      std::cout << " Done." << std::endl;
+    return true;
+  }
+
   bool createdSet = false;
   uint32_t count = 0;
   std::string total = std::to_string(fileSet.size());
   for (const auto &filepath : fileSet)
   {
     count++;
-    std::cout << "\r[File " << std::to_string(count) << "/" << total << "] Importing file "
-              << filepath << "..." << std::flush;
+    if (printProgress)
+      std::cout << "\r[File " << std::to_string(count) << "/" << total << "] Importing file "
+                << filepath << "..." << std::flush;
     if (dataManager.ImportResult(parser, filepath))
     {
       if (!createdSet)
@@ -81,7 +97,8 @@ bool ImportFileSet(const std::set<std::filesystem::path> &fileSet,
         return false;
     }
   }
-  std::cout << " Done." << std::endl;
+  if (printProgress)
+    std::cout << " Done." << std::endl;
   return true;
 }
 
@@ -160,20 +177,40 @@ struct CLIArgs
   fs::path analysisOutputDir = "./data/analysis-results/";
   std::string qlogFilePrefix = "";
   fs::path analysisConfigFile = "./data/analysis-config.json";
+  uint32_t importThreads = 1;
+  uint32_t analysisThreads = 1;
+  uint32_t pipelineDepth = 0;
+  fs::path snapshotDir = "";
+  bool importAllEvents = false;
+  bool lazyObservers = false;
 };
 
 void PrintCLIUsage(const std::string &programName)
 {
   std::cout << "Usage: " << programName
             << " <qlogFilePrefix> [-c analysisConfigFile] [-s simOutputDir] [-a "
-               "analysisOutputDir]\n"
+               "analysisOutputDir] [--import-threads N] [--analysis-threads N] [--pipeline N] "
+               "[--snapshot-cache dir] [--import-all-events] [--lazy-observers]\n"
             << "Example: " << programName
             << " download/eq-10-5MB -c ./data/analysis-config.json -s ../ns-3-dev-fork/output/ -a "
                "./data/analysis-results/\n"
             << "This will analyze all files starting with eq-10-5MB in the "
                "directory ../ns-3-dev-fork/output/download using "
                "the config specified in ./data/analysis-config.json and output the results to "
-               "./data/analysis-results/download/."
+               "./data/analysis-results/download/.\n"
+            << "With --import-threads N, the files of a run are imported using N threads.\n"
+            << "With --analysis-threads N, the analysis configs of a run are analyzed using N "
+               "threads. The output is the same as with a single thread.\n"
+            << "With --pipeline N, up to N runs are imported ahead while the current run is analyzed "
+               "and the output of the previous run is written.\n"
+            << "With --snapshot-cache dir, imported runs are stored as binary snapshots in dir and "
+               "loaded from there as long as their QLOG files do not change.\n"
+            << "By default, only events read by the configured analyses are imported. With "
+               "--import-all-events, all events are imported.\n"
+            << "With --lazy-observers, the traces of each run are indexed and only the observers "
+               "used by the analyses are imported. Flow paths then only consist of the imported "
+               "observers. Combined with --snapshot-cache, the index is stored instead of a "
+               "snapshot."
             << std::endl;
 }
 
@@ -224,6 +261,89 @@ std::pair<bool, CLIArgs> ParseCli(int arg, char *argv[])
         args.analysisOutputDir = argv[i + 1];
         i++;
       }
+      else if (argStr == "--import-threads")
+      {
+        if (i + 1 >= arg)
+        {
+          std::cerr << "Error: Missing argument for --import-threads." << std::endl;
+          return std::make_pair(false, args);
+        }
+        try
+        {
+          args.importThreads = std::stoul(argv[i + 1]);
+        }
+        catch (const std::exception &)
+        {
+          args.importThreads = 0;
+        }
+        if (args.importThreads == 0)
+        {
+          std::cerr << "Error: Invalid argument " << argv[i + 1] << " for --import-threads."
+                    << std::endl;
+          return std::make_pair(false, args);
+        }
+        i++;
+      }
+      else if (argStr == "--analysis-threads")
+      {
+        if (i + 1 >= arg)
+        {
+          std::cerr << "Error: Missing argument for --analysis-threads." << std::endl;
+          return std::make_pair(false, args);
+        }
+        try
+        {
+          args.analysisThreads = std::stoul(argv[i + 1]);
+        }
+        catch (const std::exception &)
+        {
+          args.analysisThreads = 0;
+        }
+        if (args.analysisThreads == 0)
+        {
+          std::cerr << "Error: Invalid argument " << argv[i + 1] << " for --analysis-threads."
+                    << std::endl;
+          return std::make_pair(false, args);
+        }
+        i++;
+      }
+      else if (argStr == "--pipeline")
+      {
+        if (i + 1 >= arg)
+        {
+          std::cerr << "Error: Missing argument for --pipeline." << std::endl;
+          return std::make_pair(false, args);
+        }
+        try
+        {
+          args.pipelineDepth = std::stoul(argv[i + 1]);
+        }
+        catch (const std::exception &)
+        {
+          std::cerr << "Error: Invalid argument " << argv[i + 1] << " for --pipeline."
+                    << std::endl;
+          return std::make_pair(false, args);
+        }
+        i++;
+      }
+      else if (argStr == "--snapshot-cache")
+      {
+        if (i + 1 >= arg)
+        {
+          std::cerr << "Error: Missing argument for --snapshot-cache." << std::endl;
+          return std::make_pair(false, args);
+        }
+        args.snapshotDir = argv[i + 1];
+        i++;
+      }
+      else if (argStr == "--import-all-events")
+      {
+        args.importAllEvents = true;
+      }
+      else if (argStr == "--lazy-observers")
+      {
+        args.lazyObservers = true;
+      }
       else
       {
         std::cerr << "Error: Unknown argument " << argStr << "." << std::endl;
@@ -262,9 +382,196 @@ std::pair<bool, CLIArgs> ParseCli(int arg, char *argv[])
     return std::make_pair(false, args);
   }
 
+  if (!args.snapshotDir.empty() && !std::filesystem::is_directory(args.snapshotDir))
+  {
+    std::cerr << "Error: Path " << args.snapshotDir << " does not exist." << std::endl;
+    return std::make_pair(false, args);
+  }
+
   return std::make_pair(true, args);
 }
 
+// Imports the summary and host traces of one run using a trace index, observers are imported by
+// the analyses on demand. If a snapshot cache is configured, the index is stored there.
+void ImportRunIndexed(const std::string &runId, const std::set<std::filesystem::path> &fileSet,
+                      simdjson::ondemand::parser &parser, SimDataManager &dataManager,
+                      const CLIArgs &cliArgs, bool printProgress)
+{
+  std::vector<std::string> files(fileSet.begin(), fileSet.end());
+  std::string indexFile;
+  std::string indexKey;
+  SimTraceIndexPointer index;
+  if (!cliArgs.snapshotDir.empty())
+  {
+    indexFile = (cliArgs.snapshotDir / (runId + ".efmidx.json")).string();
+    indexKey = SimSnapshot::CreateKey(files);
+    index = SimTraceIndex::Read(indexFile, indexKey);
+    if (index && printProgress)
+      std::cout << "Loaded trace index " << indexFile << "." << std::endl;
+  }
+
+  if (!index)
+  {
+    if (printProgress)
+      std::cout << "Indexing " << files.size() << " files..." << std::flush;
+    index = SimTraceIndex::Build(files, parser);
+    if (printProgress)
+      std::cout << " Done." << std::endl;
+    if (!indexFile.empty())
+      index->Write(indexFile, indexKey);
+  }
+
+  dataManager.ImportIndexed(index);
+}
+
+// Imports the files of one run. If a snapshot cache is configured, a valid snapshot of the run is
+// loaded instead and a new snapshot is written after importing the files.
+bool ImportRun(const std::string &runId, const std::set<std::filesystem::path> &fileSet,
+               simdjson::ondemand::parser &parser, SimDataManager &dataManager,
+               const CLIArgs &cliArgs, bool printProgress = true)
+{
+  if (cliArgs.lazyObservers)
+  {
+    ImportRunIndexed(runId, fileSet, parser, dataManager, cliArgs, printProgress);
+    return true;
+  }
+
+  std::string snapshotFile;
+  std::string snapshotKey;
+  if (!cliArgs.snapshotDir.empty())
+  {
+    snapshotFile = (cliArgs.snapshotDir / (runId + ".efmsnap")).string();
+    snapshotKey = SimSnapshot::CreateKey(std::vector<std::string>(fileSet.begin(), fileSet.end()),
+                                         dataManager.GetEventTypes());
+    if (dataManager.ImportSnapshot(snapshotFile, snapshotKey))
+    {
+      if (printProgress)
+        std::cout << "Loaded snapshot " << snapshotFile << "." << std::endl;
+      return true;
+    }
+  }
+
+  if (!ImportFileSet(fileSet, parser, dataManager, cliArgs.importThreads, printProgress))
+    return false;
+
+  if (!snapshotFile.empty())
+    dataManager.WriteSnapshot(dataManager.GetSimIds().front(), snapshotFile, snapshotKey);
+  return true;
+}
+
+struct ImportedRun
+{
+  std::string runId;
+  SimResultSetPointer srs;
+};
+
+struct AnalyzedRun
+{
+  std::string runId;
+  std::unique_ptr<OutputGenerator> outGen;
+};
+
+// Runs import, analysis, and output generation of consecutive runs concurrently: one thread
+// imports the next runs (at most pipelineDepth ahead), the calling thread analyzes, and one
+// thread generates and writes the output files
+int RunPipelined(const std::map<std::string, std::set<std::filesystem::path>> &fileMap,
+                 const std::vector<AnalysisConfig> &analysisConfigs,
+                 const std::optional<SimEventTypeSet> &eventTypes,
+                 const std::string &analysisOutputPath, const CLIArgs &cliArgs)
+{
+  BoundedQueue<ImportedRun> importedRuns(cliArgs.pipelineDepth);
+  BoundedQueue<AnalyzedRun> analyzedRuns(cliArgs.pipelineDepth);
+  // Each error message is only written by one thread and read after joining it
+  std::string importError;
+  std::string outputError;
+
+  std::thread importer([&]() {
+    simdjson::ondemand::parser parser;
+    try
+    {
+      for (const auto &fileSet : fileMap)
+      {
+        SimDataManager dataManager;
+        dataManager.SetEventTypes(eventTypes);
+        if (!ImportRun(fileSet.first, fileSet.second, parser, dataManager, cliArgs, false))
+        {
+          importError = "Multiple result sets found in files with prefix " + fileSet.first;
+          break;
+        }
+
+        SimResultSetPointer srs;
+        if (!dataManager.GetResultSet(dataManager.GetSimIds().front(), srs))
+        {
+          importError = "Could not access result set of prefix " + fileSet.first;
+          break;
+        }
+        LogLine(std::cout, "Import for prefix " + fileSet.first + " finished.");
+
+        // Fails if the analysis stage stopped
+        if (!importedRuns.Push({fileSet.first, srs}))
+          break;
+      }
+    }
+    catch (const std::exception &e)
+    {
+      importError = e.what();
+    }
+    importedRuns.Close();
+  });
+
+  std::thread writer([&]() {
+    try
+    {
+      while (auto run = analyzedRuns.Pop())
+      {
+        run->outGen->GenerateOutput();
+        LogLine(std::cout, "Output for prefix " + run->runId + " written.");
+      }
+    }
+    catch (const std::exception &e)
+    {
+      outputError = e.what();
+    }
+    analyzedRuns.Close();
+  });
+
+  std::string analysisError;
+  try
+  {
+    while (auto run = importedRuns.Pop())
+    {
+      LogLine(std::cout, "Starting analysis of prefix " + run->runId + ".");
+      auto outGen = std::make_unique<OutputGenerator>(
+          run->srs, analysisOutputPath + "analysis-" + run->runId + ".json");
+      AnalysisManager::RunAnalyses(run->srs, *outGen, analysisConfigs, cliArgs.analysisThreads);
+      run->srs.reset();
+      // Fails if the output stage stopped
+      if (!analyzedRuns.Push({run->runId, std::move(outGen)}))
+        break;
+    }
+  }
+  catch (const std::exception &e)
+  {
+    analysisError = e.what();
+  }
+  // Stops the importer early if the analysis or output stage failed
+  importedRuns.Close();
+  analyzedRuns.Close();
+  importer.join();
+  writer.join();
+
+  bool success = true;
+  for (const std::string &error : {importError, analysisError, outputError})
+  {
+    if (!error.empty())
+    {
+      std::cerr << "Error: " << error << std::endl;
+      success = false;
+    }
+  }
+  return success ? 0 : -1;
+}
+
 int main(int arg, char *argv[])
 {
   // Handle cli arguments
@@ -283,7 +590,13 @@ int main(int arg, char *argv[])
   if (!LoadAnalysisConfig(cliArgs.analysisConfigFile, analysisConfigs))
     return -1;
 
+  // Only import the events the analyses actually read
+  std::optional<SimEventTypeSet> eventTypes;
+  if (!cliArgs.importAllEvents)
+    eventTypes = AnalysisManager::GetRequiredEventTypes(analysisConfigs);
+
   SimDataManager dataManager;
+  dataManager.SetEventTypes(eventTypes);
   // It is more efficient to reuse the parser, so create it here and pass it
   // for each call of the ImportResult function
   simdjson::ondemand::parser parser;
@@ -294,12 +607,15 @@ int main(int arg, char *argv[])
   if (pathPrefix.size() > 0)
     analysisOutputPath += pathPrefix + "/";
 
+  if (cliArgs.pipelineDepth > 0)
+    return RunPipelined(fileMap, analysisConfigs, eventTypes, analysisOutputPath, cliArgs);
+
 
   for (const auto &fileSet : fileMap)
   {
     std::cout << "Begin import of files with prefix " << fileSet.first << std::endl;
 
-    if (!ImportFileSet(fileSet.second, parser, dataManager))
+    if (!ImportRun(fileSet.first, fileSet.second, parser, dataManager, cliArgs))
     {
       std::cerr << "Error: Multiple result sets found in files with prefix " << fileSet.first
                 << std::endl;
@@ -317,7 +633,7 @@ int main(int arg, char *argv[])
     }
 
     AnalysisManager::RunAnalyses(srs, analysisOutputPath + "analysis-" + fileSet.first + ".json",
-                                 analysisConfigs);
+                                 analysisConfigs, cliArgs.analysisThreads);
 
     std::cout << "Done." << std::endl;
     srs.reset();
@@ -39,22 +39,36 @@ void from_json(const json& jsn, AnalysisConfig& conf)
   }
 
 
-  // Lossrate Thresholds
-  if (jsn.contains("lossRateTh"))
+  // Lossrate Thresholds (a list sweeps over the thresholds)
+  if (jsn.contains("lossRateTh") && jsn.at("lossRateTh").is_array())
+    jsn.at("lossRateTh").get_to(conf.lossRateThSweep);
+  else if (jsn.contains("lossRateTh"))
     conf.lossRateTh = jsn.at("lossRateTh").get<double>();
+  else if (jsn.contains("autoLossRateThOffset") && jsn.at("autoLossRateThOffset").is_array())
+    jsn.at("autoLossRateThOffset").get_to(conf.autoLossRateThOffsetSweep);
   else if (jsn.contains("autoLossRateThOffset"))
     conf.autoLossRateThOffset = jsn.at("autoLossRateThOffset").get<double>();
   else
     throw std::runtime_error("No loss rate threshold specified in analysis config.");
+  if (!conf.lossRateTh.has_value() && !conf.autoLossRateThOffset.has_value() &&
+      conf.lossRateThSweep.empty() && conf.autoLossRateThOffsetSweep.empty())
+    throw std::runtime_error("Empty loss rate threshold sweep in analysis config.");
 
 
-  // Delay Thresholds
-  if (jsn.contains("delayThMs"))
+  // Delay Thresholds (a list sweeps over the thresholds)
+  if (jsn.contains("delayThMs") && jsn.at("delayThMs").is_array())
+    jsn.at("delayThMs").get_to(conf.delayThMsSweep);
+  else if (jsn.contains("delayThMs"))
     conf.delayThMs = jsn.at("delayThMs").get<uint32_t>();
+  else if (jsn.contains("autoDelayThOffsetMs") && jsn.at("autoDelayThOffsetMs").is_array())
+    jsn.at("autoDelayThOffsetMs").get_to(conf.autoDelayThOffsetMsSweep);
   else if (jsn.contains("autoDelayThOffsetMs"))
     conf.autoDelayThOffsetMs = jsn.at("autoDelayThOffsetMs").get<int32_t>();
   else
     throw std::runtime_error("No delay threshold specified in analysis config.");
+  if (!conf.delayThMs.has_value() && !conf.autoDelayThOffsetMs.has_value() &&
+      conf.delayThMsSweep.empty() && conf.autoDelayThOffsetMsSweep.empty())
+    throw std::runtime_error("Empty delay threshold sweep in analysis config.");
 
   // Localization methods
   for (auto& [key, val] : jsn.at("localizationMethods").items())
@@ -22,6 +22,12 @@ struct AnalysisConfig
   uint32_t flowLengthTh = 0;
   std::optional<int32_t> autoDelayThOffsetMs;
   std::optional<double> autoLossRateThOffset;
+  // Threshold sweeps, given as lists instead of single values. Each combination of the loss rate
+  // and delay thresholds is localized, the paths are only measured once for all of them.
+  std::vector<double> lossRateThSweep;
+  std::vector<uint32_t> delayThMsSweep;
+  std::vector<int32_t> autoDelayThOffsetMsSweep;
+  std::vector<double> autoLossRateThOffsetSweep;
   std::vector<ClassificationMode> classificationModes;
   std::map<LocalizationMethod, LocalizationParams> localizationMethods;
   std::map<FlowSelectionStrategy, FlowSelectionStrategyParams> flowSelectionStrategies;
@@ -1,5 +1,8 @@
 #include "analysis-manager.h"
 
+#include <helper-templates.h>
+
+#include <algorithm>
 #include <iostream>
 namespace analysis {
 
@@ -203,6 +206,103 @@ bool TryGetPingResultForResultTypeRawValues(const simdata::SimPingPair& pp, Resu
 
 
 
+// Returns the event types the getters used for resType read (both flow and path events for L)
+std::vector<simdata::SimEventType> GetEventTypesForResultType(ResultType resType)
+{
+  using simdata::SimEventType;
+  switch (resType)
+  {
+    case ResultType::SEQ_REL_LOSS:
+    case ResultType::SEQ_ABS_LOSS:
+      return {SimEventType::OBSV_SEQ_LOSS};
+    case ResultType::ACK_SEQ_REL_LOSS:
+    case ResultType::ACK_SEQ_ABS_LOSS:
+      return {SimEventType::OBSV_ACK_SEQ_LOSS};
+    case ResultType::Q_REL_LOSS:
+    case ResultType::Q_ABS_LOSS:
+      return {SimEventType::OBSV_Q_BIT_LOSS};
+    case ResultType::R_REL_LOSS:
+    case ResultType::R_ABS_LOSS:
+      return {SimEventType::OBSV_R_BIT_LOSS};
+    case ResultType::T_REL_FULL_LOSS:
+    case ResultType::T_ABS_FULL_LOSS:
+      return {SimEventType::OBSV_T_BIT_FULL_LOSS};
+    case ResultType::T_REL_HALF_LOSS:
+    case ResultType::T_ABS_HALF_LOSS:
+      return {SimEventType::OBSV_T_BIT_HALF_LOSS};
+    case ResultType::L_REL_LOSS:
+    case ResultType::L_ABS_LOSS:
+      return {SimEventType::OBSV_L_BIT_SET, SimEventType::OBSV_P_L_BIT_SET};
+    case ResultType::SPIN_AVG_DELAY:
+    case ResultType::SPIN_DELAY_RAW:
+      return {SimEventType::OBSV_SPIN_BIT_DELAY};
+    case ResultType::SQ_REL_LOSS:
+    case ResultType::SQ_ABS_LOSS:
+      return {SimEventType::OBSV_P_SQ_BITS_LOSS};
+    case ResultType::TCPDART_AVG_DELAY:
+    case ResultType::TCPDART_DELAY_RAW:
+      return {SimEventType::OBSV_TCP_DART_DELAY};
+    case ResultType::TCPRO_ABS_LOSS:
+    case ResultType::TCPRO_REL_LOSS:
+      return {SimEventType::OBSV_TCP_REORDERING};
+    case ResultType::PING_CLNT_ABS_LOSS:
+    case ResultType::PING_CLNT_REL_LOSS:
+      return {SimEventType::PING_RT_LOSS};
+    case ResultType::PING_CLNT_AVG_DELAY:
+    case ResultType::PING_CLNT_DELAY_RAW:
+      return {SimEventType::PING_RT_DELAY};
+    case ResultType::PING_SVR_ABS_LOSS:
+    case ResultType::PING_SVR_REL_LOSS:
+      return {SimEventType::PING_ETE_LOSS};
+    case ResultType::PING_SVR_AVG_DELAY:
+    case ResultType::PING_SVR_DELAY_RAW:
+      return {SimEventType::PING_ETE_DELAY};
+    default:
+      throw std::runtime_error("GetEventTypesForResultType: Unknown result type");
+  }
+}
+
+// Returns the event types classification and localization read for bits, including the
+// bidirectional variants (e.g., the T bit half loss and the reverse flow's Q bit loss for QT)
+std::vector<simdata::SimEventType> GetEventTypesForEfmBit(EfmBit bits)
+{
+  using simdata::SimEventType;
+  switch (bits)
+  {
+    case EfmBit::Q:
+      return {SimEventType::OBSV_Q_BIT_LOSS};
+    case EfmBit::L:
+      return {SimEventType::OBSV_L_BIT_SET};
+    case EfmBit::R:
+      return {SimEventType::OBSV_R_BIT_LOSS};
+    case EfmBit::T:
+      return {SimEventType::OBSV_T_BIT_FULL_LOSS, SimEventType::OBSV_T_BIT_HALF_LOSS};
+    case EfmBit::SPIN:
+      return {SimEventType::OBSV_SPIN_BIT_DELAY};
+    case EfmBit::QR:
+      return {SimEventType::OBSV_Q_BIT_LOSS, SimEventType::OBSV_R_BIT_LOSS};
+    case EfmBit::QL:
+      return {SimEventType::OBSV_Q_BIT_LOSS, SimEventType::OBSV_L_BIT_SET};
+    case EfmBit::QT:
+      return {SimEventType::OBSV_Q_BIT_LOSS, SimEventType::OBSV_T_BIT_FULL_LOSS,
+              SimEventType::OBSV_T_BIT_HALF_LOSS};
+    case EfmBit::LT:
+      return {SimEventType::OBSV_L_BIT_SET, SimEventType::OBSV_T_BIT_FULL_LOSS};
+    case EfmBit::SEQ:
+      return {SimEventType::OBSV_SEQ_LOSS};
+    case EfmBit::TCPRO:
+      return {SimEventType::OBSV_TCP_REORDERING};
+    case EfmBit::TCPDART:
+      return {SimEventType::OBSV_TCP_DART_DELAY};
+    case EfmBit::PINGDLY:
+      return {SimEventType::PING_RT_DELAY, SimEventType::PING_ETE_DELAY};
+    case EfmBit::PINGLSS:
+      return {SimEventType::PING_RT_LOSS, SimEventType::PING_ETE_LOSS};
+    default:
+      throw std::runtime_error("GetEventTypesForEfmBit: Unknown EFM bit");
+  }
+}
+
 double CalculateLossThreshold(const simdata::SimResultSet& simResultSet, double offset)
 {
   // Set initial value that never occurs
@@ -244,6 +344,33 @@ uint32_t CalculateDelayThreshold(const simdata::SimResultSet& simResultSet, int3
     return delayTh + offset;
 }
 
+// Result sets with on demand import only contain the observers requested so far, so import the
+// ones the analysis reads: all for stored measurements and empty observer sets, else the listed
+// ones
+void LoadRequiredObservers(const AnalysisConfig& analysisConfig,
+                           simdata::SimResultSet& simResultSet)
+{
+  if (!simResultSet.IsPartiallyLoaded())
+    return;
+
+  bool allObservers = analysisConfig.storeMeasurements;
+  std::set<uint32_t> observers;
+  if (analysisConfig.performLocalization)
+  {
+    for (const auto& observerSet : analysisConfig.observerSets)
+    {
+      if (observerSet.observers.empty())
+        allObservers = true;
+      observers.insert(observerSet.observers.begin(), observerSet.observers.end());
+    }
+  }
+
+  if (allObservers)
+    simResultSet.LoadVantagePoints(simdata::VantagePointType::NETWORK);
+  else
+    simResultSet.LoadVantagePoints(simdata::VantagePointType::NETWORK, observers);
+}
+
 void PrepareConfig(AnalysisConfig& analysisConfig, const simdata::SimResultSet& simResultSet)
 {
   // An empty observer set means that all observers should be used
@@ -256,19 +383,44 @@ void PrepareConfig(AnalysisConfig& analysisConfig, const simdata::SimResultSet&
   }
 }
 
-void GetConfigThresholds(const AnalysisConfig& analysisConfig,
-                         const simdata::SimResultSet& simResultSet, uint32_t& delayThMs,
-                         double& lossRateTh)
+// Returns all combinations of the loss rate and delay thresholds of the config (a single one if it
+// does not sweep over thresholds), loss rate major
+std::vector<ClassificationThresholds> GetConfigThresholds(const AnalysisConfig& analysisConfig,
+                                                          const simdata::SimResultSet& simResultSet)
 {
+  std::vector<double> lossRateThs = analysisConfig.lossRateThSweep;
   if (analysisConfig.lossRateTh.has_value())
-    lossRateTh = analysisConfig.lossRateTh.value();
-  else
-    lossRateTh = CalculateLossThreshold(simResultSet, *analysisConfig.autoLossRateThOffset);
-
+    lossRateThs.push_back(analysisConfig.lossRateTh.value());
+  else if (analysisConfig.autoLossRateThOffset.has_value())
+    lossRateThs.push_back(
+        CalculateLossThreshold(simResultSet, *analysisConfig.autoLossRateThOffset));
+  for (double offset : analysisConfig.autoLossRateThOffsetSweep)
+    lossRateThs.push_back(CalculateLossThreshold(simResultSet, offset));
+
+  std::vector<uint32_t> delayThsMs = analysisConfig.delayThMsSweep;
   if (analysisConfig.delayThMs.has_value())
-    delayThMs = analysisConfig.delayThMs.value();
-  else
-    delayThMs = CalculateDelayThreshold(simResultSet, *analysisConfig.autoDelayThOffsetMs);
+    delayThsMs.push_back(analysisConfig.delayThMs.value());
+  else if (analysisConfig.autoDelayThOffsetMs.has_value())
+    delayThsMs.push_back(
+        CalculateDelayThreshold(simResultSet, *analysisConfig.autoDelayThOffsetMs));
+  for (int32_t offset : analysisConfig.autoDelayThOffsetMsSweep)
+    delayThsMs.push_back(CalculateDelayThreshold(simResultSet, offset));
+
+  std::vector<ClassificationThresholds> thresholds;
+  for (double lossRateTh : lossRateThs)
+  {
+    for (uint32_t delayThMs : delayThsMs)
+      thresholds.push_back(ClassificationThresholds{lossRateTh, delayThMs});
+  }
+  return thresholds;
+}
+
+// Random flow selection draws from the global rand() sequence, so the results depend on the order
+// in which configs using it run
+bool UsesRandomFlowSelection(const AnalysisConfig& analysisConfig)
+{
+  return analysisConfig.performLocalization &&
+         analysisConfig.flowSelectionStrategies.count(FlowSelectionStrategy::RANDOM) > 0;
 }
 
 }  // namespace
@@ -279,9 +431,17 @@ void GetConfigThresholds(const AnalysisConfig& analysisConfig,
 
 void AnalysisManager::RunAnalyses(simdata::SimResultSetPointer simResultSet,
                                   const std::string& outputFile,
-                                  std::vector<AnalysisConfig> analysisConfigs)
+                                  std::vector<AnalysisConfig> analysisConfigs, uint32_t numThreads)
 {
   OutputGenerator outGen(simResultSet, outputFile);
+  RunAnalyses(simResultSet, outGen, analysisConfigs, numThreads);
+  outGen.GenerateOutput();
+}
+
+void AnalysisManager::RunAnalyses(simdata::SimResultSetPointer simResultSet,
+                                  OutputGenerator& outGen,
+                                  std::vector<AnalysisConfig> analysisConfigs, uint32_t numThreads)
+{
   bool storedMeasurements = false;
   for (auto& analysisConfig : analysisConfigs)
   {
@@ -290,22 +450,131 @@ void AnalysisManager::RunAnalyses(simdata::SimResultSetPointer simResultSet,
       analysisConfig.storeMeasurements = false;
     else if (analysisConfig.storeMeasurements)
       storedMeasurements = true;
-    DoRunAnalysis(simResultSet, outGen, analysisConfig);
   }
 
-  outGen.GenerateOutput();
+  // Load the observers of all configs before the first analysis, so that all of them read the same
+  // frozen result set
+  for (const auto& analysisConfig : analysisConfigs)
+    LoadRequiredObservers(analysisConfig, *simResultSet);
+  simdata::ConstSimResultSetPointer frozenSrs = simResultSet->Freeze();
+
+  // Create the filtered views of all configs in one pass over the events
+  std::vector<simdata::SimFilter> filters;
+  for (const auto& analysisConfig : analysisConfigs)
+  {
+    if (analysisConfig.performLocalization)
+      filters.push_back(analysisConfig.simFilter);
+  }
+  frozenSrs->ApplyFilters(filters);
+
+  // Configs often only differ in their localization parameters, they share the classified and
+  // characterized paths for the rest of the run
+  LocalizationInputCache inputCache;
+  if (numThreads > 1 && analysisConfigs.size() > 1)
+    RunAnalysesConcurrently(frozenSrs, outGen, analysisConfigs, numThreads, inputCache);
+  else
+  {
+    for (auto& analysisConfig : analysisConfigs)
+      DoRunAnalysis(frozenSrs, outGen, analysisConfig, numThreads, &inputCache);
+  }
+}
+
+void AnalysisManager::RunAnalysesConcurrently(simdata::ConstSimResultSetPointer simResultSet,
+                                              OutputGenerator& outGen,
+                                              std::vector<AnalysisConfig>& analysisConfigs,
+                                              uint32_t numThreads,
+                                              LocalizationInputCache& inputCache)
+{
+  // Each config collects its results in its own generator, they are merged in config order
+  std::vector<std::unique_ptr<OutputGenerator>> configOutGens;
+  for (size_t i = 0; i < analysisConfigs.size(); i++)
+    configOutGens.push_back(std::make_unique<OutputGenerator>(simResultSet, ""));
+
+  // A task runs one or more configs one after another. Configs with random flow selection form a
+  // single task, so that they draw the same random numbers as in a sequential run.
+  std::vector<std::vector<size_t>> tasks;
+  std::vector<size_t> randomConfigs;
+  for (size_t i = 0; i < analysisConfigs.size(); i++)
+  {
+    if (UsesRandomFlowSelection(analysisConfigs[i]))
+      randomConfigs.push_back(i);
+    else
+      tasks.push_back({i});
+  }
+  // Start the longest task first
+  if (!randomConfigs.empty())
+    tasks.insert(tasks.begin(), randomConfigs);
+
+  // Threads that do not get a task of their own are used by the localization of the configs
+  uint32_t localizationThreads = std::max<uint32_t>(1, numThreads / tasks.size());
+  ParallelFor(tasks.size(), numThreads, [&](size_t t) {
+    for (size_t i : tasks[t])
+      DoRunAnalysis(simResultSet, *configOutGens[i], analysisConfigs[i], localizationThreads,
+                    &inputCache);
+  });
+
+  for (auto& configOutGen : configOutGens) outGen.Merge(*configOutGen);
 }
 
 void AnalysisManager::RunAnalysis(simdata::SimResultSetPointer simResultSet,
                                   const std::string& outputFile, AnalysisConfig analysisConfig)
 {
   OutputGenerator outGen(simResultSet, outputFile);
-  DoRunAnalysis(simResultSet, outGen, analysisConfig);
+  LoadRequiredObservers(analysisConfig, *simResultSet);
+  DoRunAnalysis(simResultSet->Freeze(), outGen, analysisConfig);
   outGen.GenerateOutput();
 }
 
-void AnalysisManager::DoRunAnalysis(simdata::SimResultSetPointer simResultSet,
-                                    OutputGenerator& outGen, AnalysisConfig& analysisConfig)
+simdata::SimEventTypeSet AnalysisManager::GetRequiredEventTypes(
+    const std::vector<AnalysisConfig>& analysisConfigs)
+{
+  using simdata::SimEventType;
+  simdata::SimEventTypeSet eventTypes = {SimEventType::OBSV_FLOW_BEGIN};
+
+  auto addResultTypes = [&eventTypes](const auto& resTypes) {
+    for (ResultType resType : resTypes)
+    {
+      for (SimEventType evType : GetEventTypesForResultType(resType)) eventTypes.insert(evType);
+    }
+  };
+
+  for (const auto& analysisConfig : analysisConfigs)
+  {
+    if (analysisConfig.storeMeasurements)
+    {
+      addResultTypes(FLOW_RESULT_TYPES);
+      addResultTypes(PATH_RESULT_TYPES);
+      addResultTypes(PING_CLIENT_RESULT_TYPES);
+      addResultTypes(PING_SERVER_RESULT_TYPES);
+      if (analysisConfig.output_raw_values)
+      {
+        addResultTypes(FLOW_RESULT_TYPES_RAW_VALUES);
+        addResultTypes(PING_CLIENT_RESULT_TYPES_RAW);
+        addResultTypes(PING_SERVER_RESULT_TYPES_RAW);
+      }
+    }
+
+    if (analysisConfig.performLocalization)
+    {
+      for (const auto& bitSet : analysisConfig.efmBitSets)
+      {
+        for (EfmBit bits : bitSet)
+        {
+          for (SimEventType evType : GetEventTypesForEfmBit(bits)) eventTypes.insert(evType);
+        }
+      }
+      // The filter needs the L bit set events to find the start of the monitoring
+      if (analysisConfig.simFilter.lBitTriggeredMonitoring)
+        eventTypes.insert(SimEventType::OBSV_L_BIT_SET);
+    }
+  }
+
+  return eventTypes;
+}
+
+void AnalysisManager::DoRunAnalysis(simdata::ConstSimResultSetPointer simResultSet,
+                                    OutputGenerator& outGen, AnalysisConfig& analysisConfig,
+                                    uint32_t numThreads, LocalizationInputCache* inputCache)
 {
   // Store measurement results for each flow and path per observer
   if (analysisConfig.storeMeasurements)
@@ -394,17 +663,16 @@ void AnalysisManager::DoRunAnalysis(simdata::SimResultSetPointer simResultSet,
     PrepareConfig(analysisConfig, *simResultSet);
     auto filteredSrs = simResultSet->ApplyFilter(analysisConfig.simFilter);
 
-    uint32_t delayThMs;
-    double lossRateTh;
-    GetConfigThresholds(analysisConfig, *simResultSet, delayThMs, lossRateTh);
+    std::vector<ClassificationThresholds> thresholds =
+        GetConfigThresholds(analysisConfig, *simResultSet);
 
     for (const auto& mode : analysisConfig.classificationModes)
     {
         for (const auto& selectionStrategy : analysisConfig.flowSelectionStrategies)
         {
             auto result = FailureLocalization::LocalizeFailures(
-                *filteredSrs, analysisConfig.observerSets, analysisConfig.efmBitSets, lossRateTh,
-                delayThMs, analysisConfig.flowLengthTh, mode, analysisConfig.localizationMethods, analysisConfig.classification_base_id, analysisConfig.time_filter_ms, (FlowSelectionStrategyWithParams){selectionStrategy.first, selectionStrategy.second});
+                *filteredSrs, analysisConfig.observerSets, analysisConfig.efmBitSets, thresholds,
+                analysisConfig.flowLengthTh, mode, analysisConfig.localizationMethods, analysisConfig.classification_base_id, analysisConfig.time_filter_ms, (FlowSelectionStrategyWithParams){selectionStrategy.first, selectionStrategy.second}, numThreads, inputCache);
             for (auto& [classConf, locResults] : result)
             {
                 outGen.AddLocalizationResults(analysisConfig.simFilter, classConf, locResults, (FlowSelectionStrategyWithParams){selectionStrategy.first, selectionStrategy.second});
@@ -12,14 +12,39 @@ namespace analysis {
 class AnalysisManager
 {
 public:
+  /// @brief Runs all analyses. The observers they read are loaded first, then the result set is
+  /// frozen (see SimResultSet::Freeze), so no further results can be imported into it afterwards.
+  /// @param numThreads The number of threads that run configs and their localizations concurrently.
+  /// The output is the same as for a sequential run (numThreads = 1). Configs with the same
+  /// localization inputs classify and characterize the paths only once.
   static void RunAnalyses(simdata::SimResultSetPointer simResultSet, const std::string &outputFile,
-                          std::vector<AnalysisConfig> analysisConfigs);
+                          std::vector<AnalysisConfig> analysisConfigs, uint32_t numThreads = 1);
+  /// @brief Runs all analyses and only collects the results in outGen, so that generating and
+  /// writing the output (OutputGenerator::GenerateOutput) can be done later or by another thread
+  static void RunAnalyses(simdata::SimResultSetPointer simResultSet, OutputGenerator &outGen,
+                          std::vector<AnalysisConfig> analysisConfigs, uint32_t numThreads = 1);
   static void RunAnalysis(simdata::SimResultSetPointer simResultSet, const std::string &outputFile,
                           AnalysisConfig analysisConfig);
 
+  /// @brief Determines the event types the specified analyses read, so that the import can skip
+  /// all others. Flow begin events are always included, since they define the observed flows.
+  static simdata::SimEventTypeSet GetRequiredEventTypes(
+      const std::vector<AnalysisConfig> &analysisConfigs);
+
 protected:
-  static void DoRunAnalysis(simdata::SimResultSetPointer simResultSet, OutputGenerator &outGen,
-                            AnalysisConfig &analysisConfig);
+  // Only reads the result set, which has to contain all observers the analysis needs. The
+  // localization uses up to numThreads threads and shares its inputs with other analyses of the
+  // run through inputCache, if set.
+  static void DoRunAnalysis(simdata::ConstSimResultSetPointer simResultSet,
+                            OutputGenerator &outGen, AnalysisConfig &analysisConfig,
+                            uint32_t numThreads = 1,
+                            LocalizationInputCache *inputCache = nullptr);
+  // Runs the configs on numThreads threads, each into its own generator, and merges the results
+  // into outGen in config order
+  static void RunAnalysesConcurrently(simdata::ConstSimResultSetPointer simResultSet,
+                                      OutputGenerator &outGen,
+                                      std::vector<AnalysisConfig> &analysisConfigs,
+                                      uint32_t numThreads, LocalizationInputCache &inputCache);
 
 private:
 };
@@ -1,8 +1,11 @@
 #include "classified-path-set.h"
+#include <helper-templates.h>
 
 #include "iostream"
 #include "sim-ping-pair.h"
 
+#include <limits>
+
 namespace analysis {
 
 void to_json(nlohmann::json &jsn, const ObserverSet &obsSet)
@@ -47,7 +50,7 @@ ClassifiedPathSet ClassifiedPathSet::ClassifyAll(const simdata::SimResultSet &sr
 
 ClassifiedPathSet ClassifiedPathSet::ClassifyAll(const simdata::SimResultSet &srs,
                                                  const std::set<uint32_t> &observerIds,
-                                                 const std::map<uint32_t, std::set<uint32_t>> flowSelectionMap,
+                                                 const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
                                                  const EfmBitSet &bitCombis, double lossRateTh,
                                                  uint32_t delayTh, uint32_t flowLengthTh,
                                                  ClassificationMode classificationMode,
@@ -59,7 +62,7 @@ ClassifiedPathSet ClassifiedPathSet::ClassifyAll(const simdata::SimResultSet &sr
   std::set<uint32_t> flowIds;
   for (auto &oid : observerIds)
   {
-    auto fids = srs.GetObserverFlowIds(oid);
+    const auto &fids = srs.GetObserverFlowIds(oid);
     flowIds.insert(fids.begin(), fids.end());
   }
   return Classify(srs, observerIds, flowIds, flowSelectionMap, bitCombis, lossRateTh, delayTh, flowLengthTh,
@@ -69,7 +72,7 @@ ClassifiedPathSet ClassifiedPathSet::ClassifyAll(const simdata::SimResultSet &sr
 ClassifiedPathSet ClassifiedPathSet::Classify(const simdata::SimResultSet &srs,
                                               const std::set<uint32_t> &observerIds,
                                               const std::set<uint32_t> &flowIds,
-                                              std::map<uint32_t, std::set<uint32_t>> flowSelectionMap,
+                                              const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
                                               const EfmBitSet &bitCombis, double lossRateTh,
                                               uint32_t delayTh, uint32_t flowLengthTh,
                                               ClassificationMode classificationMode,
@@ -77,13 +80,47 @@ ClassifiedPathSet ClassifiedPathSet::Classify(const simdata::SimResultSet &srs,
                                               double smallFailFactor,
                                               double largeFailFactor,
                                               double time_filter)
+{
+  PathMeasurementSet measurements = Measure(srs, observerIds, flowIds, flowSelectionMap, bitCombis,
+                                            flowLengthTh, classificationMode, time_filter);
+  return Classify(measurements, {ClassificationThresholds{lossRateTh, delayTh}},
+                  classification_base_id, smallFailFactor, largeFailFactor)
+      .front();
+}
+
+PathMeasurementSet ClassifiedPathSet::MeasureAll(const simdata::SimResultSet &srs,
+                                                 const std::set<uint32_t> &observerIds,
+                                                 const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
+                                                 const EfmBitSet &bitCombis, uint32_t flowLengthTh,
+                                                 ClassificationMode classificationMode,
+                                                 double time_filter)
+{
+  std::set<uint32_t> flowIds;
+  for (auto &oid : observerIds)
+  {
+    const auto &fids = srs.GetObserverFlowIds(oid);
+    flowIds.insert(fids.begin(), fids.end());
+  }
+  return Measure(srs, observerIds, flowIds, flowSelectionMap, bitCombis, flowLengthTh,
+                 classificationMode, time_filter);
+}
+
+PathMeasurementSet ClassifiedPathSet::Measure(const simdata::SimResultSet &srs,
+                                              const std::set<uint32_t> &observerIds,
+                                              const std::set<uint32_t> &flowIds,
+                                              const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
+                                              const EfmBitSet &bitCombis, uint32_t flowLengthTh,
+                                              ClassificationMode classificationMode,
+                                              double time_filter)
 {
   if (observerIds.empty() || flowIds.empty() || bitCombis.empty())
     throw std::invalid_argument("Empty input arg.");
 
-  ClassifiedPathSet cps(lossRateTh, delayTh, flowLengthTh, classificationMode, classification_base_id);
-  cps.m_config.flowIds = flowIds;
-  cps.m_config.observerSet.observers = observerIds;
+  PathMeasurementSet measurements;
+  measurements.observerIds = observerIds;
+  measurements.flowIds = flowIds;
+  measurements.flowLengthTh = flowLengthTh;
+  measurements.classificationMode = classificationMode;
 
   // Iterate over all flows
   for (auto &fid : flowIds)
@@ -91,13 +128,12 @@ ClassifiedPathSet ClassifiedPathSet::Classify(const simdata::SimResultSet &srs,
     // Calculate (reverse) flow path as sequence of observers and corresponding link path as
     // sequence of links
     std::vector<simdata::ObsvVantagePointPointer> fp = srs.CalculateFlowPath(fid);
-    auto _lp = GenerateLinkPath(fp);
+    auto _lp = GenerateLinkPath(srs.GetFlowPath(fid));
     if (!_lp.has_value())
       continue;
     LinkPath lp = _lp.value();
     uint32_t reverseFid = srs.GetReverseFlowId(fid);
-    std::vector<simdata::ObsvVantagePointPointer> reverseFp = srs.CalculateFlowPath(reverseFid);
-    auto _reverseLp = GenerateLinkPath(reverseFp);
+    auto _reverseLp = GenerateLinkPath(srs.GetFlowPath(reverseFid));
     if (!_reverseLp.has_value())
       continue;
     LinkPath reverseLp = _reverseLp.value();
@@ -110,75 +146,130 @@ ClassifiedPathSet ClassifiedPathSet::Classify(const simdata::SimResultSet &srs,
       // Check if observer should be used for classification
       // 1. Observer is in the observerSet
       // 2. Observer has selected the flow
-      if (observerIds.find(observerId) != observerIds.end() && flowSelectionMap[observerId].count(fid))
+      if (observerIds.find(observerId) != observerIds.end() && IsFlowSelected(flowSelectionMap, observerId, fid))
       {
         // Check if flow is observed bidirectionally
         bool bidirectional = reverseLp.ContainsNode(observerId);
 
-        // Generate and classify paths for each bit combination
+        // Generate and measure paths for each bit combination
         for (auto &bit : bitCombis)
         {
           if (IsActiveMmntBit(bit))
             continue;  // We handle active measurement bits later
 
-          ClassifiedLinkPath clp;
-          clp.path = cps.GenerateUnidirBitPaths(observerId, bit, lp, reverseLp);
+          LinkPath path = GenerateUnidirBitPaths(observerId, bit, lp, reverseLp);
 
           // Important to generate at least an empty vector, even if no paths are generated
           // so we can later differentiate between invalid observer/bit combinations and
           // combinations that just yielded no paths
-          ClassPathVec &cpv = cps.m_classifiedPaths[observerId][bit];
+          std::vector<MeasuredLinkPath> &mpv = measurements.paths[observerId][bit];
 
-          if (srs.GetFlowStats(observerId, fid).totalEfmPackets == 0)
+          const auto &flowStats = srs.GetFlowStats(observerId, fid);
+          if (flowStats.totalEfmPackets == 0)
             continue;  // Skip flows with no EFM packets
 
+          bool isLossBit = IsLossBit(bit);
           if (classificationMode == ClassificationMode::STATIC)
           {
-            FailureStruct failed =
-                cps.ClassifyFlow(obptr, fid, bit, smallFailFactor, largeFailFactor, time_filter);
-            // Only add paths that are long enough or failed and ignore faulty measurements
-            // (negative loss/delay cant exist)
-            if ((failed.small_failure ||
-                 srs.GetFlowStats(observerId, fid).totalPackets >= flowLengthTh) &&
-                failed.measurement >= 0.0)
-            {
-              clp.failed = failed.failed_and_medium_failure;
-              clp.measurement = failed.measurement;
-              cpv.push_back(clp);
-            }
+            double measurement = MeasureFlow(obptr, fid, bit, time_filter);
+            // Ignore faulty measurements (negative loss/delay cant exist)
+            if (measurement >= 0.0)
+              mpv.push_back(MeasuredLinkPath{path, isLossBit, measurement, true, measurement,
+                                             flowStats.totalPackets >= flowLengthTh});
           }
           else if (classificationMode == ClassificationMode::PERFECT)
           {
-            bool isLossBit = IsLossBit(bit);
-            clp.failed = cps.ClassifyLinkPathViaGT(srs, clp.path, isLossBit, !isLossBit);
-            clp.measurement = 0.0;
-            cpv.push_back(clp);
+            mpv.push_back(MeasuredLinkPath{path, isLossBit,
+                                           GetLinkPathGroundTruth(srs, path, isLossBit), true,
+                                           0.0, true});
           }
 
-          // It is hard to split bit path generation and classification for bidirectional flows
+          // It is hard to split bit path generation and measurement for bidirectional flows
           // So let this method handle all of it (if the observer is bidirectional)
           if (bidirectional)
-            cps.HandleBidirBitPathClassification(srs, obptr, bit, fid, reverseFid, lp, reverseLp, smallFailFactor, largeFailFactor, time_filter);
+            MeasureBidirBitPaths(srs, measurements, obptr, bit, fid, reverseFid, lp, reverseLp,
+                                 time_filter);
         }
       }
     }
   }
 
   // Handle active measurement bits
-  cps.HandleActiveMeasurements(srs, observerIds, bitCombis, lossRateTh, delayTh,
-                               classificationMode,classification_base_id, smallFailFactor, largeFailFactor);
+  MeasureActivePaths(srs, measurements, observerIds, bitCombis);
 
-  return cps;
+  return measurements;
 }
 
-void ClassifiedPathSet::HandleActiveMeasurements(const simdata::SimResultSet &srs,
-                                                 const std::set<uint32_t> &observerIds,
-                                                 const EfmBitSet &bitCombis, double lossRateTh,
-                                                 uint32_t delayTh,
-                                                 ClassificationMode classificationMode,
-                                                 std::string classification_base_id,
-                                                 double smallFailFactor,
-                                                 double largeFailFactor)
+std::vector<ClassifiedPathSet> ClassifiedPathSet::Classify(
+    const PathMeasurementSet &measurements,
+    const std::vector<ClassificationThresholds> &thresholds, std::string classification_base_id,
+    double smallFailFactor, double largeFailFactor)
+{
+  std::vector<ClassifiedPathSet> sets;
+  for (const auto &th : thresholds)
+  {
+    ClassifiedPathSet cps(th.lossRateTh, th.delayTh, measurements.flowLengthTh,
+                          measurements.classificationMode, classification_base_id);
+    cps.m_config.flowIds = measurements.flowIds;
+    cps.m_config.observerSet.observers = measurements.observerIds;
+    sets.push_back(std::move(cps));
+  }
+
+  // Each path is compared to all thresholds, the classified paths keep the order of the
+  // measured paths
+  for (const auto &[observerId, bitPaths] : measurements.paths)
+  {
+    for (const auto &[bit, mpv] : bitPaths)
+    {
+      std::vector<ClassPathVec *> cpvs;
+      for (auto &cps : sets)
+        cpvs.push_back(&cps.m_classifiedPaths[observerId][bit]);
+
+      for (const auto &mlp : mpv)
+      {
+        for (size_t i = 0; i < thresholds.size(); i++)
+        {
+          auto clp = ClassifyPath(mlp, measurements.classificationMode, thresholds[i],
+                                  smallFailFactor, largeFailFactor);
+          if (clp.has_value())
+            cpvs[i]->push_back(std::move(*clp));
+        }
+      }
+    }
+  }
+  return sets;
+}
+
+std::optional<ClassifiedLinkPath> ClassifiedPathSet::ClassifyPath(
+    const MeasuredLinkPath &mlp, ClassificationMode classificationMode,
+    const ClassificationThresholds &thresholds, double smallFailFactor, double largeFailFactor)
+{
+  double threshold = mlp.isLoss ? thresholds.lossRateTh : thresholds.delayTh;
+
+  ClassifiedLinkPath clp;
+  clp.path = mlp.path;
+  clp.measurement = mlp.measurement;
+  if (classificationMode == ClassificationMode::PERFECT)
+  {
+    clp.failed = clp.medium_failure = mlp.value >= threshold;
+    clp.small_failure = false;
+    clp.large_failure = false;
+    return clp;
+  }
+
+  clp.failed = clp.medium_failure = mlp.hasValue && mlp.value >= threshold;
+  clp.small_failure = mlp.hasValue && mlp.value >= threshold * smallFailFactor;
+  clp.large_failure = mlp.hasValue && mlp.value >= threshold * largeFailFactor;
+  // Only add paths that are long enough or failed
+  if (!mlp.keep && !clp.small_failure)
+    return std::nullopt;
+  return clp;
+}
+
+void ClassifiedPathSet::MeasureActivePaths(const simdata::SimResultSet &srs,
+                                           PathMeasurementSet &measurements,
+                                           const std::set<uint32_t> &observerIds,
+                                           const EfmBitSet &bitCombis)
 {
   EfmBitSet filteredBits;
   for (auto &bit : bitCombis)
@@ -187,6 +278,33 @@ void ClassifiedPathSet::HandleActiveMeasurements(const simdata::SimResultSet &sr
       filteredBits.insert(bit);
   }
 
+  // Pings are always kept, a ping without delay samples is never failed
+  auto measurePing = [&](const LinkPath &path, const simdata::SimPingPair &pp, EfmBit bit) {
+    MeasuredLinkPath mlp{path, true, 0.0, true, 0.0, true};
+    if (bit == EfmBit::PINGLSS)
+    {
+      mlp.isLoss = true;
+      if (measurements.classificationMode == ClassificationMode::STATIC)
+        mlp.value = mlp.measurement = pp.GetRelativeLoss();
+    }
+    else if (bit == EfmBit::PINGDLY)
+    {
+      mlp.isLoss = false;
+      if (measurements.classificationMode == ClassificationMode::STATIC)
+      {
+        mlp.hasValue = pp.GetAvgDelay().has_value();
+        mlp.value = mlp.measurement = pp.GetAvgDelay().value_or(0);
+      }
+    }
+    else
+    {
+      throw std::runtime_error("Unknown active measurement bit.");
+    }
+    if (measurements.classificationMode == ClassificationMode::PERFECT)
+      mlp.value = GetLinkPathGroundTruth(srs, path, mlp.isLoss);
+    return mlp;
+  };
+
   for (auto oid : observerIds)
   {
     auto &clientpp = srs.GetObserverVP(oid)->GetClientPingPairs();
@@ -203,46 +321,7 @@ void ClassifiedPathSet::HandleActiveMeasurements(const simdata::SimResultSet &sr
 
       LinkPath rtPath = _lp.value().Append(_lp2.value());
       for (auto &bit : filteredBits)
-      {
-        ClassifiedLinkPath clp;
-        clp.path = rtPath;
-
-        if (bit == EfmBit::PINGLSS)
-        {
-          if (classificationMode == ClassificationMode::STATIC){
-            clp.failed = clp.medium_failure = pp->GetRelativeLoss() >= lossRateTh;
-            clp.small_failure = pp->GetRelativeLoss() >= smallFailFactor * lossRateTh;
-            clp.large_failure = pp->GetRelativeLoss() >= largeFailFactor * lossRateTh;
-            clp.measurement = pp->GetRelativeLoss();
-          }
-          else if (classificationMode == ClassificationMode::PERFECT){
-            clp.failed = clp.medium_failure = ClassifyLinkPathViaGT(srs, clp.path, true, false);
-            clp.small_failure = false;
-            clp.large_failure = false;
-            clp.measurement = 0.0;
-          }
-        }
-        else if (bit == EfmBit::PINGDLY)
-        {
-          if (classificationMode == ClassificationMode::STATIC){
-            clp.failed = clp.medium_failure = pp->GetAvgDelay() >= delayTh;
-            clp.small_failure = pp->GetAvgDelay() >= smallFailFactor * delayTh;
-            clp.large_failure = pp->GetAvgDelay() >= largeFailFactor * delayTh;
-            clp.measurement = pp->GetAvgDelay().value_or(0);
-          }
-          else if (classificationMode == ClassificationMode::PERFECT){
-            clp.failed = clp.medium_failure = ClassifyLinkPathViaGT(srs, clp.path, false, true);
-            clp.small_failure = false;
-            clp.large_failure = false;
-            clp.measurement = 0.0;
-          }
-        }
-        else
-        {
-          throw std::runtime_error("Unknown active measurement bit.");
-        }
-        m_classifiedPaths[oid][bit].push_back(clp);
-      }
+        measurements.paths[oid][bit].push_back(measurePing(rtPath, *pp, bit));
     }
 
     auto &serverpp = srs.GetObserverVP(oid)->GetServerPingPairs();
@@ -254,46 +333,7 @@ void ClassifiedPathSet::HandleActiveMeasurements(const simdata::SimResultSet &sr
         continue;
       LinkPath etePath = _lp.value();
       for (auto &bit : filteredBits)
-      {
-        ClassifiedLinkPath clp;
-        clp.path = etePath;
-
-        if (bit == EfmBit::PINGLSS)
-        {
-          if (classificationMode == ClassificationMode::STATIC){
-            clp.failed = clp.medium_failure = pp->GetRelativeLoss() >= lossRateTh;
-            clp.small_failure = pp->GetRelativeLoss() >= smallFailFactor * lossRateTh;
-            clp.large_failure = pp->GetRelativeLoss() >= largeFailFactor * lossRateTh;
-            clp.measurement = pp->GetRelativeLoss();
-          }
-          else if (classificationMode == ClassificationMode::PERFECT){
-            clp.failed = clp.medium_failure = ClassifyLinkPathViaGT(srs, clp.path, true, false);
-            clp.small_failure = false;
-            clp.large_failure = false;
-            clp.measurement = 0.0;
-          }
-        }
-        else if (bit == EfmBit::PINGDLY)
-        {
-          if (classificationMode == ClassificationMode::STATIC){
-            clp.failed = clp.medium_failure = pp->GetAvgDelay() >= delayTh;
-            clp.small_failure = pp->GetAvgDelay() >= smallFailFactor * delayTh;
-            clp.large_failure = pp->GetAvgDelay() >= largeFailFactor * delayTh;
-            clp.measurement = pp->GetAvgDelay().value_or(0);
-          }
-          else if (classificationMode == ClassificationMode::PERFECT){
-            clp.failed = clp.medium_failure = ClassifyLinkPathViaGT(srs, clp.path, false, true);
-            clp.small_failure = false;
-            clp.large_failure = false;
-            clp.measurement = 0.0;
-          }
-        }
-        else
-        {
-          throw std::runtime_error("Unknown active measurement bit.");
-        }
-        m_classifiedPaths[oid][bit].push_back(clp);
-      }
+        measurements.paths[oid][bit].push_back(measurePing(etePath, *pp, bit));
     }
   }
 }
@@ -403,7 +443,7 @@ ClassPathVec ClassifiedPathSet::GetClassifiedPaths(const std::set<uint32_t> &obs
 
 LinkPath ClassifiedPathSet::GenerateUnidirBitPaths(uint32_t observerId, EfmBit bits,
                                                    LinkPath &flowPath,
-                                                   LinkPath &reverseFlowPath) const
+                                                   LinkPath &reverseFlowPath)
 {
   switch (bits)
   {
@@ -436,207 +476,85 @@ LinkPath ClassifiedPathSet::GenerateUnidirBitPaths(uint32_t observerId, EfmBit b
   }
 }
 
-void ClassifiedPathSet::HandleBidirBitPathClassification(
-    const simdata::SimResultSet &srs, const simdata::ObsvVantagePointPointer &observer, EfmBit bits,
-    uint32_t flowId, uint32_t reverseFlowId, LinkPath &flowPath, LinkPath &reverseFlowPath, double smallFailFactor, double largeFailFactor, double time_filter)
+void ClassifiedPathSet::MeasureBidirBitPaths(
+    const simdata::SimResultSet &srs, PathMeasurementSet &measurements,
+    const simdata::ObsvVantagePointPointer &observer, EfmBit bits, uint32_t flowId,
+    uint32_t reverseFlowId, LinkPath &flowPath, LinkPath &reverseFlowPath, double time_filter)
 {
   uint32_t observerId = observer->m_nodeId;
   simdata::SimObsvFlowPointer flow = observer->GetFlow(flowId);
   simdata::SimObsvFlowPointer reverseFlow = observer->GetFlow(reverseFlowId);
+  bool isStatic = measurements.classificationMode == ClassificationMode::STATIC;
+  bool longEnough = srs.GetFlowStats(observerId, flowId).totalPackets >= measurements.flowLengthTh;
 
   // Important to generate at least an empty vector, even if no paths are generated
   // so we can later differentiate between invalid observer/bit combinations and
   // combinations that just yielded no paths
-  ClassPathVec &cpv = m_classifiedPaths[observerId][bits];
+  std::vector<MeasuredLinkPath> &mpv = measurements.paths[observerId][bits];
+
+  // Only called with the measurement in STATIC mode, which is ignored if it is faulty (negative
+  // loss/delay cant exist)
+  auto addPath = [&](const LinkPath &path, bool isLoss, double measurement) {
+    if (!isStatic)
+      mpv.push_back(MeasuredLinkPath{path, isLoss, GetLinkPathGroundTruth(srs, path, isLoss),
+                                     true, 0.0, true});
+    else if (measurement >= 0.0)
+      mpv.push_back(MeasuredLinkPath{path, isLoss, measurement, true, measurement, longEnough});
+  };
 
   switch (bits)
   {
     case EfmBit::T:
     {
       // Compute half-RT loss (O-C-O or O-S-O)
-      ClassifiedLinkPath clp;
       // The half measurement for a C-S flow contains the O-C-O loss and vice versa
-      clp.path =
+      LinkPath path =
           reverseFlowPath.GetPathFromXToEnd(observerId).Append(flowPath.GetUpToX(observerId));
-
-      if (m_config.classificationMode == ClassificationMode::STATIC)
-      {
-        double loss = flow->GetRelativeTBitHalfLoss();
-        FailureStruct failed = FailureStruct{loss >= m_config.lossRateTh,
-                                             loss >= m_config.lossRateTh * smallFailFactor,
-                                             loss >= m_config.lossRateTh * largeFailFactor, loss};
-        // Only add paths that are long enough or failed and ignore faulty measurements (negative
-        // loss/delay cant exist)
-        if ((failed.small_failure ||
-             srs.GetFlowStats(observerId, flowId).totalPackets >= m_config.flowLengthTh) &&
-            failed.measurement >= 0.0)
-        {
-          clp.failed = clp.medium_failure = failed.failed_and_medium_failure;
-          clp.small_failure = failed.small_failure;
-          clp.large_failure = failed.large_failure;
-          clp.measurement = failed.measurement;
-          cpv.push_back(clp);
-        }
-      }
-      else if (m_config.classificationMode == ClassificationMode::PERFECT)
-      {
-        clp.failed = clp.medium_failure = ClassifyLinkPathViaGT(srs, clp.path, true, false);
-        clp.small_failure = false;
-        clp.large_failure = false;
-        clp.measurement = 0.0;
-        cpv.push_back(clp);
-      }
+      addPath(path, true, isStatic ? flow->GetRelativeTBitHalfLoss() : 0.0);
       break;
     }
     case EfmBit::SPIN:
     {
       // Compute end-to-end delay
-      ClassifiedLinkPath clp;
-      clp.path =
+      LinkPath path =
           reverseFlowPath.GetPathFromXToEnd(observerId).Append(flowPath.GetUpToX(observerId));
-
-      if (m_config.classificationMode == ClassificationMode::STATIC)
-      {
-        // TODO: Rethink threshold choice
-        double delay = flow->GetAvgSpinEtEDelay(time_filter).value_or(0);
-        FailureStruct failed =
-            FailureStruct{delay >= m_config.delayTh, delay >= m_config.delayTh * smallFailFactor,
-                          delay >= m_config.delayTh * largeFailFactor, delay};
-        // Only add paths that are long enough or failed and ignore faulty measurements (negative
-        // loss/delay cant exist)
-        if ((failed.small_failure ||
-             srs.GetFlowStats(observerId, flowId).totalPackets >= m_config.flowLengthTh) &&
-            failed.measurement >= 0.0)
-        {
-          clp.failed = clp.medium_failure = failed.failed_and_medium_failure;
-          clp.small_failure = failed.small_failure;
-          clp.large_failure = failed.large_failure;
-          clp.measurement = failed.measurement;
-          cpv.push_back(clp);
-        }
-      }
-      else if (m_config.classificationMode == ClassificationMode::PERFECT)
-      {
-        clp.failed = clp.medium_failure = ClassifyLinkPathViaGT(srs, clp.path, false, true);
-        clp.small_failure = false;
-        clp.large_failure = false;
-        clp.measurement = 0.0;
-        cpv.push_back(clp);
-      }
-
+      // TODO: Rethink threshold choice
+      addPath(path, false, isStatic ? flow->GetAvgSpinEtEDelay(time_filter).value_or(0) : 0.0);
       break;
     }
     case EfmBit::QR:
     {
       // Compute downstream loss
-      ClassifiedLinkPath clp;
-      clp.path = flowPath.GetPathFromXToEnd(observerId);
-      double uloss = flow->GetRelativeQBitLoss();
-      double ulossRev = reverseFlow->GetRelativeQBitLoss();
-      double tqlossRev = reverseFlow->GetRelativeRBitLoss();
-      double dsl = (((tqlossRev - ulossRev) / (1 - ulossRev)) - uloss) / (1 - uloss);
-
-      if (m_config.classificationMode == ClassificationMode::STATIC)
-      {
-        FailureStruct failed =
-            FailureStruct{dsl >= m_config.lossRateTh, dsl >= m_config.lossRateTh * smallFailFactor,
-                          dsl >= m_config.lossRateTh * largeFailFactor, dsl};
-        // Only add paths that are long enough or failed and ignore faulty measurements (negative
-        // loss/delay cant exist)
-        if ((failed.small_failure ||
-             srs.GetFlowStats(observerId, flowId).totalPackets >= m_config.flowLengthTh) &&
-            failed.measurement >= 0.0)
-        {
-          clp.failed = clp.medium_failure = failed.failed_and_medium_failure;
-          clp.small_failure = failed.small_failure;
-          clp.large_failure = failed.large_failure;
-          clp.measurement = failed.measurement;
-          cpv.push_back(clp);
-        }
-      }
-      else if (m_config.classificationMode == ClassificationMode::PERFECT)
+      LinkPath path = flowPath.GetPathFromXToEnd(observerId);
+      double dsl = 0.0;
+      double ulossRev = 0.0;
+      if (isStatic)
       {
-        clp.failed = clp.medium_failure = ClassifyLinkPathViaGT(srs, clp.path, true, false);
-        clp.small_failure = false;
-        clp.large_failure = false;
-        clp.measurement = 0.0;
-        cpv.push_back(clp);
+        double uloss = flow->GetRelativeQBitLoss();
+        ulossRev = reverseFlow->GetRelativeQBitLoss();
+        double tqlossRev = reverseFlow->GetRelativeRBitLoss();
+        dsl = (((tqlossRev - ulossRev) / (1 - ulossRev)) - uloss) / (1 - uloss);
       }
-
+      addPath(path, true, dsl);
 
       // Compute half RT loss
-      ClassifiedLinkPath clp2;
       // We only compute the O-X-O loss here for our X-Y flow, the O-Y-O loss is handled by the
       // computation for the reverse flow
-      clp2.path =
+      LinkPath path2 =
           reverseFlowPath.GetPathFromXToEnd(observerId).Append(flowPath.GetUpToX(observerId));
-
-      if (m_config.classificationMode == ClassificationMode::STATIC)
-      {
-        double loss = ((flow->GetRelativeRBitLoss() - ulossRev) / (1 - ulossRev));
-        FailureStruct failed = FailureStruct{loss >= m_config.lossRateTh,
-                                             loss >= m_config.lossRateTh * smallFailFactor,
-                                             loss >= m_config.lossRateTh * largeFailFactor, loss};
-
-        // Only add paths that are long enough or failed and ignore faulty measurements (negative
-        // loss/delay cant exist)
-        if ((failed.small_failure ||
-             srs.GetFlowStats(observerId, flowId).totalPackets >= m_config.flowLengthTh) &&
-            failed.measurement >= 0.0)
-        {
-          clp2.failed = clp2.medium_failure = failed.failed_and_medium_failure;
-          clp2.small_failure = failed.small_failure;
-          clp2.large_failure = failed.large_failure;
-          clp2.measurement = failed.measurement;
-          cpv.push_back(clp2);
-        }
-      }
-      else if (m_config.classificationMode == ClassificationMode::PERFECT)
-      {
-        clp2.failed = clp2.medium_failure = ClassifyLinkPathViaGT(srs, clp2.path, true, false);
-        clp2.small_failure = false;
-        clp2.large_failure = false;
-        clp2.measurement = 0.0;
-        cpv.push_back(clp2);
-      }
-
+      addPath(path2, true,
+              isStatic ? ((flow->GetRelativeRBitLoss() - ulossRev) / (1 - ulossRev)) : 0.0);
       break;
     }
     case EfmBit::QT:
     {
-      ClassifiedLinkPath clp;
-      clp.path = flowPath.GetPathFromXToEnd(observerId).Append(reverseFlowPath);
-
-      if (m_config.classificationMode == ClassificationMode::STATIC)
-      {
-        // Compute downstream loss using Tbit-half-loss
-        double loss = ((reverseFlow->GetRelativeTBitHalfLoss() - reverseFlow->GetRelativeQBitLoss()) /
-             (1 - reverseFlow->GetRelativeQBitLoss()));
-        FailureStruct failed = FailureStruct{loss >= m_config.lossRateTh,
-                                             loss >= m_config.lossRateTh * smallFailFactor,
-                                             loss >= m_config.lossRateTh * largeFailFactor, loss};
-        // Only add paths that are long enough or failed and ignore faulty measurements (negative
-        // loss/delay cant exist)
-        if ((failed.small_failure ||
-             srs.GetFlowStats(observerId, flowId).totalPackets >= m_config.flowLengthTh) &&
-            failed.measurement >= 0.0)
-        {
-          clp.failed = clp.medium_failure = failed.failed_and_medium_failure;
-          clp.small_failure = failed.small_failure;
-          clp.large_failure = failed.large_failure;
-          clp.measurement = failed.measurement;
-          cpv.push_back(clp);
-        }
-      }
-      else if (m_config.classificationMode == ClassificationMode::PERFECT)
-      {
-        clp.failed = clp.medium_failure = ClassifyLinkPathViaGT(srs, clp.path, true, false);
-        clp.small_failure = false;
-        clp.large_failure = false;
-        clp.measurement = 0.0;
-        cpv.push_back(clp);
-      }
-
+      LinkPath path = flowPath.GetPathFromXToEnd(observerId).Append(reverseFlowPath);
+      // Compute downstream loss using Tbit-half-loss
+      double loss = 0.0;
+      if (isStatic)
+        loss = ((reverseFlow->GetRelativeTBitHalfLoss() - reverseFlow->GetRelativeQBitLoss()) /
+                (1 - reverseFlow->GetRelativeQBitLoss()));
+      addPath(path, true, loss);
       break;
     }
     default:
@@ -644,144 +562,79 @@ void ClassifiedPathSet::HandleBidirBitPathClassification(
   }
 }
 
-FailureStruct ClassifiedPathSet::ClassifyFlow(const simdata::ObsvVantagePointPointer &observer,
-                                     uint32_t flowId, EfmBit bits, double smallFailFactor, double largeFailFactor, double time_filter)
+double ClassifiedPathSet::MeasureFlow(const simdata::ObsvVantagePointPointer &observer,
+                                      uint32_t flowId, EfmBit bits, double time_filter)
 {
   simdata::SimObsvFlowPointer flow = observer->GetFlow(flowId);
   switch (bits)
   {
     case EfmBit::SEQ:
-    {
-      double loss = flow->GetRelativeSeqLoss();
-      return FailureStruct{loss >= m_config.lossRateTh,
-                           loss >= m_config.lossRateTh * smallFailFactor,
-                           loss >= m_config.lossRateTh * largeFailFactor, loss};
-      break;
-    }
+      return flow->GetRelativeSeqLoss();
     case EfmBit::Q:
-    {
-      double loss = flow->GetRelativeQBitLoss();
-      return FailureStruct{loss >= m_config.lossRateTh,
-                           loss >= m_config.lossRateTh * smallFailFactor,
-                           loss >= m_config.lossRateTh * largeFailFactor, loss};
-      break;
-    }
+      return flow->GetRelativeQBitLoss();
     case EfmBit::L:
-    {
-      double loss = flow->GetRelativeLBitLoss();
-      return FailureStruct{loss >= m_config.lossRateTh,
-                           loss >= m_config.lossRateTh * smallFailFactor,
-                           loss >= m_config.lossRateTh * largeFailFactor, loss};
-      break;
-    }
+      return flow->GetRelativeLBitLoss();
     case EfmBit::T:
-    {
-      double loss = flow->GetRelativeTBitFullLoss();
-      return FailureStruct{loss >= m_config.lossRateTh,
-                           loss >= m_config.lossRateTh * smallFailFactor,
-                           loss >= m_config.lossRateTh * largeFailFactor, loss};
-      break;
-    }
+      return flow->GetRelativeTBitFullLoss();
     case EfmBit::R:
-    {
-      double loss = flow->GetRelativeRBitLoss();
-      return FailureStruct{loss >= m_config.lossRateTh,
-                           loss >= m_config.lossRateTh * smallFailFactor,
-                           loss >= m_config.lossRateTh * largeFailFactor, loss};
-      break;
-    }
+      return flow->GetRelativeRBitLoss();
     case EfmBit::SPIN:
-    {
-      double delay = flow->GetAvgSpinRTDelay(time_filter).value_or(0);
-      return FailureStruct{delay >= m_config.delayTh, delay >= m_config.delayTh * smallFailFactor,
-                           delay >= m_config.delayTh * largeFailFactor, delay};
-      break;
-    }
+      return flow->GetAvgSpinRTDelay(time_filter).value_or(0);
     case EfmBit::QL:
     {
       double uloss = flow->GetRelativeQBitLoss();
       // TODO: Consider loss rate adaption (e.g., increase end-to-end loss if less than upstream
       // loss; depends on type of flow (ACK dominated, ...))
-      double loss = (flow->GetRelativeLBitLoss() - uloss) / (1 - uloss); // Based on EFM draft
-      return FailureStruct{loss >= m_config.lossRateTh,
-                           loss >= m_config.lossRateTh * smallFailFactor,
-                           loss >= m_config.lossRateTh * largeFailFactor, loss};
-      break;
+      return (flow->GetRelativeLBitLoss() - uloss) / (1 - uloss); // Based on EFM draft
     }
     case EfmBit::QR:
     {
       double uloss = flow->GetRelativeQBitLoss();
-      double loss = (flow->GetRelativeRBitLoss() - uloss) / (1 - uloss); // Based on EFM draft
-      return FailureStruct{loss >= m_config.lossRateTh,
-                           loss >= m_config.lossRateTh * smallFailFactor,
-                           loss >= m_config.lossRateTh * largeFailFactor, loss};
-      break;
+      return (flow->GetRelativeRBitLoss() - uloss) / (1 - uloss); // Based on EFM draft
     }
     case EfmBit::QT:
     {
       double uloss = flow->GetRelativeQBitLoss();
-      double loss = (flow->GetRelativeTBitFullLoss() - uloss) / (1 - uloss); // Based on EFM draft
-      return FailureStruct{loss >= m_config.lossRateTh,
-                           loss >= m_config.lossRateTh * smallFailFactor,
-                           loss >= m_config.lossRateTh * largeFailFactor, loss};
-      break;
+      return (flow->GetRelativeTBitFullLoss() - uloss) / (1 - uloss); // Based on EFM draft
     }
     case EfmBit::LT:
     {
       double eloss = flow->GetRelativeLBitLoss();
-      double loss = (flow->GetRelativeTBitFullLoss() - eloss) / (1 - eloss); // Based on EFM draft
-      return FailureStruct{loss >= m_config.lossRateTh,
-                           loss >= m_config.lossRateTh * smallFailFactor,
-                           loss >= m_config.lossRateTh * largeFailFactor, loss};
-      break;
+      return (flow->GetRelativeTBitFullLoss() - eloss) / (1 - eloss); // Based on EFM draft
     }
     case EfmBit::TCPRO:
-    {
-      double loss = flow->GetRelativeTcpReordering();
-      return FailureStruct{loss >= m_config.lossRateTh,
-                           loss >= m_config.lossRateTh * smallFailFactor,
-                           loss >= m_config.lossRateTh * largeFailFactor, loss};
-      break;
-    }
+      return flow->GetRelativeTcpReordering();
     case EfmBit::TCPDART:
-    {
-      double delay = flow->GetAvgTcpHRTDelay().value_or(0);
-      return FailureStruct{delay >= m_config.delayTh, delay >= m_config.delayTh * smallFailFactor,
-                           delay >= m_config.delayTh * largeFailFactor, delay};
-      break;
-    }
+      return flow->GetAvgTcpHRTDelay().value_or(0);
     default:
       throw std::runtime_error("Should never happen.");
-      break;
   }
-  return FailureStruct{false, false, false, 0.0};
 }
 
-bool ClassifiedPathSet::ClassifyLinkPathViaGT(const simdata::SimResultSet &srs,
-                                              const LinkPath &path, bool useLoss,
-                                              bool useDelay) const
+double ClassifiedPathSet::GetLinkPathGroundTruth(const simdata::SimResultSet &srs,
+                                                 const LinkPath &path, bool useLoss)
 {
+  // A path is failed if one of its links is, i.e., if the highest value reaches the threshold
+  double value = -std::numeric_limits<double>::infinity();
   for (auto &link : path.links)
   {
     std::optional<simdata::FailedLink> fl = srs.GetFailedLink(link.first, link.second);
     if (!fl.has_value())
       continue;
 
-    if (useLoss && fl->lossRate >= m_config.lossRateTh)
-      return true;
-    if (useDelay && fl->delayMs >= m_config.delayTh)
-      return true;
+    value = std::max(value, useLoss ? fl->lossRate : static_cast<double>(fl->delayMs));
   }
-  return false;
+  return value;
 }
 
 //----- Helper functions -----
 
-std::optional<LinkPath> GenerateLinkPath(std::vector<simdata::ObsvVantagePointPointer> flowPath)
+std::optional<LinkPath> GenerateLinkPath(
+    const std::vector<simdata::ObsvVantagePointPointer> &flowPath)
 {
   if (flowPath.size() < 2)
   {
-    std::cout << "Warning: Flow path too short." << std::endl;
+    LogLine(std::cout, "Warning: Flow path too short.");
     return std::nullopt;
   }
   LinkPath p;
@@ -792,11 +645,11 @@ std::optional<LinkPath> GenerateLinkPath(std::vector<simdata::ObsvVantagePointPo
   return p;
 }
 
-std::optional<LinkPath> GenerateLinkPath(std::vector<uint32_t> flowPath)
+std::optional<LinkPath> GenerateLinkPath(const std::vector<uint32_t> &flowPath)
 {
   if (flowPath.size() < 2)
   {
-    std::cout << "Warning: Flow path too short." << std::endl;
+    LogLine(std::cout, "Warning: Flow path too short.");
     return std::nullopt;
   }
 
@@ -808,6 +661,26 @@ std::optional<LinkPath> GenerateLinkPath(std::vector<uint32_t> flowPath)
   return p;
 }
 
+std::optional<LinkPath> GenerateLinkPath(const simdata::SimResultSet::FlowPath &flowPath)
+{
+  if (flowPath.observerIds.size() < 2)
+  {
+    LogLine(std::cout, "Warning: Flow path too short.");
+    return std::nullopt;
+  }
+
+  LinkPath p;
+  p.links = flowPath.links;
+  return p;
+}
+
+bool IsFlowSelected(const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
+                    uint32_t observerId, uint32_t flowId)
+{
+  auto it = flowSelectionMap.find(observerId);
+  return it != flowSelectionMap.end() && it->second.count(flowId) > 0;
+}
+
 bool IsLossBit(EfmBit bit)
 {
   switch (bit)
@@ -8,14 +8,6 @@
 
 namespace analysis {
 
-struct FailureStruct
-{
-    bool failed_and_medium_failure;
-    bool small_failure;
-    bool large_failure;
-    double measurement;
-};
-
 struct ObserverSet
 {
   std::set<uint32_t> observers{};
@@ -118,6 +110,42 @@ struct ClassifiedLinkPath
   double measurement;
 };
 
+// A flow or ping path before classification, it is classified by comparing its value to the loss
+// rate or delay threshold
+struct MeasuredLinkPath
+{
+  LinkPath path;
+  // Whether the value is compared to the loss rate or to the delay threshold
+  bool isLoss;
+  // The measurement, in PERFECT mode the highest ground truth loss rate/delay of the failed links
+  // on the path (-inf if there are none)
+  double value;
+  // Pings without delay samples are never failed
+  bool hasValue;
+  // The measurement of the classified path (0 in PERFECT mode)
+  double measurement;
+  // Whether the path is kept if it is not even a small failure (flows that are long enough, pings,
+  // all paths in PERFECT mode)
+  bool keep;
+};
+
+/// @brief The measured paths of a set of observers, flows and bits, which can be classified for
+/// any number of thresholds (see ClassifiedPathSet::Classify)
+struct PathMeasurementSet
+{
+  std::set<uint32_t> observerIds;
+  std::set<uint32_t> flowIds;
+  uint32_t flowLengthTh;
+  ClassificationMode classificationMode;
+  std::map<uint32_t, std::map<EfmBit, std::vector<MeasuredLinkPath>>> paths;
+};
+
+struct ClassificationThresholds
+{
+  double lossRateTh;
+  uint32_t delayTh;
+};
+
 class ClassifiedPathSet
 {
 public:
@@ -148,7 +176,7 @@ public:
   /// @param classificationMode The classification mode to use
   static ClassifiedPathSet ClassifyAll(const simdata::SimResultSet &srs,
                                        const std::set<uint32_t> &observerIds,
-                                       const std::map<uint32_t, std::set<uint32_t>> flowSelectionMap,
+                                       const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
                                        const EfmBitSet &bitCombis, double lossRateTh,
                                        uint32_t delayTh, uint32_t flowLengthTh, 
                                        ClassificationMode classificationMode,
@@ -168,7 +196,7 @@ public:
   static ClassifiedPathSet Classify(const simdata::SimResultSet &srs,
                                     const std::set<uint32_t> &observerIds,
                                     const std::set<uint32_t> &flowIds, 
-                                    std::map<uint32_t, std::set<uint32_t>> flowSelectionMap,
+                                    const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
                                     const EfmBitSet &bitCombis,
                                     double lossRateTh, uint32_t delayTh, uint32_t flowLengthTh,
                                     ClassificationMode classificationMode,
@@ -177,14 +205,31 @@ public:
                                     double largeFailFactor,
                                     double time_filter);
 
+  /// @brief Generates the paths of the specified observers and all their flows with their
+  /// measurements, without classifying them
+  /// @param flowLengthTh The flow length threshold, flows shorter than this are only kept as failed
+  /// paths
+  static PathMeasurementSet MeasureAll(const simdata::SimResultSet &srs,
+                                       const std::set<uint32_t> &observerIds,
+                                       const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
+                                       const EfmBitSet &bitCombis, uint32_t flowLengthTh,
+                                       ClassificationMode classificationMode, double time_filter);
 
-  void HandleActiveMeasurements(const simdata::SimResultSet &srs,
-                                const std::set<uint32_t> &observerIds, const EfmBitSet &bitCombis,
-                                double lossRateTh, uint32_t delayTh,
-                                ClassificationMode classificationMode,
-                                std::string classification_base_id,
-                                double smallFailFactor,
-                                double largeFailFactor);
+  /// @brief Generates the paths of the specified observers and flows with their measurements,
+  /// without classifying them
+  static PathMeasurementSet Measure(const simdata::SimResultSet &srs,
+                                    const std::set<uint32_t> &observerIds,
+                                    const std::set<uint32_t> &flowIds,
+                                    const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
+                                    const EfmBitSet &bitCombis, uint32_t flowLengthTh,
+                                    ClassificationMode classificationMode, double time_filter);
+
+  /// @brief Classifies measured paths for several thresholds in one pass over the paths
+  /// @return One classified path set per thresholds, in the same order
+  static std::vector<ClassifiedPathSet> Classify(
+      const PathMeasurementSet &measurements,
+      const std::vector<ClassificationThresholds> &thresholds,
+      std::string classification_base_id, double smallFailFactor, double largeFailFactor);
 
   /// @brief Returns the classified paths for the specified observer and bit/bit combination
   /// @param bits A single bit or bit combi, e.g., T, QR, ...
@@ -211,32 +256,46 @@ private:
   // Generates bit paths for specified observer, flow and bits
   // For a bit combi, only the path resulting from the combination (not from the single bits) are
   // generated E.g., QL only generates the downstream loss path
-  LinkPath GenerateUnidirBitPaths(uint32_t observerId, EfmBit bits, LinkPath &flowPath,
-                                  LinkPath &reverseFlowPath) const;
-
-
-  // Generates and stores classified bit paths for bit measurements that require a bidirectional
-  // observer
-  void HandleBidirBitPathClassification(const simdata::SimResultSet &srs,
-                                        const simdata::ObsvVantagePointPointer &observer,
-                                        EfmBit bits, uint32_t flowId, uint32_t reverseFlowId,
-                                        LinkPath &flowPath, LinkPath &reverseFlowPath,
-                                        double smallFailFactor,
-                                        double largeFailFactor,
-                                        double time_filter);
-
-  FailureStruct ClassifyFlow(const simdata::ObsvVantagePointPointer &observer, uint32_t flowId, EfmBit bits,
-                                double smallFailFactor,
-                                double largeFailFactor,
-                                double time_filter);
-
-  bool ClassifyLinkPathViaGT(const simdata::SimResultSet &srs, const LinkPath &path, bool useLoss,
-                             bool useDelay) const;
+  static LinkPath GenerateUnidirBitPaths(uint32_t observerId, EfmBit bits, LinkPath &flowPath,
+                                         LinkPath &reverseFlowPath);
+
+
+  // Generates and measures bit paths for bit measurements that require a bidirectional observer
+  static void MeasureBidirBitPaths(const simdata::SimResultSet &srs,
+                                   PathMeasurementSet &measurements,
+                                   const simdata::ObsvVantagePointPointer &observer, EfmBit bits,
+                                   uint32_t flowId, uint32_t reverseFlowId, LinkPath &flowPath,
+                                   LinkPath &reverseFlowPath, double time_filter);
+
+  // Generates and measures the paths of the ping pairs of the observers
+  static void MeasureActivePaths(const simdata::SimResultSet &srs,
+                                 PathMeasurementSet &measurements,
+                                 const std::set<uint32_t> &observerIds,
+                                 const EfmBitSet &bitCombis);
+
+  static double MeasureFlow(const simdata::ObsvVantagePointPointer &observer, uint32_t flowId,
+                            EfmBit bits, double time_filter);
+
+  // Highest loss rate or delay of the failed links on the path according to the ground truth
+  static double GetLinkPathGroundTruth(const simdata::SimResultSet &srs, const LinkPath &path,
+                                       bool useLoss);
+
+  // Classifies a measured path, std::nullopt if the path is not kept for the thresholds
+  static std::optional<ClassifiedLinkPath> ClassifyPath(const MeasuredLinkPath &mlp,
+                                                        ClassificationMode classificationMode,
+                                                        const ClassificationThresholds &thresholds,
+                                                        double smallFailFactor,
+                                                        double largeFailFactor);
 };
 
 
-std::optional<LinkPath> GenerateLinkPath(std::vector<simdata::ObsvVantagePointPointer> flowPath);
-std::optional<LinkPath> GenerateLinkPath(std::vector<uint32_t> flowPath);
+std::optional<LinkPath> GenerateLinkPath(
+    const std::vector<simdata::ObsvVantagePointPointer> &flowPath);
+std::optional<LinkPath> GenerateLinkPath(const std::vector<uint32_t> &flowPath);
+std::optional<LinkPath> GenerateLinkPath(const simdata::SimResultSet::FlowPath &flowPath);
+// Whether a flow is selected for an observer (without inserting the observer into the map)
+bool IsFlowSelected(const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
+                    uint32_t observerId, uint32_t flowId);
 bool IsLossBit(EfmBit bit);
 bool AreLossBits(EfmBitSet bits);
 bool AreSingleCombinationBit(EfmBitSet bits);
@@ -1,4 +1,5 @@
 #include "combined-flow-set.h"
+#include <helper-templates.h>
 
 #include "iostream"
 #include "sim-ping-pair.h"
@@ -51,7 +52,7 @@ std::string ConnectivityVectorToStringWithLinkMapping(ConnectivityVector vector,
 
 CombinedFlowSet CombinedFlowSet::CharacterizeAll(const simdata::SimResultSet &srs,
                                                             const std::set<uint32_t> &observerIds,
-                                                            const std::map<uint32_t, std::set<uint32_t>> flowSelectionMap,
+                                                            const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
                                                             const EfmBitSet &bitCombis, 
                                                             uint32_t flowLengthTh,
                                                             ClassificationMode classificationMode,
@@ -110,7 +111,7 @@ CombinedFlowSet CombinedFlowSet::CharacterizeAll(const simdata::SimResultSet &sr
   std::set<uint32_t> flowIds;
   for (auto &oid : observerIds)
   {
-    auto fids = srs.GetObserverFlowIds(oid);
+    const auto &fids = srs.GetObserverFlowIds(oid);
     flowIds.insert(fids.begin(), fids.end());
   }
   return Characterize(srs, observerIds, flowIds, flowSelectionMap, bitCombis, link_index_map, reverse_link_index_map, flowLengthTh, classification_base_id, time_filter);
@@ -119,7 +120,7 @@ CombinedFlowSet CombinedFlowSet::CharacterizeAll(const simdata::SimResultSet &sr
 CombinedFlowSet CombinedFlowSet::Characterize(const simdata::SimResultSet &srs,
                                               const std::set<uint32_t> &observerIds,
                                               const std::set<uint32_t> &flowIds,
-                                              std::map<uint32_t, std::set<uint32_t>> flowSelectionMap,
+                                              const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
                                               const EfmBitSet &bitCombis, 
                                               const LinkIndexMap link_index_map, 
                                               const ReverseLinkIndexMap reverse_link_index_map, 
@@ -144,13 +145,13 @@ CombinedFlowSet CombinedFlowSet::Characterize(const simdata::SimResultSet &srs,
     // Calculate (reverse) flow path as sequence of observers and corresponding link path as
     // sequence of links
     std::vector<simdata::ObsvVantagePointPointer> fp = srs.CalculateFlowPath(fid);
-    auto _lp = GenerateLinkPath(fp);
+    auto _lp = GenerateLinkPath(srs.GetFlowPath(fid));
     if (!_lp.has_value())
         continue;
     LinkPath lp = _lp.value();
     uint32_t reverseFid = srs.GetReverseFlowId(fid);
     std::vector<simdata::ObsvVantagePointPointer> reverseFp = srs.CalculateFlowPath(reverseFid);
-    auto _reverseLp = GenerateLinkPath(reverseFp);
+    auto _reverseLp = GenerateLinkPath(srs.GetFlowPath(reverseFid));
     if (!_reverseLp.has_value())
         continue;
     LinkPath reverseLp = _reverseLp.value();
@@ -181,7 +182,7 @@ CombinedFlowSet CombinedFlowSet::Characterize(const simdata::SimResultSet &srs,
                 // 1. Observer is in the observerSet
                 // 2. Observer has selected the flow
                 // 3. Observer is bidirectional (required by both variants)
-                if (observerIds.find(observerId) != observerIds.end() && flowSelectionMap[observerId].count(fid))
+                if (observerIds.find(observerId) != observerIds.end() && IsFlowSelected(flowSelectionMap, observerId, fid))
                 {
                     LinkPath path = cfs.GeneratePathVisibilityForFlowCombination(observerId, bit, lp, reverseLp);
                     std::pair<uint32_t,uint32_t> _mmnt = cfs.ExtractFlowMeasurementPair(obptr, fid, bit, time_filter);
@@ -250,7 +251,7 @@ CombinedFlowSet CombinedFlowSet::Characterize(const simdata::SimResultSet &srs,
                     // 1. Observer is in the observerSet
                     // 2. Observer has selected the flow
                     // 3. Observer is bidirectional (required by both variants)
-                    if (observerIds.find(observerId) != observerIds.end() && flowSelectionMap[observerId].count(fid) && reverseLp.ContainsNode(observerId))
+                    if (observerIds.find(observerId) != observerIds.end() && IsFlowSelected(flowSelectionMap, observerId, fid) && reverseLp.ContainsNode(observerId))
                     {
                         LinkPath path = cfs.GeneratePathVisibilityForFlowCombination(observerId, bit, lp, reverseLp);
                         double _mmnt = cfs.ExtractFlowMeasurement(obptr, fid, bit, time_filter);
@@ -310,7 +311,7 @@ CombinedFlowSet CombinedFlowSet::Characterize(const simdata::SimResultSet &srs,
                     // 1. Observer is in the observerSet
                     // 2. Observer has selected the flow
                     // 3. Observer is bidirectional (required by both variants)
-                    if (observerIds.find(observerId) != observerIds.end() && flowSelectionMap[observerId].count(reverseFid) && lp.ContainsNode(observerId))
+                    if (observerIds.find(observerId) != observerIds.end() && IsFlowSelected(flowSelectionMap, observerId, reverseFid) && lp.ContainsNode(observerId))
                     {
                         LinkPath path = cfs.GeneratePathVisibilityForFlowCombination(observerId, bit, reverseLp, lp);
                         double _mmnt = cfs.ExtractFlowMeasurement(obptr, reverseFid, bit, time_filter);
@@ -371,9 +372,8 @@ CombinedFlowSet CombinedFlowSet::Characterize(const simdata::SimResultSet &srs,
 
   if (negative_correction_count > 0)
   {
-    std::cout << "Warning: Corrected " + std::to_string(negative_correction_count) +
-                     " negative unidirectional non-active measurements to 0."
-              << std::endl;
+    LogLine(std::cout, "Warning: Corrected " + std::to_string(negative_correction_count) +
+                           " negative unidirectional non-active measurements to 0.");
   }
 
   return cfs;
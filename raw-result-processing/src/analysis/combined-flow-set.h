@@ -59,7 +59,7 @@ public:
   /// @param classificationMode The classification mode to use
   static CombinedFlowSet CharacterizeAll(const simdata::SimResultSet &srs,
                                        const std::set<uint32_t> &observerIds,
-                                       const std::map<uint32_t, std::set<uint32_t>> flowSelectionMap,
+                                       const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
                                        const EfmBitSet &bitCombis,
                                        uint32_t flowLengthTh,
                                        ClassificationMode classificationMode,
@@ -77,7 +77,7 @@ public:
   static CombinedFlowSet Characterize(const simdata::SimResultSet &srs,
                                               const std::set<uint32_t> &observerIds,
                                               const std::set<uint32_t> &flowIds,
-                                              std::map<uint32_t, std::set<uint32_t>> flowSelectionMap,
+                                              const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
                                               const EfmBitSet &bitCombis, 
                                               const LinkIndexMap link_index_map, 
                                               const ReverseLinkIndexMap reverse_link_index_map,
@@ -1,4 +1,7 @@
 #include "failure-localization.h"
+#include "link-weights.h"
+
+#include <helper-templates.h>
 #ifdef USE_GUROBI
 #include "gurobi_c++.h"
 #endif
@@ -35,7 +38,7 @@ std::map<uint32_t, std::set<uint32_t>> SelectFlows(const simdata::SimResultSet &
             if (!flow_combination_required){
                 for (auto &oid : observerSet.observers)
                 {
-                    auto availableFlows = srs.GetObserverFlowIds(oid);
+                    const auto &availableFlows = srs.GetObserverFlowIds(oid);
                     std::set<uint32_t> selectedFlows;
                     std::set<uint32_t> randomNumbers;
                     for (uint32_t count=0; count < selection_strategy.params["flow_count"] && count < availableFlows.size(); count++){  
@@ -70,7 +73,7 @@ std::map<uint32_t, std::set<uint32_t>> SelectFlows(const simdata::SimResultSet &
                     int remaining_required_entries = selection_strategy.params["flow_count"] - selectedFlows.size();
                     //std::cout << std::to_string(oid) << " requires " << std::to_string(remaining_required_entries) << std::endl; 
 
-                    auto availableFlows = srs.GetObserverFlowIds(oid);
+                    const auto &availableFlows = srs.GetObserverFlowIds(oid);
                     for (uint32_t count=0; count < remaining_required_entries && count < availableFlows.size(); count++){  
                         uint32_t randomNumber = getRandomNumber(availableFlows.size());
                         uint32_t selectedFlow = *std::next(availableFlows.begin(), randomNumber);
@@ -113,7 +116,7 @@ std::map<uint32_t, std::set<uint32_t>> SelectFlows(const simdata::SimResultSet &
             std::set<uint32_t> allAvailableFlows;
             for (auto &oid : observerSet.observers)
             {
-                auto fids = srs.GetObserverFlowIds(oid);
+                const auto &fids = srs.GetObserverFlowIds(oid);
                 allAvailableFlows.insert(fids.begin(), fids.end());
             }
 
@@ -123,14 +126,12 @@ std::map<uint32_t, std::set<uint32_t>> SelectFlows(const simdata::SimResultSet &
             {
                 // Calculate (reverse) flow path as sequence of observers and corresponding link path as
                 // sequence of links
-                std::vector<simdata::ObsvVantagePointPointer> fp = srs.CalculateFlowPath(fid);
-                auto _lp = GenerateLinkPath(fp);
+                auto _lp = GenerateLinkPath(srs.GetFlowPath(fid));
                 if (!_lp.has_value())
                 continue;
                 LinkPath lp = _lp.value();
                 uint32_t reverseFid = srs.GetReverseFlowId(fid);
-                std::vector<simdata::ObsvVantagePointPointer> reverseFp = srs.CalculateFlowPath(reverseFid);
-                auto _reverseLp = GenerateLinkPath(reverseFp);
+                auto _reverseLp = GenerateLinkPath(srs.GetFlowPath(reverseFid));
                 if (!_reverseLp.has_value())
                 continue;
                 LinkPath reverseLp = _reverseLp.value();
@@ -154,7 +155,7 @@ std::map<uint32_t, std::set<uint32_t>> SelectFlows(const simdata::SimResultSet &
             {
 
                 std::set<Link> uncovered_links = all_links_set;
-                std::set<uint32_t> observerFlows = srs.GetObserverFlowIds(oid);
+                const std::set<uint32_t> &observerFlows = srs.GetObserverFlowIds(oid);
 
                 std::set<uint32_t> selectedFlows;
 
@@ -281,7 +282,25 @@ FailureLocalization::LocalizeFailures(
     const std::map<LocalizationMethod, LocalizationParams> &locMethods,
     std::string classification_base_id,
     double time_filter,
-    FlowSelectionStrategyWithParams flowSelectionStrategyWithparams)
+    FlowSelectionStrategyWithParams flowSelectionStrategyWithparams,
+    uint32_t numThreads, LocalizationInputCache *inputCache)
+{
+  return LocalizeFailures(srs, observerSets, efmBitSets, {ClassificationThresholds{lossRateTh, delayTh}},
+                          flowLengthTh, classificationMode, locMethods, classification_base_id,
+                          time_filter, flowSelectionStrategyWithparams, numThreads, inputCache);
+}
+
+std::vector<std::pair<ClassificationConfig, std::vector<LocalizationResult>>>
+FailureLocalization::LocalizeFailures(
+    const simdata::SimResultSet &srs, const std::vector<ObserverSet> &observerSets,
+    const std::vector<EfmBitSet> &efmBitSets,
+    const std::vector<ClassificationThresholds> &thresholds,
+    uint32_t flowLengthTh, ClassificationMode classificationMode,
+    const std::map<LocalizationMethod, LocalizationParams> &locMethods,
+    std::string classification_base_id,
+    double time_filter,
+    FlowSelectionStrategyWithParams flowSelectionStrategyWithparams,
+    uint32_t numThreads, LocalizationInputCache *inputCache)
 {
   std::set<EfmBit> joinedBits;
   for (const EfmBitSet &bits : efmBitSets)
@@ -289,13 +308,16 @@ FailureLocalization::LocalizeFailures(
     joinedBits.insert(bits.begin(), bits.end());
   }
 
+  // Only the inputs of the configured methods are built, each once per observer set
+  LocalizationInputMask requiredInputs =
+      PlanLocalizationInputs(locMethods, efmBitSets, classificationMode);
+
   // One map for each observer set
   // The map then includes one map for each observer
   std::map<uint32_t, std::map<uint32_t, std::set<uint32_t>>> selected_flow_ids_per_observer;
   std::map<uint32_t, ObserverSet> observerSetmap;
 
   std::map<uint32_t, std::map<uint32_t, std::set<uint32_t>>> selected_flow_ids_per_observer_flow_combination;
-  std::map<uint32_t, ObserverSet> observerSetmap_flow_combination;
 
   uint32_t observer_set_id = 0;
   for (const auto &observerSet : observerSets)
@@ -305,41 +327,155 @@ FailureLocalization::LocalizeFailures(
     observer_set_id++;
   }
 
+  // The flow combination selection is drawn whenever a fixed flows method is configured, also if
+  // the method is skipped for the mode or bits, so that random selections draw the same numbers
   bool flow_combination_required = false;
   for (const auto &method : locMethods)
-    {
-        if ((method.first == LocalizationMethod::FLOW_COMBINATION_FIXED_FLOWS) ||  (method.first == LocalizationMethod::LIN_LSQR_CORE_ONLY_FIXED_FLOWS) ||   (method.first == LocalizationMethod::LIN_LSQR_FIXED_FLOWS)) {
-            flow_combination_required = true;
-        }
-    }
+  {
+    if ((method.first == LocalizationMethod::FLOW_COMBINATION_FIXED_FLOWS) ||
+        (method.first == LocalizationMethod::LIN_LSQR_CORE_ONLY_FIXED_FLOWS) ||
+        (method.first == LocalizationMethod::LIN_LSQR_FIXED_FLOWS))
+      flow_combination_required = true;
+  }
+  // The combined flows are only built from the flow combination selection, without it the flow
+  // combination methods are skipped
+  if (!flow_combination_required)
+    requiredInputs &= ~LOC_INPUT_COMBINED_FLOWS;
 
   if (flow_combination_required) {
     uint32_t observer_set_id = 0;
     for (const auto &observerSet : observerSets)
     {
         selected_flow_ids_per_observer_flow_combination[observer_set_id] = SelectFlows(srs, observerSet, flowSelectionStrategyWithparams, true);
-        observerSetmap_flow_combination[observer_set_id] = observerSet;
         observer_set_id++;
     }
   }
 
-  std::vector<std::pair<ClassificationConfig, std::vector<LocalizationResult>>> results;
-  for ( const auto &observerSetEntry : observerSetmap) {
-    ObserverSet observerSet = observerSetEntry.second;
-    std::map<uint32_t, std::set<uint32_t>> selectedFlowIdsMap = selected_flow_ids_per_observer[observerSetEntry.first];
+  // The classification and characterization of the observer sets are the inputs of the
+  // localization methods. The result set is only read concurrently if it is frozen.
+  if (!srs.IsFrozen())
+    numThreads = 1;
+  const LinkVec allLinks = srs.GetAllLinks();
 
-    ObserverSet observerSet_FlowCombination; // = observerSetEntry.second;
-    std::map<uint32_t, std::set<uint32_t>> selectedFlowIdsMap_FlowCombination; // = selected_flow_ids_per_observer[observerSetEntry.first];
+  std::vector<LocalizationInputs> inputs(observerSetmap.size());
+  std::vector<std::set<uint32_t>> flowIds(observerSetmap.size());
+  for (const auto &observerSetEntry : observerSetmap)
+  {
+    // Every observer set is checked, also if no method classifies its paths
+    for (auto &oid : observerSetEntry.second.observers)
+    {
+      const auto &fids = srs.GetObserverFlowIds(oid);
+      flowIds[observerSetEntry.first].insert(fids.begin(), fids.end());
+    }
+    if (observerSetEntry.second.observers.empty() || flowIds[observerSetEntry.first].empty() ||
+        joinedBits.empty())
+      throw std::invalid_argument("Empty input arg.");
+
+    LocalizationInputs &in = inputs[observerSetEntry.first];
+    in.observerSet = observerSetEntry.second;
+    in.selectedFlowIdsMap = selected_flow_ids_per_observer[observerSetEntry.first];
+    if (flow_combination_required)
+    {
+      in.selectedFlowIdsMap_FlowCombination =
+          selected_flow_ids_per_observer_flow_combination[observerSetEntry.first];
+    }
+  }
 
-    if (flow_combination_required){
-        observerSet_FlowCombination = observerSetmap_flow_combination[observerSetEntry.first];
-        selectedFlowIdsMap_FlowCombination = selected_flow_ids_per_observer_flow_combination[observerSetEntry.first];
+  // One task per observer set builds its inputs, or takes them from the cache if another observer
+  // set or config already built them
+  LocalizationInputCache localInputCache;
+  if (inputCache == nullptr)
+    inputCache = &localInputCache;
+  ParallelFor(inputs.size(), numThreads, [&](size_t o) {
+    BuildLocalizationInputs(inputs[o], *inputCache, srs, joinedBits, thresholds, flowLengthTh,
+                            classificationMode, classification_base_id, time_filter,
+                            requiredInputs);
+  });
+
+  // Then one task per thresholds, observer set, bit set, and method localizes the failures. The
+  // results are stored in the order of the loops of a sequential run.
+  std::vector<std::pair<LocalizationMethod, LocalizationParams>> methods(locMethods.begin(),
+                                                                         locMethods.end());
+  size_t tasksPerSet = efmBitSets.size() * methods.size();
+  size_t tasksPerThresholds = inputs.size() * tasksPerSet;
+  std::vector<std::optional<LocalizationResult>> taskResults(thresholds.size() *
+                                                             tasksPerThresholds);
+  ParallelFor(taskResults.size(), numThreads, [&](size_t t) {
+    size_t th = t / tasksPerThresholds;
+    const LocalizationInputs &in = inputs[(t % tasksPerThresholds) / tasksPerSet];
+    const EfmBitSet &bits = efmBitSets[(t % tasksPerSet) / methods.size()];
+    const auto &method = methods[t % methods.size()];
+    taskResults[t] = LocalizeFailures(in, th, thresholds[th], allLinks, bits, method.first,
+                                      method.second, classificationMode, time_filter);
+  });
+
+  std::vector<std::pair<ClassificationConfig, std::vector<LocalizationResult>>> results;
+  for (size_t s = 0; s < thresholds.size() * inputs.size(); s++)
+  {
+    const ClassificationThresholds &th = thresholds[s / inputs.size()];
+    const LocalizationInputs &in = inputs[s % inputs.size()];
+    std::vector<LocalizationResult> locResults;
+    for (size_t t = s * tasksPerSet; t < (s + 1) * tasksPerSet; t++)
+    {
+      if (taskResults[t].has_value())
+        locResults.push_back(std::move(*taskResults[t]));
     }
 
-    ClassifiedPathSet cps = ClassifiedPathSet::ClassifyAll(
-    srs, observerSet.observers, selectedFlowIdsMap, joinedBits, lossRateTh, delayTh, flowLengthTh, classificationMode, classification_base_id, SMALL_FAIL_FACTOR, LARGE_FAIL_FACTOR, time_filter);
-    ClassificationConfig baseConfig = cps.GetConfig();
+    // Same config as the one of a classified path set of the observer set, which is not built if
+    // no method uses it
+    ClassificationConfig config;
+    config.lossRateTh = th.lossRateTh;
+    config.delayTh = th.delayTh;
+    config.flowLengthTh = flowLengthTh;
+    config.classificationMode = classificationMode;
+    config.classification_base_id = classification_base_id;
+    config.observerSet = in.observerSet;
+    config.flowIds = flowIds[s % inputs.size()];
+    config.flowSelectionMap = in.selectedFlowIdsMap;
+    results.emplace_back(config, locResults);
+  }
+  return results;
+}
+
+LocalizationInputMask FailureLocalization::PlanLocalizationInputs(
+    const std::map<LocalizationMethod, LocalizationParams> &locMethods,
+    const std::vector<EfmBitSet> &efmBitSets, ClassificationMode classificationMode)
+{
+  bool singleCombinationBits = false;
+  for (const EfmBitSet &bits : efmBitSets)
+  {
+    if (AreSingleCombinationBit(bits))
+      singleCombinationBits = true;
+  }
+
+  LocalizationInputMask requiredInputs = LOC_INPUT_NONE;
+  for (const auto &method : locMethods)
+  {
+    requiredInputs |= GetRequiredInputs(method.first);
+  }
 
+  // The linear systems are only solved on measurements, not on perfect classifications
+  if (classificationMode == ClassificationMode::PERFECT)
+    requiredInputs &= ~(LOC_INPUT_LINK_CHARACTERISTICS_CORE_ONLY | LOC_INPUT_LINK_CHARACTERISTICS |
+                        LOC_INPUT_COMBINED_FLOWS);
+  // The flow combination methods only localize on single combination bits
+  if (!singleCombinationBits)
+    requiredInputs &= ~LOC_INPUT_COMBINED_FLOWS;
+  return requiredInputs;
+}
+
+void FailureLocalization::BuildLocalizationInputs(
+    LocalizationInputs &in, LocalizationInputCache &inputCache, const simdata::SimResultSet &srs,
+    const std::set<EfmBit> &joinedBits, const std::vector<ClassificationThresholds> &thresholds,
+    uint32_t flowLengthTh,
+    ClassificationMode classificationMode, const std::string &classification_base_id,
+    double time_filter, LocalizationInputMask requiredInputs)
+{
+  if (requiredInputs & LOC_INPUT_CLASSIFIED_PATHS)
+  {
+    in.cps = inputCache.GetClassifiedPathSets(
+      srs, in.observerSet.observers, in.selectedFlowIdsMap, joinedBits, thresholds, flowLengthTh, classificationMode, classification_base_id, SMALL_FAIL_FACTOR, LARGE_FAIL_FACTOR, time_filter);
+  }
 
     /* Process is as follows to solve min|A * x - b = 0|
         1. Prepare a matrix A: columns == number of links, rows == measurements -> specify which links used in which measurements
@@ -348,135 +484,49 @@ FailureLocalization::LocalizeFailures(
         4. Output: estimations of link characteristics -> feed them into a classification where we can directly apply thresholds on the individual links
         5. Maybe also run against measurements to see for which links we get high errors
     */
-    LinkCharacteristicSet lcs_core_only;
-    LinkCharacteristicSet lcs;
-    LinkCharacteristicSet lcs_core_only_fixed_flows;
-    LinkCharacteristicSet lcs_fixed_flows;
-
-    if (classificationMode != ClassificationMode::PERFECT){
-        lcs_core_only = LinkCharacteristicSet::CharacterizeAll(srs, observerSet.observers, selectedFlowIdsMap, joinedBits, flowLengthTh, true, classificationMode, classification_base_id, time_filter);
-        lcs = LinkCharacteristicSet::CharacterizeAll(srs, observerSet.observers, selectedFlowIdsMap, joinedBits, flowLengthTh, false, classificationMode, classification_base_id, time_filter);
-
-        if (flow_combination_required) {
-            lcs_core_only_fixed_flows = LinkCharacteristicSet::CharacterizeAll(srs, observerSet_FlowCombination.observers, selectedFlowIdsMap, joinedBits, flowLengthTh, true, classificationMode, classification_base_id, time_filter);
-            lcs_fixed_flows = LinkCharacteristicSet::CharacterizeAll(srs, observerSet_FlowCombination.observers, selectedFlowIdsMap, joinedBits, flowLengthTh, false, classificationMode, classification_base_id, time_filter);
-        }
-    }
+    if (requiredInputs & LOC_INPUT_LINK_CHARACTERISTICS_CORE_ONLY)
+        in.lcs_core_only = inputCache.GetLinkCharacteristicSet(srs, in.observerSet.observers, in.selectedFlowIdsMap, joinedBits, flowLengthTh, true, classificationMode, classification_base_id, time_filter);
+    if (requiredInputs & LOC_INPUT_LINK_CHARACTERISTICS)
+        in.lcs = inputCache.GetLinkCharacteristicSet(srs, in.observerSet.observers, in.selectedFlowIdsMap, joinedBits, flowLengthTh, false, classificationMode, classification_base_id, time_filter);
 
-    CombinedFlowSet cfs;
-    CombinedFlowSet cfs_fixed_flows;
-    if (classificationMode != ClassificationMode::PERFECT && flow_combination_required){
-        cfs = CombinedFlowSet::CharacterizeAll(srs, observerSet.observers, selectedFlowIdsMap_FlowCombination, joinedBits, flowLengthTh, classificationMode, classification_base_id, time_filter);
-
-        cfs_fixed_flows = CombinedFlowSet::CharacterizeAll(srs, observerSet_FlowCombination.observers, selectedFlowIdsMap_FlowCombination, joinedBits, flowLengthTh, classificationMode, classification_base_id, time_filter);
-    }
-
-    std::vector<LocalizationResult> locResults;
-    for (const EfmBitSet &bits : efmBitSets)
-    {
-      for (const auto &method : locMethods)
-      {
-        bool use_link_classification = false;
-        bool special_treatment = false;
-        switch (method.first)
-        {
-            case LocalizationMethod::POSSIBLE:
-            case LocalizationMethod::PROBABLE:
-            case LocalizationMethod::WEIGHT_ITER:
-            case LocalizationMethod::WEIGHT_DIR:
-            case LocalizationMethod::WEIGHT_ITER_LVL:
-            case LocalizationMethod::WEIGHT_DIR_LVL:
-            case LocalizationMethod::DLC:
-            case LocalizationMethod::WEIGHT_BAD:
-            case LocalizationMethod::WEIGHT_BAD_LVL:
-            case LocalizationMethod::DETECTION:
-            case LocalizationMethod::LP_WITH_SLACK:
-              use_link_classification = true;
-              break;
-            case LocalizationMethod::LIN_LSQR_CORE_ONLY:
-            case LocalizationMethod::LIN_LSQR_CORE_ONLY_FIXED_FLOWS:
-            case LocalizationMethod::LIN_LSQR:
-            case LocalizationMethod::LIN_LSQR_FIXED_FLOWS:
-              use_link_classification = false;
-              break;
-            case LocalizationMethod::FLOW_COMBINATION:
-            case LocalizationMethod::FLOW_COMBINATION_FIXED_FLOWS:
-              special_treatment = true;
-              break;
-            default:
-              throw std::runtime_error("Unknown localization method.");
-        }
+    if (requiredInputs & LOC_INPUT_COMBINED_FLOWS)
+        in.cfs = inputCache.GetCombinedFlowSet(srs, in.observerSet.observers, in.selectedFlowIdsMap_FlowCombination, joinedBits, flowLengthTh, classificationMode, classification_base_id, time_filter);
+}
 
-        if (use_link_classification && !special_treatment){
-          std::optional<LocalizationResult> res =
-              LocalizeFailures(cps, srs.GetAllLinks(), observerSet.observers, bits, method.first,
-                               method.second, lossRateTh, delayTh, time_filter);
-          if (res.has_value())
-            locResults.push_back(res.value());
-        } else if (!use_link_classification && !special_treatment){
-            if (classificationMode != ClassificationMode::PERFECT){
-
-                if (method.first == LocalizationMethod::LIN_LSQR_CORE_ONLY){
-                    std::optional<LocalizationResult> res =
-                        LocalizeFailures(lcs_core_only, srs.GetAllLinks(), observerSet.observers, bits,
-                                        method.first, method.second, lossRateTh, delayTh, time_filter);
-                    if (res.has_value())
-                        locResults.push_back(res.value());
-                } else if (method.first == LocalizationMethod::LIN_LSQR_CORE_ONLY_FIXED_FLOWS){
-                    std::optional<LocalizationResult> res =
-                        LocalizeFailures(lcs_core_only_fixed_flows, srs.GetAllLinks(), observerSet_FlowCombination.observers, bits,
-                                        method.first, method.second, lossRateTh, delayTh, time_filter);
-                    if (res.has_value())
-                        locResults.push_back(res.value());
-                } else if (method.first == LocalizationMethod::LIN_LSQR){
-                    std::optional<LocalizationResult> res =
-                        LocalizeFailures(lcs, srs.GetAllLinks(), observerSet.observers, bits,
-                                        method.first, method.second, lossRateTh, delayTh, time_filter);
-                    if (res.has_value())
-                        locResults.push_back(res.value());
-                } else if (method.first == LocalizationMethod::LIN_LSQR_FIXED_FLOWS) {
-                    std::optional<LocalizationResult> res =
-                        LocalizeFailures(lcs_fixed_flows, srs.GetAllLinks(), observerSet_FlowCombination.observers, bits,
-                                        method.first, method.second, lossRateTh, delayTh, time_filter);
-                    if (res.has_value())
-                        locResults.push_back(res.value());
-                } else { 
-                    throw std::runtime_error("No other mode supported here.");
-                }
-            }
-        } else if (special_treatment && AreSingleCombinationBit(bits)){
-            if (classificationMode != ClassificationMode::PERFECT){
-
-                if (method.first == LocalizationMethod::FLOW_COMBINATION){
-
-                    std::optional<LocalizationResult> res =
-                        LocalizeFailures(cfs, srs.GetAllLinks(), observerSet.observers, bits,
-                                        method.first, method.second, lossRateTh, delayTh, time_filter);
-                    if (res.has_value())
-                        locResults.push_back(res.value());
-                } else if (method.first == LocalizationMethod::FLOW_COMBINATION_FIXED_FLOWS){
-
-                    std::optional<LocalizationResult> res =
-                        LocalizeFailures(cfs_fixed_flows, srs.GetAllLinks(), observerSet_FlowCombination.observers, bits,
-                                        method.first, method.second, lossRateTh, delayTh, time_filter);
-                    if (res.has_value())
-                        locResults.push_back(res.value());
-                }
-            }
-        }
-      }
-    }
-    ClassificationConfig config = baseConfig;
-    config.observerSet = observerSet;
-    for (auto &oid : observerSet.observers)
-    {
-      auto fids = srs.GetObserverFlowIds(oid, selectedFlowIdsMap);
-      config.flowIds.insert(fids.begin(), fids.end());
-    }
-    config.flowSelectionMap = selectedFlowIdsMap;
-    results.emplace_back(config, locResults);
+std::optional<LocalizationResult> FailureLocalization::LocalizeFailures(
+    const LocalizationInputs &in, size_t thresholdIndex,
+    const ClassificationThresholds &thresholds, const LinkVec &allLinks, const EfmBitSet &bits,
+    LocalizationMethod method, const LocalizationParams &locParams,
+    ClassificationMode classificationMode, double time_filter)
+{
+  double lossRateTh = thresholds.lossRateTh;
+  uint32_t delayTh = thresholds.delayTh;
+  switch (GetRequiredInputs(method))
+  {
+    case LOC_INPUT_CLASSIFIED_PATHS:
+      return LocalizeFailures(*in.cps[thresholdIndex], allLinks, in.observerSet.observers, bits, method,
+                              locParams, lossRateTh, delayTh, time_filter);
+    case LOC_INPUT_LINK_CHARACTERISTICS_CORE_ONLY:
+      if (classificationMode != ClassificationMode::PERFECT)
+        return LocalizeFailures(*in.lcs_core_only, allLinks, in.observerSet.observers, bits,
+                                method, locParams, lossRateTh, delayTh, time_filter);
+      break;
+    case LOC_INPUT_LINK_CHARACTERISTICS:
+      if (classificationMode != ClassificationMode::PERFECT)
+        return LocalizeFailures(*in.lcs, allLinks, in.observerSet.observers, bits, method,
+                                locParams, lossRateTh, delayTh, time_filter);
+      break;
+    case LOC_INPUT_COMBINED_FLOWS:
+      // Without a flow combination selection no combined flows are built, the empty set is skipped
+      if (classificationMode != ClassificationMode::PERFECT && AreSingleCombinationBit(bits))
+        return LocalizeFailures(in.cfs ? *in.cfs : CombinedFlowSet(), allLinks,
+                                in.observerSet.observers, bits, method, locParams, lossRateTh,
+                                delayTh, time_filter);
+      break;
+    default:
+      throw std::runtime_error("No other mode supported here.");
   }
-  return results;
+  return std::nullopt;
 }
 
 
@@ -502,9 +552,9 @@ std::optional<LocalizationResult> FailureLocalization::LocalizeFailures(
   ClassPathVec paths = cps.GetClassifiedPaths(observers, efmBits);
   if (paths.empty())
   {
-    std::cout << "Warning: Skip localization results for " << efmbitset_to_string(efmBits)
-              << " with observer set " << printIntSet(observers) << " because no paths were found."
-              << std::endl;
+    LogLine(std::cout, "Warning: Skip localization results for " + efmbitset_to_string(efmBits) +
+                           " with observer set " + printIntSet(observers) +
+                           " because no paths were found.");
     return std::nullopt;
   }
 
@@ -539,7 +589,11 @@ std::optional<LocalizationResult> FailureLocalization::LocalizeFailures(
         if (locParams.count("normalization") == 1){
             normalize = locParams.at("normalization");
         } 
-        result.failedLinks = DirectWeightedFailedLinks(paths, all_links, locParams.at("winc"), locParams.at("wdec"), locParams.at("wscale"), locParams.at("wthresh"), locParams.at("pathscale"), normalize);
+        double logdomain = 0.0;
+        if (locParams.count("logdomain") == 1){
+            logdomain = locParams.at("logdomain");
+        }
+        result.failedLinks = DirectWeightedFailedLinks(paths, all_links, locParams.at("winc"), locParams.at("wdec"), locParams.at("wscale"), locParams.at("wthresh"), locParams.at("pathscale"), normalize, logdomain);
       } else {
         throw std::runtime_error("Not all params available for WEIGHT_DIR.");
       }
@@ -561,7 +615,11 @@ std::optional<LocalizationResult> FailureLocalization::LocalizeFailures(
         if (locParams.count("normalization") == 1){
             normalize = locParams.at("normalization");
         } 
-        result.failedLinks = DirectWeightedFailedLinks_ThreeLevel(paths, all_links, locParams.at("winc_lvl1"), locParams.at("winc_lvl2"), locParams.at("winc_lvl3"), locParams.at("wdec"), locParams.at("wscale"), locParams.at("wthresh"), locParams.at("pathscale"), normalize);
+        double logdomain = 0.0;
+        if (locParams.count("logdomain") == 1){
+            logdomain = locParams.at("logdomain");
+        }
+        result.failedLinks = DirectWeightedFailedLinks_ThreeLevel(paths, all_links, locParams.at("winc_lvl1"), locParams.at("winc_lvl2"), locParams.at("winc_lvl3"), locParams.at("wdec"), locParams.at("wscale"), locParams.at("wthresh"), locParams.at("pathscale"), normalize, logdomain);
       } else {
         throw std::runtime_error("Not all params available for WEIGHT_DIR_LVL.");
       }
@@ -579,7 +637,11 @@ std::optional<LocalizationResult> FailureLocalization::LocalizeFailures(
         if (locParams.count("normalization") == 1){
             normalize = locParams.at("normalization");
         } 
-        result.failedLinks = BadPathLinkWeight(paths, all_links, locParams.at("winc"), locParams.at("wdec"), locParams.at("wscale"), locParams.at("wthresh"), locParams.at("pathscale"), normalize);
+        double logdomain = 0.0;
+        if (locParams.count("logdomain") == 1){
+            logdomain = locParams.at("logdomain");
+        }
+        result.failedLinks = BadPathLinkWeight(paths, all_links, locParams.at("winc"), locParams.at("wdec"), locParams.at("wscale"), locParams.at("wthresh"), locParams.at("pathscale"), normalize, logdomain);
       } else {
         throw std::runtime_error("Not all params available for WEIGHT_BAD.");
       }
@@ -590,7 +652,11 @@ std::optional<LocalizationResult> FailureLocalization::LocalizeFailures(
         if (locParams.count("normalization") == 1){
             normalize = locParams.at("normalization");
         } 
-        result.failedLinks = BadPathLinkWeight_ThreeLevel(paths, all_links, locParams.at("winc_lvl1"), locParams.at("winc_lvl2"), locParams.at("winc_lvl3"), locParams.at("wdec"), locParams.at("wscale"), locParams.at("wthresh"), locParams.at("pathscale"), normalize);
+        double logdomain = 0.0;
+        if (locParams.count("logdomain") == 1){
+            logdomain = locParams.at("logdomain");
+        }
+        result.failedLinks = BadPathLinkWeight_ThreeLevel(paths, all_links, locParams.at("winc_lvl1"), locParams.at("winc_lvl2"), locParams.at("winc_lvl3"), locParams.at("wdec"), locParams.at("wscale"), locParams.at("wthresh"), locParams.at("pathscale"), normalize, logdomain);
       } else {
         throw std::runtime_error("Not all params available for WEIGHT_BAD_LVL.");
       }
@@ -604,7 +670,7 @@ std::optional<LocalizationResult> FailureLocalization::LocalizeFailures(
           LPWithSlack(paths, all_links, AreLossBits(efmBits), lossRateTh, delayTh);
 #else
       result.failedLinks = LinkSet();
-      std::cout << "Gurobi not available, skipping LP_WITH_SLACK." << std::endl;
+      LogLine(std::cout, "Gurobi not available, skipping LP_WITH_SLACK.");
 #endif
       break;
     default:
@@ -623,9 +689,9 @@ std::optional<LocalizationResult> FailureLocalization::LocalizeFailures(
   ConnMatrixMeasVecPair cmmvp = lcs.GetConnectivityMatrixMeasurementVector(observers, efmBits);
   if (cmmvp.first.empty() || cmmvp.second.empty())
   {
-    std::cout << "Warning: Skip localization results for " << efmbitset_to_string(efmBits)
-              << " with observer set " << printIntSet(observers)
-              << " because no matrix/measurement vectors were found." << std::endl;
+    LogLine(std::cout, "Warning: Skip localization results for " + efmbitset_to_string(efmBits) +
+                           " with observer set " + printIntSet(observers) +
+                           " because no matrix/measurement vectors were found.");
     return std::nullopt;
   }
 
@@ -671,9 +737,9 @@ std::optional<LocalizationResult> FailureLocalization::LocalizeFailures(
   ConnMatrixMeasVecPair cmmvp = cfs.GetConnectivityMatrixMeasurementVector(observers, efmBits);
   if (cmmvp.first.empty() || cmmvp.second.empty())
   {
-    std::cout << "Warning: Skip CFS localization results for " << efmbitset_to_string(efmBits)
-              << " with observer set " << printIntSet(observers)
-              << " because no matrix/measurement vectors were found." << std::endl;
+    LogLine(std::cout, "Warning: Skip CFS localization results for " + efmbitset_to_string(efmBits) +
+                           " with observer set " + printIntSet(observers) +
+                           " because no matrix/measurement vectors were found.");
     return std::nullopt;
   }
 
@@ -697,501 +763,70 @@ std::optional<LocalizationResult> FailureLocalization::LocalizeFailures(
   return result;
 }
 
-
+using namespace link_weights;
 
 LinkSet FailureLocalization::PossibleFailedLinks(const ClassPathVec &paths)
 {
-  LinkSet goodLinks;
-  LinkSet badLinks;
-
-  for (auto &cp : paths)
-  {
-    if (cp.failed)
-    {
-      for (const Link &link : cp.path.links)
-      {
-        if (goodLinks.find(link) == goodLinks.end())  // Link not classified good
-          badLinks.insert(link);
-      }
-    }
-    else
-    {
-      for (const Link &link : cp.path.links)
-      {
-        goodLinks.insert(link);
-        badLinks.erase(link);
-      }
-    }
-  }
-
-  return badLinks;
+  // A link stays bad if it is on a failed path and on no good path, no matter in which order the
+  // paths are seen
+  DenseLinkIndex index(paths, LinkVec());
+  LinkBitset badLinks(index.links.size());
+  LinkBitset goodLinks(index.links.size());
+  badLinks.SetPathLinks(index, paths, [](const ClassifiedLinkPath &cp) { return cp.failed; });
+  goodLinks.SetPathLinks(index, paths, [](const ClassifiedLinkPath &cp) { return !cp.failed; });
+  badLinks.AndNot(goodLinks);
+  return badLinks.ToLinkSet(index);
 }
 
 LinkSet FailureLocalization::ProbableFailedLinks(const ClassPathVec &paths)
 {
-  LinkSet goodLinks;
-  LinkSet badLinks;
-
-  for (auto &cp : paths)
-  {
-    if (!cp.failed)
-    {
-      goodLinks.insert(cp.path.links.begin(), cp.path.links.end());
-    }
-  }
+  DenseLinkIndex index(paths, LinkVec());
+  LinkBitset goodLinks(index.links.size());
+  goodLinks.SetPathLinks(index, paths, [](const ClassifiedLinkPath &cp) { return !cp.failed; });
 
-  for (auto &cp : paths)
+  LinkSet badLinks;
+  for (size_t p = 0; p < paths.size(); p++)
   {
-    if (cp.failed)
+    if (paths[p].failed)
     {
-      bool exactlyOneBad = false;
-      Link badLink;
-      for (const Link &link : cp.path.links)
+      // Links that occur several times on the path count as often
+      uint32_t numBad = 0;
+      uint32_t badLink = 0;
+      for (uint32_t k = index.pathOffsets[p]; k < index.pathOffsets[p + 1] && numBad < 2; k++)
       {
-        if (goodLinks.find(link) == goodLinks.end())  // Link not classified good
+        if (!goodLinks.Test(index.pathLinks[k]))  // Link not classified good
         {
-          if (exactlyOneBad)
-          {
-            exactlyOneBad = false;
-            break;
-          }
-          else
-          {
-            exactlyOneBad = true;
-            badLink = link;
-          }
+          numBad++;
+          badLink = index.pathLinks[k];
         }
       }
-      if (exactlyOneBad)
-        badLinks.insert(badLink);
+      if (numBad == 1)
+        badLinks.insert(index.links[badLink]);
     }
   }
 
   return badLinks;
 }
 
-namespace {  // anonymous namespace
-
-double link_increase_formula_with_path_scaling(double winc, double wscale, double path_length){
-
-    // w_e \cdot (1 + \alpha - (\alpha \cdot (1 - \frac{1}{\abs{p}}) \cdot \gamma))
-    return (1 + winc - (winc * (1 - (1/path_length)) * wscale));
-}
-
-double link_increase_formula_without_path_scaling(double winc, double wscale){
-
-    // w_e \cdot (1 + \alpha - (\alpha \cdot (1 - \frac{1}{\abs{p}}) \cdot \gamma))
-    return (1 + winc * wscale);
-}
-
-std::map<Link, double> CalculateLinkWeights(const ClassPathVec &paths, const LinkVec &all_links, double winc, double wdec,
-                                            double wscale, double pathscale, double normalization)
-{
-  std::map<Link, double> linkWeights;
-  for (const ClassifiedLinkPath &cp : paths)
-  {
-    if (cp.path.links.size() == 0)
-      continue;  // Skip empty paths to prevent division by zero
-    if (cp.failed)
-    {
-      // Calculate the increase factor based on path length
-      double inc_factor = 1;
-      if (pathscale == 1.0) {
-        inc_factor = link_increase_formula_with_path_scaling(winc, wscale, cp.path.links.size());
-      } else {
-        inc_factor = link_increase_formula_without_path_scaling(winc, wscale);
-      }
-      for (const Link &link : cp.path.links)
-      {
-        auto lw = linkWeights.find(link);
-        // Set the initial weight to 1 if it doesn't exist
-        if (lw == linkWeights.end())
-        {
-            if (normalization == 1.0){
-                lw = linkWeights.insert(std::make_pair(link, 1.0 / all_links.size())).first;
-            } else {
-                lw = linkWeights.insert(std::make_pair(link, 1.0)).first;
-            }
-        }
-        // Increase the weight on failed paths
-        lw->second *= inc_factor;
-      }
-    }
-    else
-    {
-      for (const Link &link : cp.path.links)
-      {
-        auto lw = linkWeights.find(link);
-        // Set the initial weight to 1 if it doesn't exist
-        if (lw == linkWeights.end())
-        {
-            if (normalization == 1.0){
-                lw = linkWeights.insert(std::make_pair(link, 1.0 / all_links.size())).first;
-            } else {
-                lw = linkWeights.insert(std::make_pair(link, 1.0)).first;
-            }
-        }
-        // Decrease the weight on good paths
-        lw->second *= wdec;
-      }
-    }
-    if (normalization == 1.0){
-        // Determine overall weight
-        double overall_weight_sum = 0.0;
-        for(auto iter = all_links.begin(); iter < all_links.end(); iter++)
-            {
-                // Find the weight of the link
-                auto lw = linkWeights.find(*iter);
-                // Set the initial weight to 1 if it doesn't exist
-                if (lw == linkWeights.end())
-                {
-                    lw = linkWeights.insert(std::make_pair(*iter, 1.0 / all_links.size())).first;
-                }
-                overall_weight_sum += lw->second;
-            }   
-        // Do actual normalization
-        for (auto &lw : linkWeights)
-        {
-            lw.second /= overall_weight_sum;
-        }
-    }
-  }
-  return linkWeights;
-}
-
-std::map<Link, double> CalculateLinkWeights_ThreeLevel(const ClassPathVec &paths, const LinkVec &all_links, double winc_lvl1, double winc_lvl2, double winc_lvl3, double wdec,
-                                            double wscale, double pathscale, double normalization)
-{
-  std::map<Link, double> linkWeights;
-  for (const ClassifiedLinkPath &cp : paths)
-  {
-    if (cp.path.links.size() == 0)
-      continue;  // Skip empty paths to prevent division by zero
-
-    if (cp.small_failure || cp.medium_failure || cp.large_failure)
-    {
-      // Calculate the increase factor based on path length
-      //double inc_factor = winc - (wscale * (winc - 1) * (1 - (1 / cp.path.links.size())));
-      double inc_factor = 1;
-
-
-      if (pathscale == 1.0) {
-        if (cp.large_failure){
-            inc_factor = link_increase_formula_with_path_scaling(winc_lvl3, wscale, cp.path.links.size());
-        } else if (cp.medium_failure) {
-            inc_factor = link_increase_formula_with_path_scaling(winc_lvl2, wscale, cp.path.links.size());
-        } else if (cp.small_failure) {
-            inc_factor = link_increase_formula_with_path_scaling(winc_lvl1, wscale, cp.path.links.size());
-        } else {
-            throw std::runtime_error("This flow should have a failure, but hasn't."); 
-        }
-      } else {
-        if (cp.large_failure){
-            inc_factor = link_increase_formula_without_path_scaling(winc_lvl3, wscale);
-        } else if (cp.medium_failure) {
-            inc_factor = link_increase_formula_without_path_scaling(winc_lvl2, wscale);
-        } else if (cp.small_failure) {
-            inc_factor = link_increase_formula_without_path_scaling(winc_lvl1, wscale);
-        } else {
-            throw std::runtime_error("This flow should have a failure, but hasn't."); 
-        }
-      }
-      
-      
-
-      for (const Link &link : cp.path.links)
-      {
-        auto lw = linkWeights.find(link);
-        // Set the initial weight to 1 if it doesn't exist
-        if (lw == linkWeights.end())
-        {
-            if (normalization == 1.0){
-                lw = linkWeights.insert(std::make_pair(link, 1.0 / all_links.size())).first;
-            } else {
-                lw = linkWeights.insert(std::make_pair(link, 1.0)).first;
-            }
-        }
-        // Increase the weight on failed paths
-        lw->second *= inc_factor;
-      }
-    } 
-    else
-    {
-      for (const Link &link : cp.path.links)
-      {
-        auto lw = linkWeights.find(link);
-        // Set the initial weight to 1 if it doesn't exist
-        if (lw == linkWeights.end())
-        {
-            if (normalization == 1.0){
-                lw = linkWeights.insert(std::make_pair(link, 1.0 / all_links.size())).first;
-            } else {
-                lw = linkWeights.insert(std::make_pair(link, 1.0)).first;
-            }
-        }
-        // Decrease the weight on good paths
-        lw->second *= wdec;
-      }
-    }
-
-    if (normalization == 1.0){
-        // Determine overall weight
-        double overall_weight_sum = 0.0;
-        for(auto iter = all_links.begin(); iter < all_links.end(); iter++)
-            {
-                // Find the weight of the link
-                auto lw = linkWeights.find(*iter);
-                // Set the initial weight to 1 if it doesn't exist
-                if (lw == linkWeights.end())
-                {
-                    lw = linkWeights.insert(std::make_pair(*iter, 1.0 / all_links.size())).first;
-                }
-                overall_weight_sum += lw->second;
-            }   
-        // Do actual normalization
-        for (auto &lw : linkWeights)
-        {
-            lw.second /= overall_weight_sum;
-        }
-    }
-  }
-  return linkWeights;
-}
-
-std::map<Link, double> CalculateLinkWeights_BadPathsOnly(const ClassPathVec &paths, const LinkVec &all_links, double winc, double wdec,
-                                            double wscale, double pathscale, double normalization)
-{
-  std::map<Link, double> linkWeights;
-  // TODO Initialize ALL links to 1
-  for (const ClassifiedLinkPath &cp : paths)
-  { 
-    if (cp.path.links.size() == 0)
-      continue;  // Skip empty paths to prevent division by zero
-    if (cp.failed)
-    {
-      double overall_weight_sum = 0.0;
-      // Calculate the increase factor based on path length
-      //double inc_factor = winc - (wscale * (winc - 1) * (1 - (1 / cp.path.links.size())));
-      double inc_factor = 1;
-      if (pathscale == 1.0) {
-        inc_factor = link_increase_formula_with_path_scaling(winc, wscale, cp.path.links.size());
-      } else {
-        inc_factor = link_increase_formula_without_path_scaling(winc, wscale);
-      }
-    
-      // Iterate over all links of the topology
-      for(auto iter = all_links.begin(); iter < all_links.end(); iter++)
-      {
-        // Check if the link is on the studied path
-        bool on_path = false;
-        if (std::find(cp.path.links.begin(), cp.path.links.end(), *iter) != cp.path.links.end()) {
-            on_path = true;
-        }
-
-        // Find the weight of the link
-        auto lw = linkWeights.find(*iter);
-        // Set the initial weight to 1 if it doesn't exist
-        if (lw == linkWeights.end())
-        {
-            if (normalization == 1.0){
-                lw = linkWeights.insert(std::make_pair(*iter, 1.0 / all_links.size())).first;
-            } else {
-                lw = linkWeights.insert(std::make_pair(*iter, 1.0)).first;
-            }
-        }
-
-        if (on_path){
-            lw->second *= inc_factor;
-        } else{
-            lw->second *= wdec;
-        }
-        overall_weight_sum += lw->second;
-      }
-      
-      if (normalization == 1.0){
-        // Do actual normalization
-        for (auto &lw : linkWeights)
-        {
-            lw.second /= overall_weight_sum;
-        }
-      }      
-    }
-
-    
-  }
-  return linkWeights;
-}
-
-std::map<Link, double> CalculateLinkWeights_BadPathsOnly_ThreeLevel(const ClassPathVec &paths, const LinkVec &all_links, double winc_lvl1, double winc_lvl2, double winc_lvl3, double wdec,
-                                            double wscale, double pathscale, double normalization)
-{
-  std::map<Link, double> linkWeights;
-  // TODO Initialize ALL links to 1
-  for (const ClassifiedLinkPath &cp : paths)
-  { 
-    if (cp.path.links.size() == 0)
-      continue;  // Skip empty paths to prevent division by zero
-    
-    if (cp.small_failure || cp.medium_failure || cp.large_failure)
-    {
-
-      double overall_weight_sum = 0.0;
-      // Calculate the increase factor based on path length
-      //double inc_factor = winc - (wscale * (winc - 1) * (1 - (1 / cp.path.links.size())));
-      double inc_factor;
-      
-
-      if (pathscale == 1.0) {
-        if (cp.large_failure){
-            inc_factor = link_increase_formula_with_path_scaling(winc_lvl3, wscale, cp.path.links.size());
-        } else if (cp.medium_failure) {
-            inc_factor = link_increase_formula_with_path_scaling(winc_lvl2, wscale, cp.path.links.size());
-        } else if (cp.small_failure) {
-            inc_factor = link_increase_formula_with_path_scaling(winc_lvl1, wscale, cp.path.links.size());
-        } else {
-            throw std::runtime_error("This flow should have a failure, but hasn't."); 
-        }
-      } else {
-        if (cp.large_failure){
-            inc_factor = link_increase_formula_without_path_scaling(winc_lvl3, wscale);
-        } else if (cp.medium_failure) {
-            inc_factor = link_increase_formula_without_path_scaling(winc_lvl2, wscale);
-        } else if (cp.small_failure) {
-            inc_factor = link_increase_formula_without_path_scaling(winc_lvl1, wscale);
-        } else {
-            throw std::runtime_error("This flow should have a failure, but hasn't."); 
-        }
-      }
-
-      // Iterate over all links of the topology
-      for(auto iter = all_links.begin(); iter < all_links.end(); iter++)
-      {
-        // Check if the link is on the studied path
-        bool on_path = false;
-        if (std::find(cp.path.links.begin(), cp.path.links.end(), *iter) != cp.path.links.end()) {
-            on_path = true;
-        }
-
-        // Find the weight of the link
-        auto lw = linkWeights.find(*iter);
-        // Set the initial weight to 1 if it doesn't exist
-        if (lw == linkWeights.end())
-        {
-            if (normalization == 1.0){
-                lw = linkWeights.insert(std::make_pair(*iter, 1.0 / all_links.size())).first;
-            } else {
-                lw = linkWeights.insert(std::make_pair(*iter, 1.0)).first;
-            }
-        }
-
-        if (on_path){
-            lw->second *= inc_factor;
-        } else{
-            lw->second *= wdec;
-        }
-        overall_weight_sum += lw->second;
-
-      }      
-
-        if (normalization == 1.0){
-            // Do actual normalization
-            for (auto &lw : linkWeights)
-            {
-                lw.second /= overall_weight_sum;
-            }
-        }
-    }
-  }
-  return linkWeights;
-}
-
-std::map<Link, double> CalculateLinkCounts(const ClassPathVec &paths)
-{
-  std::map<Link, double> linkCounts;
-  double overall_count = 0.0;
-  for (const ClassifiedLinkPath &cp : paths)
-  {
-    if (cp.path.links.size() == 0)
-      continue;  // Skip empty paths to prevent division by zero
-    if (cp.failed)
-    {
-      // Count the overall number of used measurements
-      overall_count += 1;
-
-      // Increase the count for each link contained on the failed path
-      for (const Link &link : cp.path.links)
-      {
-        auto lw = linkCounts.find(link);
-        // Set the initial count to 1 if it doesn't exist (as it is on this failed path)
-        if (lw == linkCounts.end())
-        {
-          lw = linkCounts.insert(std::make_pair(link, 1.0)).first;
-        }
-        else 
-        {
-          lw->second += 1.0;
-        }
-      }
-    }
-  }
-  
-  // Divide the link count by the overall number of faulty measurements to normalize result to [0,1] 
-  if (overall_count != 0) {
-    for(auto& lc_val : linkCounts) {
-        lc_val.second /= overall_count;
-    }
-  }
-  return linkCounts;
-}
-
-}  // anonymous namespace
-
 LinkSet FailureLocalization::IterativeWeightedFailedLinks(const ClassPathVec &paths, const LinkVec &all_links, double winc,
                                                           double wdec, double wscale,
                                                           double wthresh,
                                                           double pathscale, double normalization)
 {
-  LinkSet badLinks;
-  ClassPathVec itPaths = paths;  // Copy path set because the iteration modifies it
-  double maxWeight = 0;
-  Link maxLink;
-  do
-  {
-    maxWeight = 0;
-    std::map<Link, double> linkWeights = CalculateLinkWeights(itPaths, all_links, winc, wdec, wscale, pathscale, normalization);
-    for (const auto &lw : linkWeights)
-    {
-      if (lw.second > maxWeight)
-      {
-        maxLink = lw.first;
-        maxWeight = lw.second;
-      }
-    }
-    if (maxWeight > wthresh)
-    {
-      badLinks.insert(maxLink);
-      // Remove all paths that contain the failed link with max weight
-      for (auto it = itPaths.begin(); it != itPaths.end();)
-      {
-        if (std::find(it->path.links.begin(), it->path.links.end(), maxLink) !=
-            it->path.links.end())
-        {
-          it = itPaths.erase(it);
-        }
-        else
-        {
-          it++;
-        }
-      }
-    }
-  } while (maxWeight > wthresh);
-
-  return badLinks;
+  return IterativeWeightedLinks(
+      paths, all_links, single_level_inc_factor(winc, wscale, pathscale), wdec, wthresh, normalization);
 }
 
 LinkSet FailureLocalization::DirectWeightedFailedLinks(const ClassPathVec &paths, const LinkVec &all_links, double winc,
-                                                       double wdec, double wscale, double wthresh, double pathscale, double normalization)
+                                                       double wdec, double wscale, double wthresh, double pathscale, double normalization,
+                                                       double logdomain)
 {
+  if (logdomain == 1.0)
+  {
+    auto logWeights = AccumulateLogLinkWeights(paths, all_links, single_level_inc_factor(winc, wscale, pathscale), wdec, normalization);
+    if (logWeights)
+      return LinksAboveLogThreshold(*logWeights, wthresh);
+  }
   LinkSet badLinks;
   std::map<Link, double> linkWeights = CalculateLinkWeights(paths, all_links, winc, wdec, wscale, pathscale, normalization);
   for (const auto &lw : linkWeights)
@@ -1206,47 +841,21 @@ LinkSet FailureLocalization::IterativeWeightedFailedLinks_ThreeLevel(const Class
                                                           double wdec, double wscale,
                                                           double wthresh, double pathscale, double normalization)
 {
-  LinkSet badLinks;
-  ClassPathVec itPaths = paths;  // Copy path set because the iteration modifies it
-  double maxWeight = 0;
-  Link maxLink;
-  do
-  {
-    maxWeight = 0;
-    std::map<Link, double> linkWeights = CalculateLinkWeights_ThreeLevel(itPaths, all_links, winc_lvl1, winc_lvl2, winc_lvl3, wdec, wscale, pathscale, normalization);
-    for (const auto &lw : linkWeights)
-    {
-      if (lw.second > maxWeight)
-      {
-        maxLink = lw.first;
-        maxWeight = lw.second;
-      }
-    }
-    if (maxWeight > wthresh)
-    {
-      badLinks.insert(maxLink);
-      // Remove all paths that contain the failed link with max weight
-      for (auto it = itPaths.begin(); it != itPaths.end();)
-      {
-        if (std::find(it->path.links.begin(), it->path.links.end(), maxLink) !=
-            it->path.links.end())
-        {
-          it = itPaths.erase(it);
-        }
-        else
-        {
-          it++;
-        }
-      }
-    }
-  } while (maxWeight > wthresh);
-
-  return badLinks;
+  return IterativeWeightedLinks(
+      paths, all_links, three_level_inc_factor(winc_lvl1, winc_lvl2, winc_lvl3, wscale, pathscale), wdec, wthresh, normalization);
 }
 
 LinkSet FailureLocalization::DirectWeightedFailedLinks_ThreeLevel(const ClassPathVec &paths, const LinkVec &all_links, double winc_lvl1, double winc_lvl2, double winc_lvl3,
-                                                       double wdec, double wscale, double wthresh, double pathscale, double normalization)
+                                                       double wdec, double wscale, double wthresh, double pathscale, double normalization,
+                                                       double logdomain)
 {
+  if (logdomain == 1.0)
+  {
+    auto logWeights = AccumulateLogLinkWeights(paths, all_links, three_level_inc_factor(winc_lvl1, winc_lvl2, winc_lvl3, wscale, pathscale),
+                                               wdec, normalization);
+    if (logWeights)
+      return LinksAboveLogThreshold(*logWeights, wthresh);
+  }
   LinkSet badLinks;
   std::map<Link, double> linkWeights = CalculateLinkWeights_ThreeLevel(paths, all_links, winc_lvl1, winc_lvl2, winc_lvl3, wdec, wscale, pathscale, normalization);
   for (const auto &lw : linkWeights)
@@ -1270,8 +879,15 @@ LinkSet FailureLocalization::DirectLinkCount(const ClassPathVec &paths, double d
 }
 
 LinkSet FailureLocalization::BadPathLinkWeight(const ClassPathVec &paths, const LinkVec &all_links, double winc,
-                                                       double wdec, double wscale, double wthresh, double pathscale, double normalization)
+                                                       double wdec, double wscale, double wthresh, double pathscale, double normalization,
+                                                       double logdomain)
 {
+  if (logdomain == 1.0)
+  {
+    auto logWeights = AccumulateLogLinkWeights_BadPathsOnly(paths, all_links, single_level_inc_factor(winc, wscale, pathscale), wdec, normalization);
+    if (logWeights)
+      return LinksAboveLogThreshold(*logWeights, wthresh);
+  }
   LinkSet badLinks;
   std::map<Link, double> linkWeights = CalculateLinkWeights_BadPathsOnly(paths, all_links, winc, wdec, wscale, pathscale, normalization);
   for (const auto &lw : linkWeights)
@@ -1284,8 +900,16 @@ LinkSet FailureLocalization::BadPathLinkWeight(const ClassPathVec &paths, const
 
 LinkSet FailureLocalization::BadPathLinkWeight_ThreeLevel(const ClassPathVec &paths, const LinkVec &all_links, double winc_lvl1, 
                                                             double winc_lvl2, double winc_lvl3, 
-                                                            double wdec, double wscale, double wthresh, double pathscale, double normalization)
+                                                            double wdec, double wscale, double wthresh, double pathscale, double normalization,
+                                                            double logdomain)
 {
+  if (logdomain == 1.0)
+  {
+    auto logWeights = AccumulateLogLinkWeights_BadPathsOnly(paths, all_links, three_level_inc_factor(winc_lvl1, winc_lvl2, winc_lvl3, wscale, pathscale),
+                                                            wdec, normalization);
+    if (logWeights)
+      return LinksAboveLogThreshold(*logWeights, wthresh);
+  }
   LinkSet badLinks;
   std::map<Link, double> linkWeights = CalculateLinkWeights_BadPathsOnly_ThreeLevel(paths, all_links, winc_lvl1, winc_lvl2, winc_lvl3, wdec, wscale, pathscale, normalization);
   for (const auto &lw : linkWeights)
@@ -1299,20 +923,10 @@ LinkSet FailureLocalization::BadPathLinkWeight_ThreeLevel(const ClassPathVec &pa
 
 LinkSet FailureLocalization::DetectFailedLinks(const ClassPathVec &paths)
 {
-  LinkSet badLinks;
-
-  for (auto &cp : paths)
-  {
-    if (cp.failed)
-    {
-      for (const Link &link : cp.path.links)
-      {
-        badLinks.insert(link);
-      }
-    }
-  }
-
-  return badLinks;
+  DenseLinkIndex index(paths, LinkVec());
+  LinkBitset badLinks(index.links.size());
+  badLinks.SetPathLinks(index, paths, [](const ClassifiedLinkPath &cp) { return cp.failed; });
+  return badLinks.ToLinkSet(index);
 }
 
 
@@ -7,6 +7,7 @@
 #include "classified-path-set.h"
 #include "link-characteristic-set.h"
 #include "combined-flow-set.h"
+#include "localization-input-cache.h"
 #include <sim-result-set.h>
 
 
@@ -173,6 +174,49 @@ inline std::string LocalizationMethodToString(const LocalizationMethod &method)
   }
 }
 
+// The inputs the localization methods work on
+enum LocalizationInputFlag : uint32_t
+{
+  LOC_INPUT_NONE = 0,
+  LOC_INPUT_CLASSIFIED_PATHS = 1 << 0,
+  LOC_INPUT_LINK_CHARACTERISTICS_CORE_ONLY = 1 << 1,
+  LOC_INPUT_LINK_CHARACTERISTICS = 1 << 2,
+  LOC_INPUT_COMBINED_FLOWS = 1 << 3
+};
+typedef uint32_t LocalizationInputMask;
+
+/// @brief Returns the inputs a localization method needs to be built for an observer set
+inline LocalizationInputMask GetRequiredInputs(LocalizationMethod method)
+{
+  switch (method)
+  {
+    case LocalizationMethod::POSSIBLE:
+    case LocalizationMethod::PROBABLE:
+    case LocalizationMethod::WEIGHT_ITER:
+    case LocalizationMethod::WEIGHT_DIR:
+    case LocalizationMethod::WEIGHT_ITER_LVL:
+    case LocalizationMethod::WEIGHT_DIR_LVL:
+    case LocalizationMethod::DLC:
+    case LocalizationMethod::WEIGHT_BAD:
+    case LocalizationMethod::WEIGHT_BAD_LVL:
+    case LocalizationMethod::DETECTION:
+    case LocalizationMethod::LP_WITH_SLACK:
+      return LOC_INPUT_CLASSIFIED_PATHS;
+    // The fixed flow variants characterize the same observers and flows
+    case LocalizationMethod::LIN_LSQR_CORE_ONLY:
+    case LocalizationMethod::LIN_LSQR_CORE_ONLY_FIXED_FLOWS:
+      return LOC_INPUT_LINK_CHARACTERISTICS_CORE_ONLY;
+    case LocalizationMethod::LIN_LSQR:
+    case LocalizationMethod::LIN_LSQR_FIXED_FLOWS:
+      return LOC_INPUT_LINK_CHARACTERISTICS;
+    case LocalizationMethod::FLOW_COMBINATION:
+    case LocalizationMethod::FLOW_COMBINATION_FIXED_FLOWS:
+      return LOC_INPUT_COMBINED_FLOWS;
+    default:
+      throw std::runtime_error("Unknown localization method.");
+  }
+}
+
 
 
 /*
@@ -202,6 +246,21 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(LocalizationResult, failedLinks, method, para
                                    linkRatings)
 
 
+// The inputs of the localization methods for one observer set, only those in the planned mask
+// are built
+struct LocalizationInputs
+{
+  ObserverSet observerSet;
+  std::map<uint32_t, std::set<uint32_t>> selectedFlowIdsMap;
+  std::map<uint32_t, std::set<uint32_t>> selectedFlowIdsMap_FlowCombination;
+
+  // One classified path set per classification thresholds
+  std::vector<std::shared_ptr<const ClassifiedPathSet>> cps;
+  std::shared_ptr<const LinkCharacteristicSet> lcs_core_only;
+  std::shared_ptr<const LinkCharacteristicSet> lcs;
+  std::shared_ptr<const CombinedFlowSet> cfs;
+};
+
 class FailureLocalization
 {
 public:
@@ -216,6 +275,10 @@ public:
   /// paths if flow length is less than this)
   /// @param methods The localization methods to use
   /// @param locMethods The localization methods and parameters to use
+  /// @param numThreads The number of threads that build the inputs of the observer sets and run the
+  /// localization methods, only used if srs is frozen. The results do not depend on it.
+  /// @param inputCache Shares the classified and characterized paths with other calls on the same
+  /// run, if null they are only shared between the observer sets of this call
   static std::vector<std::pair<ClassificationConfig, std::vector<LocalizationResult>>>
   LocalizeFailures(const simdata::SimResultSet &srs, const std::vector<ObserverSet> &observerSets,
                    const std::vector<EfmBitSet> &efmBitSets, double lossRateTh, uint32_t delayTh,
@@ -223,7 +286,25 @@ public:
                    const std::map<LocalizationMethod, LocalizationParams> &locMethods,
                    std::string classification_base_id,
                    double time_filter,
-                   FlowSelectionStrategyWithParams flowSelectionStrategyWithparams);
+                   FlowSelectionStrategyWithParams flowSelectionStrategyWithparams,
+                   uint32_t numThreads = 1, LocalizationInputCache *inputCache = nullptr);
+
+  /// @brief Generates localization results like above for each of several loss rate and delay
+  /// thresholds. The flows are selected once, and the paths are measured once and classified for
+  /// all thresholds in one pass.
+  /// @param thresholds The loss rate and delay thresholds to use for path classification
+  /// @return The results of the observer sets for each of the thresholds, in the order of the
+  /// thresholds
+  static std::vector<std::pair<ClassificationConfig, std::vector<LocalizationResult>>>
+  LocalizeFailures(const simdata::SimResultSet &srs, const std::vector<ObserverSet> &observerSets,
+                   const std::vector<EfmBitSet> &efmBitSets,
+                   const std::vector<ClassificationThresholds> &thresholds,
+                   uint32_t flowLengthTh, ClassificationMode classificationMode,
+                   const std::map<LocalizationMethod, LocalizationParams> &locMethods,
+                   std::string classification_base_id,
+                   double time_filter,
+                   FlowSelectionStrategyWithParams flowSelectionStrategyWithparams,
+                   uint32_t numThreads = 1, LocalizationInputCache *inputCache = nullptr);
 
   /// @brief Generates a localization result for a specific combination of observers, efm bits and
   /// localization method
@@ -288,9 +369,12 @@ public:
   /// @param wscale Weight scale factor of winc relative to path length, 0 <= wscale <= 1
   /// @param wthresh Weight threshold (excl. lower bound) for links to be considered failed, 1 <=
   /// wthresh
+  /// @param logdomain Accumulate the weights as sums of log factors and normalize once at the end if
+  /// 1, avoids the per path normalization and underflow of long path sets
   /// @return The set of links considered failed
   static LinkSet DirectWeightedFailedLinks(const ClassPathVec &paths, const LinkVec &all_links, double winc, double wdec,
-                                           double wscale, double wthresh, double pathscale, double normalization);                       
+                                           double wscale, double wthresh, double pathscale, double normalization,
+                                           double logdomain = 0.0);
 
 
   /// @brief Performs the direct weighted localization method
@@ -300,9 +384,12 @@ public:
   /// @param wscale Weight scale factor of winc relative to path length, 0 <= wscale <= 1
   /// @param wthresh Weight threshold (excl. lower bound) for links to be considered failed, 1 <=
   /// wthresh
+  /// @param logdomain Accumulate the weights as sums of log factors and normalize once at the end if
+  /// 1, avoids the per path normalization and underflow of long path sets
   /// @return The set of links considered failed
   static LinkSet DirectWeightedFailedLinks_ThreeLevel(const ClassPathVec &paths, const LinkVec &all_links, double winc_lvl1, double winc_lvl2, double winc_lvl3,
-                                                       double wdec, double wscale, double wthresh, double pathscale, double normalization);
+                                                       double wdec, double wscale, double wthresh, double pathscale, double normalization,
+                                                       double logdomain = 0.0);
 
   /// @brief Counts how often each link occurs on a broken measurement and selects those that occur on more than 'wthresh'. 
   /// @param paths The classified measurement paths to use for localization
@@ -317,9 +404,12 @@ public:
   /// @param wscale Weight scale factor of winc relative to path length, 0 <= wscale <= 1
   /// @param wthresh Weight threshold (excl. lower bound) for links to be considered failed, 1 <=
   /// wthresh
+  /// @param logdomain Accumulate the weights as sums of log factors and normalize once at the end if
+  /// 1, avoids the per path normalization and underflow of long path sets
   /// @return The set of links considered failed
   static LinkSet BadPathLinkWeight(const ClassPathVec &paths, const LinkVec &all_links, double winc, double wdec,
-                                           double wscale, double wthresh, double pathscale, double normalization);
+                                           double wscale, double wthresh, double pathscale, double normalization,
+                                           double logdomain = 0.0);
 
   /// @brief Performs the bad link weight localization method
   /// @param paths The classified measurement paths to use for localization
@@ -328,10 +418,13 @@ public:
   /// @param wscale Weight scale factor of winc relative to path length, 0 <= wscale <= 1
   /// @param wthresh Weight threshold (excl. lower bound) for links to be considered failed, 1 <=
   /// wthresh
+  /// @param logdomain Accumulate the weights as sums of log factors and normalize once at the end if
+  /// 1, avoids the per path normalization and underflow of long path sets
   /// @return The set of links considered failed
   static LinkSet BadPathLinkWeight_ThreeLevel(const ClassPathVec &paths, const LinkVec &all_links, double winc_lvl1, 
                                                             double winc_lvl2, double winc_lvl3, 
-                                                            double wdec, double wscale, double wthresh, double pathscale, double normalization);
+                                                            double wdec, double wscale, double wthresh, double pathscale, double normalization,
+                                                            double logdomain = 0.0);
   static LinkSet DetectFailedLinks(const ClassPathVec &paths);
 
   static std::pair<LinkSet, LinkValueMap> LinearLSQR(
@@ -343,6 +436,33 @@ public:
   static std::pair<LinkSet, LinkValueMap> LPWithSlack(const ClassPathVec &paths,
                                                       const LinkVec &all_links, bool localize_loss,
                                                       double lossRateTh, uint32_t delayTh);
+
+private:
+  /// @brief Determines the inputs the methods need for the bit sets in the classification mode.
+  /// Inputs of methods that would not produce a result are left out.
+  static LocalizationInputMask PlanLocalizationInputs(
+      const std::map<LocalizationMethod, LocalizationParams> &locMethods,
+      const std::vector<EfmBitSet> &efmBitSets, ClassificationMode classificationMode);
+
+  /// @brief Classifies and characterizes the paths of an observer set (in.observerSet and the flow
+  /// selections of in have to be set), gets only the inputs in the mask from the cache
+  static void BuildLocalizationInputs(LocalizationInputs &in, LocalizationInputCache &inputCache,
+                                      const simdata::SimResultSet &srs,
+                                      const std::set<EfmBit> &joinedBits,
+                                      const std::vector<ClassificationThresholds> &thresholds,
+                                      uint32_t flowLengthTh,
+                                      ClassificationMode classificationMode,
+                                      const std::string &classification_base_id,
+                                      double time_filter, LocalizationInputMask requiredInputs);
+
+  /// @brief Runs a localization method on the inputs it works on
+  /// @param thresholdIndex The index of the thresholds (and of the classified path set in in)
+  /// @return The result, std::nullopt if the method does not apply to the bits or mode
+  static std::optional<LocalizationResult> LocalizeFailures(
+      const LocalizationInputs &in, size_t thresholdIndex,
+      const ClassificationThresholds &thresholds, const LinkVec &allLinks, const EfmBitSet &bits,
+      LocalizationMethod method, const LocalizationParams &locParams,
+      ClassificationMode classificationMode, double time_filter);
 };
 
 
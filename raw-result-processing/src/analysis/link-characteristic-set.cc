@@ -18,7 +18,7 @@ LinkCharacteristicSet::LinkCharacteristicSet()
 
 LinkCharacteristicSet LinkCharacteristicSet::CharacterizeAll(const simdata::SimResultSet &srs,
                                                             const std::set<uint32_t> &observerIds,
-                                                            const std::map<uint32_t, std::set<uint32_t>> flowSelectionMap,
+                                                            const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
                                                             const EfmBitSet &bitCombis, 
                                                             uint32_t flowLengthTh,
                                                             bool core_links_only,
@@ -65,7 +65,7 @@ LinkCharacteristicSet LinkCharacteristicSet::CharacterizeAll(const simdata::SimR
   std::set<uint32_t> flowIds;
   for (auto &oid : observerIds)
   {
-    auto fids = srs.GetObserverFlowIds(oid);
+    const auto &fids = srs.GetObserverFlowIds(oid);
     flowIds.insert(fids.begin(), fids.end());
   }
   return Characterize(srs, observerIds, flowIds, flowSelectionMap, bitCombis, link_index_map, reverse_link_index_map, flowLengthTh, classification_base_id, time_filter);
@@ -74,7 +74,7 @@ LinkCharacteristicSet LinkCharacteristicSet::CharacterizeAll(const simdata::SimR
 LinkCharacteristicSet LinkCharacteristicSet::Characterize(const simdata::SimResultSet &srs,
                                               const std::set<uint32_t> &observerIds,
                                               const std::set<uint32_t> &flowIds,
-                                              std::map<uint32_t, std::set<uint32_t>> flowSelectionMap,
+                                              const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
                                               const EfmBitSet &bitCombis, 
                                               const LinkIndexMap link_index_map, 
                                               const ReverseLinkIndexMap reverse_link_index_map, 
@@ -99,13 +99,12 @@ LinkCharacteristicSet LinkCharacteristicSet::Characterize(const simdata::SimResu
     // Calculate (reverse) flow path as sequence of observers and corresponding link path as
     // sequence of links
     std::vector<simdata::ObsvVantagePointPointer> fp = srs.CalculateFlowPath(fid);
-    auto _lp = GenerateLinkPath(fp);
+    auto _lp = GenerateLinkPath(srs.GetFlowPath(fid));
     if (!_lp.has_value())
         continue;
     LinkPath lp = _lp.value();
     uint32_t reverseFid = srs.GetReverseFlowId(fid);
-    std::vector<simdata::ObsvVantagePointPointer> reverseFp = srs.CalculateFlowPath(reverseFid);
-    auto _reverseLp = GenerateLinkPath(reverseFp);
+    auto _reverseLp = GenerateLinkPath(srs.GetFlowPath(reverseFid));
     if (!_reverseLp.has_value())
         continue;
     LinkPath reverseLp = _reverseLp.value();
@@ -118,7 +117,7 @@ LinkCharacteristicSet LinkCharacteristicSet::Characterize(const simdata::SimResu
       // Check if observer should be used for classification
       // 1. Observer is in the observerSet
       // 2. Observer has selected the flow
-      if (observerIds.find(observerId) != observerIds.end() && flowSelectionMap[observerId].count(fid))
+      if (observerIds.find(observerId) != observerIds.end() && IsFlowSelected(flowSelectionMap, observerId, fid))
       {
         // Check if flow is observed bidirectionally
         bool bidirectional = reverseLp.ContainsNode(observerId);
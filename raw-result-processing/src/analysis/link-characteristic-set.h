@@ -51,7 +51,7 @@ public:
   /// @param classificationMode The classification mode to use
   static LinkCharacteristicSet CharacterizeAll(const simdata::SimResultSet &srs,
                                        const std::set<uint32_t> &observerIds,
-                                       const std::map<uint32_t, std::set<uint32_t>> flowSelectionMap,
+                                       const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
                                        const EfmBitSet &bitCombis,
                                        uint32_t flowLengthTh,
                                        bool core_links_only,
@@ -70,7 +70,7 @@ public:
   static LinkCharacteristicSet Characterize(const simdata::SimResultSet &srs,
                                               const std::set<uint32_t> &observerIds,
                                               const std::set<uint32_t> &flowIds,
-                                              std::map<uint32_t, std::set<uint32_t>> flowSelectionMap,
+                                              const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap,
                                               const EfmBitSet &bitCombis, 
                                               const LinkIndexMap link_index_map, 
                                               const ReverseLinkIndexMap reverse_link_index_map,
@@ -0,0 +1,716 @@
+#ifndef LINK_WEIGHTS_H
+#define LINK_WEIGHTS_H
+
+// Link weight and link set kernels of the failure localization methods, on a dense numbering of the
+// links of a path set.
+
+#include "classified-path-set.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <optional>
+#include <queue>
+#include <vector>
+
+namespace analysis {
+namespace link_weights {
+
+inline double link_increase_formula_with_path_scaling(double winc, double wscale, double path_length){
+
+    // w_e \cdot (1 + \alpha - (\alpha \cdot (1 - \frac{1}{\abs{p}}) \cdot \gamma))
+    return (1 + winc - (winc * (1 - (1/path_length)) * wscale));
+}
+
+inline double link_increase_formula_without_path_scaling(double winc, double wscale){
+
+    // w_e \cdot (1 + \alpha - (\alpha \cdot (1 - \frac{1}{\abs{p}}) \cdot \gamma))
+    return (1 + winc * wscale);
+}
+
+inline double link_increase_factor(double winc, double wscale, double pathscale, double path_length){
+    if (pathscale == 1.0)
+        return link_increase_formula_with_path_scaling(winc, wscale, path_length);
+    else
+        return link_increase_formula_without_path_scaling(winc, wscale);
+}
+
+// Increase factor of a path that failed on one of the three levels, the highest level counts
+inline std::optional<double> link_increase_factor_three_level(const ClassifiedLinkPath &cp, double winc_lvl1, double winc_lvl2, double winc_lvl3,
+                                                       double wscale, double pathscale){
+    if (cp.large_failure)
+        return link_increase_factor(winc_lvl3, wscale, pathscale, cp.path.links.size());
+    else if (cp.medium_failure)
+        return link_increase_factor(winc_lvl2, wscale, pathscale, cp.path.links.size());
+    else if (cp.small_failure)
+        return link_increase_factor(winc_lvl1, wscale, pathscale, cp.path.links.size());
+    return std::nullopt;
+}
+
+// Increase factor callables for the weight kernels, return the increase factor of a path if it failed
+inline auto single_level_inc_factor(double winc, double wscale, double pathscale){
+    return [=](const ClassifiedLinkPath &cp) -> std::optional<double> {
+        if (!cp.failed)
+            return std::nullopt;
+        return link_increase_factor(winc, wscale, pathscale, cp.path.links.size());
+    };
+}
+
+inline auto three_level_inc_factor(double winc_lvl1, double winc_lvl2, double winc_lvl3, double wscale, double pathscale){
+    return [=](const ClassifiedLinkPath &cp) {
+        return link_increase_factor_three_level(cp, winc_lvl1, winc_lvl2, winc_lvl3, wscale, pathscale);
+    };
+}
+
+// Dense numbering of the links of the topology and of a path set, so that the weight kernels work
+// on flat arrays instead of link maps. The distinct links of all_links get the indices
+// [0, numTopologyLinks) in their order, links that are only on paths follow. The links of path p
+// are pathLinks[pathOffsets[p]] to pathLinks[pathOffsets[p + 1] - 1].
+struct DenseLinkIndex
+{
+  LinkVec links;
+  size_t numTopologyLinks;
+  std::vector<uint32_t> topologyLinks;  // Index of each entry of all_links, duplicates included
+  std::vector<uint32_t> pathOffsets;
+  std::vector<uint32_t> pathLinks;
+
+  DenseLinkIndex(const ClassPathVec &paths, const LinkVec &all_links)
+  {
+    std::map<Link, uint32_t> indexOf;
+    auto getIndex = [&](const Link &link) {
+      auto res = indexOf.emplace(link, links.size());
+      if (res.second)
+        links.push_back(link);
+      return res.first->second;
+    };
+
+    topologyLinks.reserve(all_links.size());
+    for (const Link &link : all_links)
+      topologyLinks.push_back(getIndex(link));
+    numTopologyLinks = links.size();
+
+    pathOffsets.reserve(paths.size() + 1);
+    pathOffsets.push_back(0);
+    for (const ClassifiedLinkPath &cp : paths)
+    {
+      for (const Link &link : cp.path.links)
+        pathLinks.push_back(getIndex(link));
+      pathOffsets.push_back(pathLinks.size());
+    }
+  }
+
+  // Converts per index values back to a link map, only for the links flagged in hasValue
+  std::map<Link, double> ToMap(const std::vector<double> &values, const std::vector<char> &hasValue) const
+  {
+    std::map<Link, double> linkValues;
+    for (size_t i = 0; i < links.size(); i++)
+    {
+      if (hasValue[i])
+        linkValues.emplace(links[i], values[i]);
+    }
+    return linkValues;
+  }
+};
+
+// Set of dense link indices with one bit per link, so that unions and differences of link sets run
+// word by word
+class LinkBitset
+{
+public:
+  explicit LinkBitset(size_t size) : m_size(size), m_words((size + 63) / 64, 0) {}
+
+  void Set(uint32_t i) { m_words[i / 64] |= uint64_t(1) << (i % 64); }
+  bool Test(uint32_t i) const { return (m_words[i / 64] >> (i % 64)) & 1; }
+
+  // Sets the bits of all links on the paths that match the predicate
+  template <typename Predicate>
+  void SetPathLinks(const DenseLinkIndex &index, const ClassPathVec &paths, Predicate pred)
+  {
+    for (size_t p = 0; p < paths.size(); p++)
+    {
+      if (!pred(paths[p]))
+        continue;
+      for (uint32_t k = index.pathOffsets[p]; k < index.pathOffsets[p + 1]; k++)
+        Set(index.pathLinks[k]);
+    }
+  }
+
+  // Removes all links that are in other
+  void AndNot(const LinkBitset &other)
+  {
+    for (size_t w = 0; w < m_words.size(); w++)
+      m_words[w] &= ~other.m_words[w];
+  }
+
+  LinkSet ToLinkSet(const DenseLinkIndex &index) const
+  {
+    LinkSet links;
+    for (uint32_t i = 0; i < m_size; i++)
+    {
+      if (Test(i))
+        links.insert(index.links[i]);
+    }
+    return links;
+  }
+
+private:
+  size_t m_size;
+  std::vector<uint64_t> m_words;
+};
+
+// Multiplies the weights of the links on each path by the increase factor of failed paths or by
+// wdec on good paths. incFactor returns the increase factor of a path if it failed. Links get their
+// initial weight when they are first seen, with normalization all topology links are initialized
+// and all weights are divided by the sum of the topology link weights after every path.
+template <typename IncFactor>
+std::map<Link, double> AccumulateLinkWeights(const ClassPathVec &paths, const LinkVec &all_links, IncFactor incFactor,
+                                             double wdec, double normalization)
+{
+  DenseLinkIndex index(paths, all_links);
+  const uint32_t *pathLinks = index.pathLinks.data();
+  std::vector<double> weights(index.links.size(), normalization == 1.0 ? 1.0 / all_links.size() : 1.0);
+  std::vector<char> hasWeight(index.links.size(), 0);
+  for (size_t p = 0; p < paths.size(); p++)
+  {
+    const ClassifiedLinkPath &cp = paths[p];
+    if (cp.path.links.size() == 0)
+      continue;  // Skip empty paths to prevent division by zero
+    // Increase the weight on failed paths, decrease it on good paths
+    std::optional<double> inc_factor = incFactor(cp);
+    double factor = inc_factor ? *inc_factor : wdec;
+    for (uint32_t k = index.pathOffsets[p]; k < index.pathOffsets[p + 1]; k++)
+    {
+      weights[pathLinks[k]] *= factor;
+      hasWeight[pathLinks[k]] = 1;
+    }
+    if (normalization == 1.0)
+    {
+      // Determine overall weight
+      double overall_weight_sum = 0.0;
+      for (uint32_t i : index.topologyLinks)
+      {
+        hasWeight[i] = 1;
+        overall_weight_sum += weights[i];
+      }
+      // Do actual normalization, all topology links have a weight by now
+      for (size_t i = 0; i < index.numTopologyLinks; i++)
+        weights[i] /= overall_weight_sum;
+      for (size_t i = index.numTopologyLinks; i < weights.size(); i++)
+      {
+        if (hasWeight[i])
+          weights[i] /= overall_weight_sum;
+      }
+    }
+  }
+  return index.ToMap(weights, hasWeight);
+}
+
+// Like AccumulateLinkWeights, but only failed paths are used. For each of them, the topology links
+// on the path are increased and all other topology links are decreased by wdec.
+template <typename IncFactor>
+std::map<Link, double> AccumulateLinkWeights_BadPathsOnly(const ClassPathVec &paths, const LinkVec &all_links, IncFactor incFactor,
+                                                          double wdec, double normalization)
+{
+  DenseLinkIndex index(paths, all_links);
+  const uint32_t *pathLinks = index.pathLinks.data();
+  std::vector<double> weights(index.links.size(), normalization == 1.0 ? 1.0 / all_links.size() : 1.0);
+  std::vector<char> onPath(index.links.size(), 0);
+  bool hasWeights = false;
+  for (size_t p = 0; p < paths.size(); p++)
+  {
+    const ClassifiedLinkPath &cp = paths[p];
+    if (cp.path.links.size() == 0)
+      continue;  // Skip empty paths to prevent division by zero
+    std::optional<double> inc_factor = incFactor(cp);
+    if (!inc_factor)
+      continue;
+    hasWeights = true;
+
+    for (uint32_t k = index.pathOffsets[p]; k < index.pathOffsets[p + 1]; k++)
+      onPath[pathLinks[k]] = 1;
+    // Iterate over all links of the topology
+    double overall_weight_sum = 0.0;
+    for (uint32_t i : index.topologyLinks)
+    {
+      weights[i] *= onPath[i] ? *inc_factor : wdec;
+      overall_weight_sum += weights[i];
+    }
+    for (uint32_t k = index.pathOffsets[p]; k < index.pathOffsets[p + 1]; k++)
+      onPath[pathLinks[k]] = 0;
+
+    if (normalization == 1.0)
+    {
+      // Do actual normalization
+      for (size_t i = 0; i < index.numTopologyLinks; i++)
+        weights[i] /= overall_weight_sum;
+    }
+  }
+  // Only topology links get a weight, and only once a failed path was seen
+  std::vector<char> hasWeight(index.links.size(), 0);
+  if (hasWeights)
+    std::fill(hasWeight.begin(), hasWeight.begin() + index.numTopologyLinks, 1);
+  return index.ToMap(weights, hasWeight);
+}
+
+inline std::map<Link, double> CalculateLinkWeights(const ClassPathVec &paths, const LinkVec &all_links, double winc, double wdec,
+                                            double wscale, double pathscale, double normalization)
+{
+  return AccumulateLinkWeights(
+      paths, all_links, single_level_inc_factor(winc, wscale, pathscale), wdec, normalization);
+}
+
+inline std::map<Link, double> CalculateLinkWeights_ThreeLevel(const ClassPathVec &paths, const LinkVec &all_links, double winc_lvl1, double winc_lvl2, double winc_lvl3, double wdec,
+                                            double wscale, double pathscale, double normalization)
+{
+  return AccumulateLinkWeights(
+      paths, all_links, three_level_inc_factor(winc_lvl1, winc_lvl2, winc_lvl3, wscale, pathscale), wdec, normalization);
+}
+
+inline std::map<Link, double> CalculateLinkWeights_BadPathsOnly(const ClassPathVec &paths, const LinkVec &all_links, double winc, double wdec,
+                                            double wscale, double pathscale, double normalization)
+{
+  return AccumulateLinkWeights_BadPathsOnly(
+      paths, all_links, single_level_inc_factor(winc, wscale, pathscale), wdec, normalization);
+}
+
+inline std::map<Link, double> CalculateLinkWeights_BadPathsOnly_ThreeLevel(const ClassPathVec &paths, const LinkVec &all_links, double winc_lvl1, double winc_lvl2, double winc_lvl3, double wdec,
+                                            double wscale, double pathscale, double normalization)
+{
+  return AccumulateLinkWeights_BadPathsOnly(
+      paths, all_links, three_level_inc_factor(winc_lvl1, winc_lvl2, winc_lvl3, wscale, pathscale), wdec, normalization);
+}
+
+// log(sum(exp(logValues[i]))) over the given indices, shifted by the maximum to avoid overflow
+inline double LogSumExp(const std::vector<double> &logValues, const std::vector<uint32_t> &indices)
+{
+  double maxLogValue = -std::numeric_limits<double>::infinity();
+  for (uint32_t i : indices)
+    maxLogValue = std::max(maxLogValue, logValues[i]);
+  if (std::isinf(maxLogValue))
+    return maxLogValue;
+  double sum = 0.0;
+  for (uint32_t i : indices)
+    sum += std::exp(logValues[i] - maxLogValue);
+  return maxLogValue + std::log(sum);
+}
+
+// Reference implementation of IterativeWeightedLinks, recomputes all link weights in every iteration
+template <typename IncFactor>
+LinkSet IterativeWeightedLinks_Recompute(const ClassPathVec &paths, const LinkVec &all_links, IncFactor incFactor,
+                                         double wdec, double wthresh, double normalization)
+{
+  LinkSet badLinks;
+  ClassPathVec itPaths = paths;  // Copy path set because the iteration modifies it
+  double maxWeight = 0;
+  Link maxLink;
+  do
+  {
+    maxWeight = 0;
+    std::map<Link, double> linkWeights = AccumulateLinkWeights(itPaths, all_links, incFactor, wdec, normalization);
+    for (const auto &lw : linkWeights)
+    {
+      if (lw.second > maxWeight)
+      {
+        maxLink = lw.first;
+        maxWeight = lw.second;
+      }
+    }
+    if (maxWeight > wthresh)
+    {
+      // A link that was already marked has no paths left, the iteration would not progress
+      if (!badLinks.insert(maxLink).second)
+        break;
+      // Remove all paths that contain the failed link with max weight
+      for (auto it = itPaths.begin(); it != itPaths.end();)
+      {
+        if (std::find(it->path.links.begin(), it->path.links.end(), maxLink) !=
+            it->path.links.end())
+        {
+          it = itPaths.erase(it);
+        }
+        else
+        {
+          it++;
+        }
+      }
+    }
+  } while (maxWeight > wthresh);
+
+  return badLinks;
+}
+
+// The link weights of AccumulateLinkWeights, updated as paths are removed instead of recomputed.
+// Each link keeps the number of its remaining paths per distinct path factor, and the paths over a
+// removed link are found via a link to paths index, so only the links on them are updated. A log
+// weight is the sum of the counts times the log factors, in a fixed order, so links over the same
+// paths counts get exactly equal weights. Normalization divides all topology links by the same sum,
+// it is kept apart as a log-sum-exp over the topology links. The weights equal those of
+// AccumulateLinkWeights on the remaining paths up to floating point rounding.
+class IncrementalLinkWeights
+{
+public:
+  /// @brief Returns nullopt if the weights cannot be updated incrementally: non-positive factors
+  /// have no log, and with normalization links that are not in all_links are normalized differently
+  template <typename IncFactor>
+  static std::optional<IncrementalLinkWeights> Create(const ClassPathVec &paths, const LinkVec &all_links,
+                                                      IncFactor incFactor, double wdec, double normalization)
+  {
+    IncrementalLinkWeights w(paths, all_links, normalization == 1.0);
+    const DenseLinkIndex &index = w.m_index;
+    if (w.m_normalize && index.numTopologyLinks < index.links.size())
+      return std::nullopt;
+
+    // Group the paths by their factor
+    std::map<double, uint32_t> factorClassOf;
+    w.m_pathFactorClasses.assign(paths.size(), 0);
+    for (size_t p = 0; p < paths.size(); p++)
+    {
+      if (paths[p].path.links.size() == 0)
+        continue;  // Skip empty paths to prevent division by zero
+      std::optional<double> inc_factor = incFactor(paths[p]);
+      double factor = inc_factor ? *inc_factor : wdec;
+      if (!(factor > 0))
+        return std::nullopt;
+      auto res = factorClassOf.emplace(factor, w.m_logFactors.size());
+      if (res.second)
+        w.m_logFactors.push_back(std::log(factor));
+      w.m_pathFactorClasses[p] = res.first->second;
+    }
+    w.m_numClasses = w.m_logFactors.size();
+
+    // Remaining paths over each link, in total and per factor class
+    w.m_pathCounts.assign(index.links.size(), 0);
+    w.m_classCounts.assign(index.links.size() * w.m_numClasses, 0);
+    w.m_linkPaths.resize(index.links.size());
+    w.m_removed.assign(paths.size(), 1);
+    for (size_t p = 0; p < paths.size(); p++)
+    {
+      if (paths[p].path.links.size() == 0)
+        continue;
+      w.m_removed[p] = 0;
+      w.m_remainingPaths++;
+      for (uint32_t k = index.pathOffsets[p]; k < index.pathOffsets[p + 1]; k++)
+      {
+        uint32_t i = index.pathLinks[k];
+        w.m_pathCounts[i]++;
+        w.m_classCounts[i * w.m_numClasses + w.m_pathFactorClasses[p]]++;
+        w.m_linkPaths[i].push_back(p);
+      }
+    }
+
+    w.m_logWeights.resize(index.links.size());
+    for (uint32_t i = 0; i < index.links.size(); i++)
+      w.m_logWeights[i] = w.CalculateLogWeight(i);
+    w.m_changed.assign(index.links.size(), 0);
+    return w;
+  }
+
+  const DenseLinkIndex &GetIndex() const { return m_index; }
+  size_t GetRemainingPaths() const { return m_remainingPaths; }
+
+  // Without normalization, only links on remaining paths have a weight
+  bool HasWeight(uint32_t i) const
+  {
+    return m_pathCounts[i] > 0 || (m_normalize && i < m_index.numTopologyLinks);
+  }
+  /// @brief The log weight of a link before normalization
+  double GetLogWeight(uint32_t i) const { return m_logWeights[i]; }
+  /// @brief The log of the sum all weights are divided by, 0 without normalization
+  double GetLogNormalization() const
+  {
+    return m_normalize ? LogSumExp(m_logWeights, m_index.topologyLinks) : 0.0;
+  }
+
+  /// @brief The normalized weights, as AccumulateLinkWeights returns them for the remaining paths
+  std::map<Link, double> GetWeights() const
+  {
+    std::vector<double> weights(m_index.links.size());
+    std::vector<char> hasWeight(m_index.links.size(), 0);
+    if (m_remainingPaths > 0)
+    {
+      double logNormalization = GetLogNormalization();
+      for (uint32_t i = 0; i < m_index.links.size(); i++)
+      {
+        weights[i] = std::exp(m_logWeights[i] - logNormalization);
+        hasWeight[i] = HasWeight(i);
+      }
+    }
+    return m_index.ToMap(weights, hasWeight);
+  }
+
+  /// @brief Removes the remaining paths over a link, calls onChanged with each link whose weight
+  /// changed once all weights are updated
+  template <typename OnChanged>
+  void RemovePaths(uint32_t link, OnChanged onChanged)
+  {
+    m_changedLinks.clear();
+    for (uint32_t p : m_linkPaths[link])
+    {
+      if (m_removed[p])
+        continue;
+      m_removed[p] = 1;
+      m_remainingPaths--;
+      for (uint32_t k = m_index.pathOffsets[p]; k < m_index.pathOffsets[p + 1]; k++)
+      {
+        uint32_t i = m_index.pathLinks[k];
+        m_pathCounts[i]--;
+        m_classCounts[i * m_numClasses + m_pathFactorClasses[p]]--;
+        if (!m_changed[i])
+        {
+          m_changed[i] = 1;
+          m_changedLinks.push_back(i);
+        }
+      }
+    }
+    for (uint32_t i : m_changedLinks)
+    {
+      m_changed[i] = 0;
+      m_logWeights[i] = CalculateLogWeight(i);
+    }
+    for (uint32_t i : m_changedLinks)
+      onChanged(i);
+  }
+
+private:
+  IncrementalLinkWeights(const ClassPathVec &paths, const LinkVec &all_links, bool normalize)
+      : m_index(paths, all_links),
+        m_normalize(normalize),
+        m_logInitWeight(std::log(normalize ? 1.0 / all_links.size() : 1.0))
+  {
+  }
+
+  double CalculateLogWeight(uint32_t i) const
+  {
+    double logWeight = m_logInitWeight;
+    for (size_t c = 0; c < m_numClasses; c++)
+      logWeight += m_classCounts[i * m_numClasses + c] * m_logFactors[c];
+    return logWeight;
+  }
+
+  DenseLinkIndex m_index;
+  bool m_normalize;
+  double m_logInitWeight;
+  size_t m_numClasses = 0;
+  std::vector<double> m_logFactors;
+  std::vector<uint32_t> m_pathFactorClasses;
+  std::vector<uint32_t> m_pathCounts;
+  std::vector<uint32_t> m_classCounts;
+  std::vector<std::vector<uint32_t>> m_linkPaths;
+  std::vector<char> m_removed;
+  size_t m_remainingPaths = 0;
+  std::vector<double> m_logWeights;
+  std::vector<char> m_changed;
+  std::vector<uint32_t> m_changedLinks;
+};
+
+// Repeatedly marks the link with the highest weight as failed and removes all paths over it, until
+// no weight exceeds wthresh. The weights are updated with IncrementalLinkWeights instead of being
+// recomputed after every removal. The link with the highest weight is taken from a max heap, ties go
+// to the smallest link. Normalization divides all weights by the same sum, so it is only applied to
+// the maximum. Falls back to the full recomputation where the weights cannot be updated.
+template <typename IncFactor>
+LinkSet IterativeWeightedLinks(const ClassPathVec &paths, const LinkVec &all_links, IncFactor incFactor,
+                               double wdec, double wthresh, double normalization)
+{
+  std::optional<IncrementalLinkWeights> weights =
+      IncrementalLinkWeights::Create(paths, all_links, incFactor, wdec, normalization);
+  if (!weights)
+    return IterativeWeightedLinks_Recompute(paths, all_links, incFactor, wdec, wthresh, normalization);
+  const DenseLinkIndex &index = weights->GetIndex();
+
+  typedef std::pair<double, uint32_t> HeapEntry;  // Log weight when pushed, link index
+  auto lowerPriority = [&](const HeapEntry &a, const HeapEntry &b) {
+    if (a.first != b.first)
+      return a.first < b.first;
+    return index.links[a.second] > index.links[b.second];
+  };
+  std::priority_queue<HeapEntry, std::vector<HeapEntry>, decltype(lowerPriority)> heap(lowerPriority);
+  for (uint32_t i = 0; i < index.links.size(); i++)
+  {
+    if (weights->HasWeight(i))
+      heap.emplace(weights->GetLogWeight(i), i);
+  }
+
+  LinkSet badLinks;
+  while (weights->GetRemainingPaths() > 0)
+  {
+    // Skip entries of links whose weight changed since they were pushed
+    while (!heap.empty() && (heap.top().first != weights->GetLogWeight(heap.top().second) ||
+                             !weights->HasWeight(heap.top().second)))
+      heap.pop();
+    if (heap.empty())
+      break;
+    uint32_t maxLink = heap.top().second;
+    double logMaxWeight = weights->GetLogWeight(maxLink) - weights->GetLogNormalization();
+    if (!(std::exp(logMaxWeight) > wthresh))
+      break;
+    // A link that was already marked has no paths left, the iteration would not progress
+    if (!badLinks.insert(index.links[maxLink]).second)
+      break;
+
+    // Remove all paths that contain the failed link with max weight
+    weights->RemovePaths(maxLink, [&](uint32_t i) {
+      if (weights->HasWeight(i))
+        heap.emplace(weights->GetLogWeight(i), i);
+    });
+  }
+  return badLinks;
+}
+
+// Log domain variant of AccumulateLinkWeights, returns the log weights of the links. The weight of a
+// link is its initial weight times the factors of its paths, so the log weights are summed in one
+// pass over the path links. Normalization divides all topology links by the same sum after every
+// path, which amounts to dividing by the sum of the final weights, so it is applied once at the end as
+// a log-sum-exp. Returns nullopt if that does not hold: for non-positive factors, and with
+// normalization for links that are not in all_links, which start into the normalization later.
+template <typename IncFactor>
+std::optional<std::map<Link, double>> AccumulateLogLinkWeights(const ClassPathVec &paths, const LinkVec &all_links,
+                                                               IncFactor incFactor, double wdec, double normalization)
+{
+  DenseLinkIndex index(paths, all_links);
+  const uint32_t *pathLinks = index.pathLinks.data();
+  const bool normalize = normalization == 1.0;
+  if (normalize && index.numTopologyLinks < index.links.size())
+    return std::nullopt;
+
+  std::vector<double> logWeights(index.links.size(), std::log(normalize ? 1.0 / all_links.size() : 1.0));
+  std::vector<char> hasWeight(index.links.size(), 0);
+  bool hasPaths = false;
+  for (size_t p = 0; p < paths.size(); p++)
+  {
+    if (paths[p].path.links.size() == 0)
+      continue;  // Skip empty paths to prevent division by zero
+    std::optional<double> inc_factor = incFactor(paths[p]);
+    double factor = inc_factor ? *inc_factor : wdec;
+    if (!(factor > 0))
+      return std::nullopt;
+    double logFactor = std::log(factor);
+    hasPaths = true;
+    for (uint32_t k = index.pathOffsets[p]; k < index.pathOffsets[p + 1]; k++)
+    {
+      logWeights[pathLinks[k]] += logFactor;
+      hasWeight[pathLinks[k]] = 1;
+    }
+  }
+  if (normalize && hasPaths)
+  {
+    double logSum = LogSumExp(logWeights, index.topologyLinks);
+    for (size_t i = 0; i < index.numTopologyLinks; i++)
+    {
+      logWeights[i] -= logSum;
+      hasWeight[i] = 1;
+    }
+  }
+  return index.ToMap(logWeights, hasWeight);
+}
+
+// Log domain variant of AccumulateLinkWeights_BadPathsOnly. Every failed path decreases all topology
+// links by wdec, the links on it get the increase factor instead, so the log weight of a link is
+// the number of failed paths times log(wdec) plus log(inc_factor / wdec) of each failed path over
+// it. Returns nullopt for non-positive factors, and if all_links has duplicates, which are
+// multiplied twice per path.
+template <typename IncFactor>
+std::optional<std::map<Link, double>> AccumulateLogLinkWeights_BadPathsOnly(const ClassPathVec &paths, const LinkVec &all_links,
+                                                                            IncFactor incFactor, double wdec, double normalization)
+{
+  DenseLinkIndex index(paths, all_links);
+  const uint32_t *pathLinks = index.pathLinks.data();
+  const bool normalize = normalization == 1.0;
+  if (!(wdec > 0) || index.topologyLinks.size() != index.numTopologyLinks)
+    return std::nullopt;
+
+  const double logWdec = std::log(wdec);
+  std::vector<double> logWeights(index.links.size(), 0.0);
+  std::vector<char> onPath(index.links.size(), 0);
+  size_t failedPaths = 0;
+  for (size_t p = 0; p < paths.size(); p++)
+  {
+    if (paths[p].path.links.size() == 0)
+      continue;  // Skip empty paths to prevent division by zero
+    std::optional<double> inc_factor = incFactor(paths[p]);
+    if (!inc_factor)
+      continue;
+    if (!(*inc_factor > 0))
+      return std::nullopt;
+    double logIncrease = std::log(*inc_factor) - logWdec;
+    failedPaths++;
+    // Links that occur several times on a path are only increased once
+    for (uint32_t k = index.pathOffsets[p]; k < index.pathOffsets[p + 1]; k++)
+    {
+      if (!onPath[pathLinks[k]])
+      {
+        onPath[pathLinks[k]] = 1;
+        logWeights[pathLinks[k]] += logIncrease;
+      }
+    }
+    for (uint32_t k = index.pathOffsets[p]; k < index.pathOffsets[p + 1]; k++)
+      onPath[pathLinks[k]] = 0;
+  }
+
+  // Only topology links get a weight, and only once a failed path was seen
+  std::vector<char> hasWeight(index.links.size(), 0);
+  if (failedPaths == 0)
+    return index.ToMap(logWeights, hasWeight);
+  const double logBase = std::log(normalize ? 1.0 / all_links.size() : 1.0) + failedPaths * logWdec;
+  for (size_t i = 0; i < index.numTopologyLinks; i++)
+  {
+    logWeights[i] += logBase;
+    hasWeight[i] = 1;
+  }
+  if (normalize)
+  {
+    double logSum = LogSumExp(logWeights, index.topologyLinks);
+    for (size_t i = 0; i < index.numTopologyLinks; i++)
+      logWeights[i] -= logSum;
+  }
+  return index.ToMap(logWeights, hasWeight);
+}
+
+// Links whose log weight exceeds log(wthresh), all weights are positive
+inline LinkSet LinksAboveLogThreshold(const std::map<Link, double> &logWeights, double wthresh)
+{
+  LinkSet badLinks;
+  for (const auto &lw : logWeights)
+  {
+    if (wthresh <= 0 || lw.second > std::log(wthresh))
+      badLinks.insert(lw.first);
+  }
+  return badLinks;
+}
+
+inline std::map<Link, double> CalculateLinkCounts(const ClassPathVec &paths)
+{
+  DenseLinkIndex index(paths, LinkVec());
+  std::vector<uint32_t> counts(index.links.size(), 0);
+  double overall_count = 0.0;
+  for (size_t p = 0; p < paths.size(); p++)
+  {
+    if (paths[p].path.links.size() == 0)
+      continue;  // Skip empty paths to prevent division by zero
+    if (paths[p].failed)
+    {
+      // Count the overall number of used measurements
+      overall_count += 1;
+
+      // Increase the count for each link contained on the failed path
+      for (uint32_t k = index.pathOffsets[p]; k < index.pathOffsets[p + 1]; k++)
+        counts[index.pathLinks[k]]++;
+    }
+  }
+
+  // Divide the link count by the overall number of faulty measurements to normalize result to [0,1]
+  std::vector<double> linkCounts(index.links.size());
+  std::vector<char> hasCount(index.links.size());
+  for (size_t i = 0; i < index.links.size(); i++)
+  {
+    linkCounts[i] = counts[i] / overall_count;
+    hasCount[i] = counts[i] > 0;
+  }
+  return index.ToMap(linkCounts, hasCount);
+}
+
+}  // namespace link_weights
+}  // namespace analysis
+
+#endif  // LINK_WEIGHTS_H
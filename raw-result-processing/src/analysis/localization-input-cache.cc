@@ -0,0 +1,166 @@
+#include "localization-input-cache.h"
+
+namespace analysis {
+
+template <typename Key, typename T>
+LocalizationInputCache::Entry<T> LocalizationInputCache::FindOrCreate(
+    EntryMap<Key, T> &entryMap, const Key &key, std::promise<std::shared_ptr<const T>> &promise,
+    bool &created)
+{
+  auto it = entryMap.entries.find(key);
+  created = it == entryMap.entries.end();
+  if (!created)
+    return it->second;
+
+  it = entryMap.entries.emplace(key, promise.get_future().share()).first;
+  entryMap.order.push_back(it);
+  // Threads waiting for a dropped entry hold a copy of it, and its builder still resolves it
+  if (m_maxEntries > 0 && entryMap.order.size() > m_maxEntries)
+  {
+    entryMap.entries.erase(entryMap.order.front());
+    entryMap.order.pop_front();
+  }
+  return it->second;
+}
+
+template <typename T, typename Key, typename Build>
+std::shared_ptr<const T> LocalizationInputCache::GetOrBuild(EntryMap<Key, T> &entryMap,
+                                                            const Key &key, Build &&build)
+{
+  std::promise<std::shared_ptr<const T>> promise;
+  Entry<T> entry;
+  bool owner = false;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    entry = FindOrCreate(entryMap, key, promise, owner);
+  }
+  // Build outside of the lock, so that different sets are built concurrently
+  if (owner)
+  {
+    try
+    {
+      promise.set_value(std::make_shared<const T>(build()));
+    }
+    catch (...)
+    {
+      promise.set_exception(std::current_exception());
+    }
+  }
+  return entry.get();
+}
+
+std::shared_ptr<const PathMeasurementSet> LocalizationInputCache::GetPathMeasurementSet(
+    const simdata::SimResultSet &srs, const std::set<uint32_t> &observerIds,
+    const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap, const EfmBitSet &bitCombis,
+    uint32_t flowLengthTh, ClassificationMode classificationMode, double time_filter)
+{
+  MeasurementKey key(&srs, observerIds, flowSelectionMap, bitCombis, flowLengthTh,
+                     classificationMode, time_filter);
+  return GetOrBuild(m_pathMeasurementSets, key, [&]() {
+    return ClassifiedPathSet::MeasureAll(srs, observerIds, flowSelectionMap, bitCombis,
+                                         flowLengthTh, classificationMode, time_filter);
+  });
+}
+
+std::vector<std::shared_ptr<const ClassifiedPathSet>> LocalizationInputCache::GetClassifiedPathSets(
+    const simdata::SimResultSet &srs, const std::set<uint32_t> &observerIds,
+    const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap, const EfmBitSet &bitCombis,
+    const std::vector<ClassificationThresholds> &thresholds, uint32_t flowLengthTh,
+    ClassificationMode classificationMode, const std::string &classification_base_id,
+    double smallFailFactor, double largeFailFactor, double time_filter)
+{
+  // Create the entries of the thresholds that were not requested before, this thread builds them
+  std::vector<Entry<ClassifiedPathSet>> entries;
+  std::vector<std::promise<std::shared_ptr<const ClassifiedPathSet>>> promises;
+  std::vector<ClassificationThresholds> missingThresholds;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &th : thresholds)
+    {
+      ClassificationKey key(&srs, observerIds, flowSelectionMap, bitCombis, th.lossRateTh,
+                            th.delayTh, flowLengthTh, classificationMode, classification_base_id,
+                            smallFailFactor, largeFailFactor, time_filter);
+      std::promise<std::shared_ptr<const ClassifiedPathSet>> promise;
+      bool created = false;
+      entries.push_back(FindOrCreate(m_classifiedPathSets, key, promise, created));
+      if (created)
+      {
+        promises.push_back(std::move(promise));
+        missingThresholds.push_back(th);
+      }
+    }
+  }
+
+  size_t built = 0;
+  try
+  {
+    if (!missingThresholds.empty())
+    {
+      auto measurements = GetPathMeasurementSet(srs, observerIds, flowSelectionMap, bitCombis,
+                                                flowLengthTh, classificationMode, time_filter);
+      std::vector<ClassifiedPathSet> sets =
+          ClassifiedPathSet::Classify(*measurements, missingThresholds, classification_base_id,
+                                      smallFailFactor, largeFailFactor);
+      for (; built < sets.size(); built++)
+        promises[built].set_value(std::make_shared<const ClassifiedPathSet>(std::move(sets[built])));
+    }
+  }
+  catch (...)
+  {
+    for (; built < promises.size(); built++)
+      promises[built].set_exception(std::current_exception());
+  }
+
+  std::vector<std::shared_ptr<const ClassifiedPathSet>> sets;
+  for (auto &entry : entries)
+    sets.push_back(entry.get());
+  return sets;
+}
+
+std::shared_ptr<const ClassifiedPathSet> LocalizationInputCache::GetClassifiedPathSet(
+    const simdata::SimResultSet &srs, const std::set<uint32_t> &observerIds,
+    const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap, const EfmBitSet &bitCombis,
+    double lossRateTh, uint32_t delayTh, uint32_t flowLengthTh,
+    ClassificationMode classificationMode, const std::string &classification_base_id,
+    double smallFailFactor, double largeFailFactor, double time_filter)
+{
+  return GetClassifiedPathSets(srs, observerIds, flowSelectionMap, bitCombis,
+                               {ClassificationThresholds{lossRateTh, delayTh}}, flowLengthTh,
+                               classificationMode, classification_base_id, smallFailFactor,
+                               largeFailFactor, time_filter)
+      .front();
+}
+
+std::shared_ptr<const LinkCharacteristicSet> LocalizationInputCache::GetLinkCharacteristicSet(
+    const simdata::SimResultSet &srs, const std::set<uint32_t> &observerIds,
+    const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap, const EfmBitSet &bitCombis,
+    uint32_t flowLengthTh, bool core_links_only, ClassificationMode classificationMode,
+    const std::string &classification_base_id, double time_filter)
+{
+  CharacterizationKey key(&srs, observerIds, flowSelectionMap, bitCombis, flowLengthTh,
+                          core_links_only, classificationMode, classification_base_id,
+                          time_filter);
+  return GetOrBuild(m_linkCharacteristicSets, key, [&]() {
+    return LinkCharacteristicSet::CharacterizeAll(srs, observerIds, flowSelectionMap, bitCombis,
+                                                  flowLengthTh, core_links_only,
+                                                  classificationMode, classification_base_id,
+                                                  time_filter);
+  });
+}
+
+std::shared_ptr<const CombinedFlowSet> LocalizationInputCache::GetCombinedFlowSet(
+    const simdata::SimResultSet &srs, const std::set<uint32_t> &observerIds,
+    const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap, const EfmBitSet &bitCombis,
+    uint32_t flowLengthTh, ClassificationMode classificationMode,
+    const std::string &classification_base_id, double time_filter)
+{
+  CombinationKey key(&srs, observerIds, flowSelectionMap, bitCombis, flowLengthTh,
+                     classificationMode, classification_base_id, time_filter);
+  return GetOrBuild(m_combinedFlowSets, key, [&]() {
+    return CombinedFlowSet::CharacterizeAll(srs, observerIds, flowSelectionMap, bitCombis,
+                                            flowLengthTh, classificationMode,
+                                            classification_base_id, time_filter);
+  });
+}
+
+}  // namespace analysis
@@ -0,0 +1,124 @@
+#ifndef LOCALIZATION_INPUT_CACHE_H
+#define LOCALIZATION_INPUT_CACHE_H
+
+#include <sim-result-set.h>
+#include "classified-path-set.h"
+#include "link-characteristic-set.h"
+#include "combined-flow-set.h"
+
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace analysis {
+
+/// @brief Memoizes the path measurements, classified path sets, link characteristic sets and
+/// combined flow sets of one analysis run, so that configs with the same inputs build them only
+/// once. Classified path sets that only differ in their thresholds share the path measurements. The
+/// sets are keyed by all their inputs, the result set by its address, so the cache must not outlive
+/// the (filtered) result sets it was used with. Can be used by several threads concurrently, each
+/// set is built by the first thread that requests it while the others wait for it.
+///
+/// A set holds the measurements of all selected flows of an observer set, so each one is about as
+/// large as the spin bit and loss measurements of those flows. Random flow selections create new
+/// keys for every config, so each kind of set is limited to maxEntries sets. Beyond that, the
+/// sets requested first are dropped. Callers keep the sets they got until they release them.
+class LocalizationInputCache
+{
+public:
+  static constexpr size_t DEFAULT_MAX_ENTRIES = 256;
+
+  /// @param maxEntries The number of sets of each kind that are kept, 0 keeps all sets
+  explicit LocalizationInputCache(size_t maxEntries = DEFAULT_MAX_ENTRIES)
+      : m_maxEntries(maxEntries)
+  {
+  }
+
+  std::shared_ptr<const PathMeasurementSet> GetPathMeasurementSet(
+      const simdata::SimResultSet &srs, const std::set<uint32_t> &observerIds,
+      const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap, const EfmBitSet &bitCombis,
+      uint32_t flowLengthTh, ClassificationMode classificationMode, double time_filter);
+
+  /// @brief Returns the classified path sets for several thresholds, in the same order. The sets
+  /// that are not cached yet are classified in one pass over the measured paths.
+  std::vector<std::shared_ptr<const ClassifiedPathSet>> GetClassifiedPathSets(
+      const simdata::SimResultSet &srs, const std::set<uint32_t> &observerIds,
+      const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap, const EfmBitSet &bitCombis,
+      const std::vector<ClassificationThresholds> &thresholds, uint32_t flowLengthTh,
+      ClassificationMode classificationMode, const std::string &classification_base_id,
+      double smallFailFactor, double largeFailFactor, double time_filter);
+
+  std::shared_ptr<const ClassifiedPathSet> GetClassifiedPathSet(
+      const simdata::SimResultSet &srs, const std::set<uint32_t> &observerIds,
+      const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap, const EfmBitSet &bitCombis,
+      double lossRateTh, uint32_t delayTh, uint32_t flowLengthTh,
+      ClassificationMode classificationMode, const std::string &classification_base_id,
+      double smallFailFactor, double largeFailFactor, double time_filter);
+
+  std::shared_ptr<const LinkCharacteristicSet> GetLinkCharacteristicSet(
+      const simdata::SimResultSet &srs, const std::set<uint32_t> &observerIds,
+      const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap, const EfmBitSet &bitCombis,
+      uint32_t flowLengthTh, bool core_links_only, ClassificationMode classificationMode,
+      const std::string &classification_base_id, double time_filter);
+
+  std::shared_ptr<const CombinedFlowSet> GetCombinedFlowSet(
+      const simdata::SimResultSet &srs, const std::set<uint32_t> &observerIds,
+      const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap, const EfmBitSet &bitCombis,
+      uint32_t flowLengthTh, ClassificationMode classificationMode,
+      const std::string &classification_base_id, double time_filter);
+
+private:
+  // Resolved once the thread that created the entry has built the value
+  template <typename T>
+  using Entry = std::shared_future<std::shared_ptr<const T>>;
+
+  // The entries of one kind of set and the order they were created in
+  template <typename Key, typename T>
+  struct EntryMap
+  {
+    std::map<Key, Entry<T>> entries;
+    std::deque<typename std::map<Key, Entry<T>>::iterator> order;
+  };
+
+  // Returns the entry of the key, creates it if the key was not requested before (or was dropped).
+  // The mutex has to be held.
+  template <typename Key, typename T>
+  Entry<T> FindOrCreate(EntryMap<Key, T> &entryMap, const Key &key,
+                        std::promise<std::shared_ptr<const T>> &promise, bool &created);
+
+  // Returns the value of the key, builds it if it was not built or requested before
+  template <typename T, typename Key, typename Build>
+  std::shared_ptr<const T> GetOrBuild(EntryMap<Key, T> &entryMap, const Key &key, Build &&build);
+
+  typedef std::tuple<const simdata::SimResultSet *, std::set<uint32_t>,
+                     std::map<uint32_t, std::set<uint32_t>>, EfmBitSet, uint32_t,
+                     ClassificationMode, double>
+      MeasurementKey;
+  typedef std::tuple<const simdata::SimResultSet *, std::set<uint32_t>,
+                     std::map<uint32_t, std::set<uint32_t>>, EfmBitSet, double, uint32_t, uint32_t,
+                     ClassificationMode, std::string, double, double, double>
+      ClassificationKey;
+  typedef std::tuple<const simdata::SimResultSet *, std::set<uint32_t>,
+                     std::map<uint32_t, std::set<uint32_t>>, EfmBitSet, uint32_t, bool,
+                     ClassificationMode, std::string, double>
+      CharacterizationKey;
+  typedef std::tuple<const simdata::SimResultSet *, std::set<uint32_t>,
+                     std::map<uint32_t, std::set<uint32_t>>, EfmBitSet, uint32_t,
+                     ClassificationMode, std::string, double>
+      CombinationKey;
+
+  const size_t m_maxEntries;
+  // Guards the maps, not the entries
+  std::mutex m_mutex;
+  EntryMap<MeasurementKey, PathMeasurementSet> m_pathMeasurementSets;
+  EntryMap<ClassificationKey, ClassifiedPathSet> m_classifiedPathSets;
+  EntryMap<CharacterizationKey, LinkCharacteristicSet> m_linkCharacteristicSets;
+  EntryMap<CombinationKey, CombinedFlowSet> m_combinedFlowSets;
+};
+
+}  // namespace analysis
+
+#endif  // LOCALIZATION_INPUT_CACHE_H
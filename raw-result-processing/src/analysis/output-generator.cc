@@ -82,6 +82,39 @@ void OutputGenerator::AddLocalizationResults(simdata::SimFilter& filter,
   m_localizationResults.emplace_back(filter, clfcConfig, result, flowSelectionStrategy);
 }
 
+namespace {
+
+// Moves all entries of source into target, entries of source replace equal ones in target
+template <typename ResultMap>
+void MergeResults(ResultMap& target, ResultMap& source)
+{
+  for (auto& [observerId, idResults] : source)
+  {
+    for (auto& [id, results] : idResults)
+    {
+      for (auto& [resultType, value] : results)
+        target[observerId][id][resultType] = std::move(value);
+    }
+  }
+  source.clear();
+}
+
+}  // namespace
+
+void OutputGenerator::Merge(OutputGenerator& other)
+{
+  MergeResults(m_observerFlowResults, other.m_observerFlowResults);
+  MergeResults(m_observerPathResults, other.m_observerPathResults);
+  MergeResults(m_observerActiveResults, other.m_observerActiveResults);
+  MergeResults(m_observerFlowResultsRawValues, other.m_observerFlowResultsRawValues);
+  MergeResults(m_observerActiveResultsRawValues, other.m_observerActiveResultsRawValues);
+
+  m_localizationResults.insert(m_localizationResults.end(),
+                               std::make_move_iterator(other.m_localizationResults.begin()),
+                               std::make_move_iterator(other.m_localizationResults.end()));
+  other.m_localizationResults.clear();
+}
+
 void OutputGenerator::CreatePathAndDump(const json& outputJson, bool pretty)
 {
   std::filesystem::path filePath = m_outputFile;
@@ -105,14 +138,8 @@ void OutputGenerator::StoreFlowPathMap(json& outputJson)
   json flowPathMap;
   for (auto flowInfo : m_simResultSet->GetObserverFlowInfo())
   {
-    std::vector<simdata::ObsvVantagePointPointer> path =
-        m_simResultSet->CalculateFlowPath(flowInfo.first);
-    std::vector<uint32_t> pathIds;
-    for (auto it = path.begin(); it != path.end(); it++)
-    {
-      pathIds.push_back((*it)->m_nodeId);
-    }
-    flowPathMap[flowInfo.second.Serialize()] = pathIds;
+    flowPathMap[flowInfo.second.Serialize()] =
+        m_simResultSet->GetFlowPath(flowInfo.first).observerIds;
   }
   outputJson["flowPathMap"] = flowPathMap;
 }
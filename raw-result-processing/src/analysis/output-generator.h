@@ -93,7 +93,7 @@ class OutputGenerator
   using json = nlohmann::json;
 
 public:
-  OutputGenerator(simdata::SimResultSetPointer simResultSet, const std::string &m_outputFile)
+  OutputGenerator(simdata::ConstSimResultSetPointer simResultSet, const std::string &m_outputFile)
       : m_outputFile(m_outputFile), m_simResultSet(simResultSet)
   {
   }
@@ -116,9 +116,14 @@ public:
                               std::vector<LocalizationResult> &result,
                               FlowSelectionStrategyWithParams flowSelectionStrategy);
 
+  /// @brief Moves all results of other into this generator, as if they had been added after the
+  /// results stored so far (measurement results of other replace equal ones, localization results
+  /// are appended). Used to collect the results of analyses that ran in separate generators.
+  void Merge(OutputGenerator &other);
+
 protected:
   std::string m_outputFile;
-  simdata::SimResultSetPointer m_simResultSet;
+  simdata::ConstSimResultSetPointer m_simResultSet;
   // Maps observerId -> flowId -> resultType -> resultValue
   typedef std::map<uint32_t, std::map<uint32_t, std::map<ResultType, double>>>
       ObserverFlowResultMap;
@@ -1,7 +1,15 @@
 #ifndef HELPER_TEMPLATES_H
 #define HELPER_TEMPLATES_H
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
 #include <vector>
 
 template <typename T>
@@ -31,4 +39,116 @@ double CalcSTD(const std::vector<T> &values)
   return sqrt(sum / values.size());
 }
 
+/// @brief Calls fn(i) for all i in [0, count) on up to numThreads threads. Each thread takes the
+/// next index nobody took yet, so expensive and cheap calls balance out. The first exception thrown
+/// by fn is rethrown after all threads stopped, the remaining indices are skipped then.
+template <typename F>
+void ParallelFor(size_t count, uint32_t numThreads, F &&fn)
+{
+  if (numThreads > count)
+    numThreads = count;
+  if (numThreads <= 1)
+  {
+    for (size_t i = 0; i < count; i++) fn(i);
+    return;
+  }
+
+  std::atomic<size_t> next(0);
+  std::mutex errorMutex;
+  std::exception_ptr error;
+
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++)
+    {
+      try
+      {
+        fn(i);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+          error = std::current_exception();
+        // Let the other threads run out of indices
+        next = count;
+        return;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (uint32_t t = 0; t < numThreads; t++)
+  {
+    workers.emplace_back(worker);
+  }
+  for (auto &w : workers)
+  {
+    w.join();
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+/// @brief Writes a line to the stream under a lock shared by all callers, so that the messages of
+/// concurrent threads do not interleave
+inline void LogLine(std::ostream &os, const std::string &line)
+{
+  static std::mutex logMutex;
+  std::lock_guard<std::mutex> lock(logMutex);
+  os << line << std::endl;
+}
+
+/// @brief Blocking FIFO queue with a maximum size to hand over work between threads
+template <typename T>
+class BoundedQueue
+{
+public:
+  explicit BoundedQueue(size_t capacity) : m_capacity(capacity > 0 ? capacity : 1) {}
+
+  /// @brief Adds an item, blocks while the queue is full
+  /// @return false if the queue was closed and the item was not added
+  bool Push(T item)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notFull.wait(lock, [this]() { return m_closed || m_items.size() < m_capacity; });
+    if (m_closed)
+      return false;
+    m_items.push_back(std::move(item));
+    m_notEmpty.notify_one();
+    return true;
+  }
+
+  /// @brief Removes the oldest item, blocks while the queue is empty and not closed
+  /// @return The item or std::nullopt if the queue was closed and no items are left
+  std::optional<T> Pop()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notEmpty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+    if (m_items.empty())
+      return std::nullopt;
+    T item = std::move(m_items.front());
+    m_items.pop_front();
+    m_notFull.notify_one();
+    return item;
+  }
+
+  /// @brief Closes the queue: further pushes fail and pops return the remaining items
+  void Close()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+    m_notFull.notify_all();
+    m_notEmpty.notify_all();
+  }
+
+private:
+  const size_t m_capacity;
+  std::deque<T> m_items;
+  bool m_closed = false;
+  std::mutex m_mutex;
+  std::condition_variable m_notFull;
+  std::condition_variable m_notEmpty;
+};
+
 #endif  // HELPER_TEMPLATES_H
\ No newline at end of file
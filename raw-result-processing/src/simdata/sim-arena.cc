@@ -0,0 +1,9 @@
+#include "sim-arena.h"
+
+namespace simdata {
+
+// The upstream resource is the heap (new_delete_resource), it receives the blocks back when the
+// arena is destroyed
+SimArena::SimArena() : m_resource(INITIAL_BLOCK_SIZE) {}
+
+}  // namespace simdata
@@ -0,0 +1,108 @@
+#ifndef SIM_ARENA_H
+#define SIM_ARENA_H
+
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace simdata {
+
+class SimArena;
+typedef std::shared_ptr<SimArena> SimArenaPointer;
+
+// Monotonic memory arena for the vantage points, flows, paths, and ping pairs of one imported
+// result set. Allocating is a pointer bump into large blocks and freeing is a no-op; all blocks are
+// released at once when the last object allocated from the arena is destroyed.
+//
+// An arena is not thread-safe. Every result set (and every fragment that is imported concurrently)
+// has its own arena.
+class SimArena
+{
+public:
+  /// @brief Size of the first block, following blocks grow geometrically
+  static constexpr size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+
+  SimArena();
+
+  SimArena(const SimArena &) = delete;
+  SimArena &operator=(const SimArena &) = delete;
+
+  void *Allocate(size_t bytes, size_t alignment) { return m_resource.allocate(bytes, alignment); }
+
+private:
+  std::pmr::monotonic_buffer_resource m_resource;
+};
+
+// Standard allocator that allocates from an arena. Every allocation keeps the arena alive, so
+// objects and containers may outlive the result set whose arena they were allocated from (e.g.,
+// after merging fragments).
+//
+// Without an arena, the allocator uses the global heap. Copies of containers always use the heap,
+// so that filtered copies of imported data do not grow (and pin) the arena of the original.
+template <typename T>
+class SimArenaAllocator
+{
+public:
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  SimArenaAllocator() = default;
+  explicit SimArenaAllocator(SimArenaPointer arena) : m_arena(std::move(arena)) {}
+  template <typename U>
+  SimArenaAllocator(const SimArenaAllocator<U> &other) : m_arena(other.GetArena())
+  {
+  }
+
+  T *allocate(size_t n)
+  {
+    if (m_arena)
+      return static_cast<T *>(m_arena->Allocate(n * sizeof(T), alignof(T)));
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T *p, size_t n)
+  {
+    // Arena memory is released together with the arena
+    if (!m_arena)
+      std::allocator<T>().deallocate(p, n);
+  }
+
+  SimArenaAllocator select_on_container_copy_construction() const { return SimArenaAllocator(); }
+
+  const SimArenaPointer &GetArena() const { return m_arena; }
+
+private:
+  SimArenaPointer m_arena;
+};
+
+template <typename T, typename U>
+bool operator==(const SimArenaAllocator<T> &a, const SimArenaAllocator<U> &b)
+{
+  return a.GetArena() == b.GetArena();
+}
+
+template <typename T, typename U>
+bool operator!=(const SimArenaAllocator<T> &a, const SimArenaAllocator<U> &b)
+{
+  return !(a == b);
+}
+
+// std::map whose nodes are allocated from an arena
+template <typename Key, typename Value>
+using SimArenaMap =
+    std::map<Key, Value, std::less<Key>, SimArenaAllocator<std::pair<const Key, Value>>>;
+
+/// @brief Creates a shared object in an arena (object and reference counts in one allocation)
+/// @param arena The arena, the heap is used if it is nullptr
+template <typename T, typename... Args>
+std::shared_ptr<T> MakeArenaShared(const SimArenaPointer &arena, Args &&...args)
+{
+  return std::allocate_shared<T>(SimArenaAllocator<T>(arena), std::forward<Args>(args)...);
+}
+
+}  // namespace simdata
+
+#endif  // SIM_ARENA_H
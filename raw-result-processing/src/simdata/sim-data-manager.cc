@@ -1,6 +1,9 @@
 #include "sim-data-manager.h"
 
+#include <atomic>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 
 namespace simdata {
 
@@ -38,12 +41,141 @@ bool SimDataManager::ImportResult(simdjson::ondemand::parser &parser, std::strin
     if (it != m_simResultMap.end())
       throw std::runtime_error("Duplicate sim id.");
 
-    SimResultSetPointer srsp = std::make_shared<SimResultSet>(root_obj);
+    SimResultSetPointer srsp = std::make_shared<SimResultSet>(root_obj, m_eventTypes);
     m_simResultMap.insert(std::pair<SimId, SimResultSetPointer>(simId, srsp));
     return true;
   }
 }
 
+uint32_t SimDataManager::ImportResults(const std::vector<std::string> &files, uint32_t numThreads)
+{
+  using namespace simdjson;
+
+  // Per file: the sim id it belongs to, whether it contains the summary, and its content
+  std::vector<SimId> simIds(files.size());
+  // Not std::vector<bool>, since its elements cannot be written concurrently
+  std::vector<uint8_t> isHeader(files.size(), false);
+  std::vector<SimResultSetPointer> results(files.size());
+
+  std::atomic<size_t> nextFile(0);
+  std::mutex errorMutex;
+  std::exception_ptr error;
+
+  auto worker = [&]() {
+    // Parsers are not thread-safe, so each worker needs its own one
+    ondemand::parser parser;
+    for (size_t i = nextFile++; i < files.size(); i = nextFile++)
+    {
+      try
+      {
+        auto jsonstring = padded_string::load(files[i]);
+        ondemand::document doc = parser.iterate(jsonstring);
+        ondemand::object root_obj = doc.get_object();
+
+        std::string_view simIdView;
+        auto err = root_obj["title"].get(simIdView);
+        if (err == NO_SUCH_FIELD)
+        {
+          if (root_obj["title_ref"].get(simIdView) != SUCCESS)
+            throw std::runtime_error("Error while parsing title_ref field.");
+          simIds[i] = std::string(simIdView);
+          results[i] = SimResultSet::ImportFragment(root_obj, m_eventTypes);
+        }
+        else if (err != SUCCESS)
+          throw std::runtime_error("Error while parsing title field.");
+        else
+        {
+          simIds[i] = std::string(simIdView);
+          isHeader[i] = true;
+          results[i] = std::make_shared<SimResultSet>(root_obj, m_eventTypes);
+        }
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+          error = std::current_exception();
+        // Let the other workers run out of files
+        nextFile = files.size();
+        return;
+      }
+    }
+  };
+
+  if (numThreads > files.size())
+    numThreads = files.size();
+  if (numThreads == 0)
+    numThreads = 1;
+  std::vector<std::thread> workers;
+  for (uint32_t t = 0; t < numThreads; t++)
+  {
+    workers.emplace_back(worker);
+  }
+  for (auto &w : workers)
+  {
+    w.join();
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+
+  uint32_t createdSets = 0;
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    if (!isHeader[i])
+      continue;
+    if (m_simResultMap.find(simIds[i]) != m_simResultMap.end())
+      throw std::runtime_error("Duplicate sim id.");
+    m_simResultMap.insert(std::pair<SimId, SimResultSetPointer>(simIds[i], results[i]));
+    createdSets++;
+  }
+
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    if (isHeader[i])
+      continue;
+    auto it = m_simResultMap.find(simIds[i]);
+    if (it == m_simResultMap.end())
+      throw std::runtime_error("title_ref field points to non-existing sim id.");
+    it->second->MergeFragment(*results[i]);
+    results[i].reset();
+  }
+
+  return createdSets;
+}
+
+bool SimDataManager::ImportSnapshot(std::string file, const std::string &key)
+{
+  SimResultSetPointer srsp = SimSnapshot::Read(file, key);
+  if (!srsp)
+    return false;
+
+  if (m_simResultMap.find(srsp->GetSimId()) != m_simResultMap.end())
+    throw std::runtime_error("Duplicate sim id.");
+
+  m_simResultMap.insert(std::pair<SimId, SimResultSetPointer>(srsp->GetSimId(), srsp));
+  return true;
+}
+
+void SimDataManager::WriteSnapshot(SimId id, std::string file, const std::string &key)
+{
+  auto it = m_simResultMap.find(id);
+  if (it == m_simResultMap.end())
+    throw std::runtime_error("Snapshot requested for non-existing sim id.");
+
+  SimSnapshot::Write(*it->second, file, key);
+}
+
+void SimDataManager::ImportIndexed(SimTraceIndexPointer index)
+{
+  if (m_simResultMap.find(index->GetSimId()) != m_simResultMap.end())
+    throw std::runtime_error("Duplicate sim id.");
+
+  SimResultSetPointer srsp = SimResultSet::ImportIndexed(index, m_eventTypes);
+  srsp->LoadVantagePoints(VantagePointType::CLIENT);
+  srsp->LoadVantagePoints(VantagePointType::SERVER);
+  m_simResultMap.insert(std::pair<SimId, SimResultSetPointer>(srsp->GetSimId(), srsp));
+}
 
 bool SimDataManager::GetResultSet(SimId id, SimResultSetPointer &resultSet)
 {
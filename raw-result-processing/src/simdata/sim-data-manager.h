@@ -7,6 +7,8 @@
 #include <string>
 
 #include "sim-result-set.h"
+#include "sim-snapshot.h"
+#include "sim-trace-index.h"
 #include "simdjson.h"
 
 namespace simdata {
@@ -24,6 +26,38 @@ public:
   /// one
   bool ImportResult(simdjson::ondemand::parser &parser, std::string file);
 
+  /// @brief Imports the files of one simulation run concurrently. Every worker thread uses its own
+  /// parser and imports whole files into detached result sets, which are merged afterwards: first
+  /// the file(s) containing a title and summary, then all fragments in the given order.
+  /// @param files The paths to the QLOG json files of the run
+  /// @param numThreads The number of worker threads
+  /// @return The number of newly created result sets
+  uint32_t ImportResults(const std::vector<std::string> &files, uint32_t numThreads);
+
+  /// @brief Imports a simulation result from a snapshot file written by WriteSnapshot
+  /// @param file The path to the snapshot file
+  /// @param key The key of the QLOG files the snapshot has to belong to (see SimSnapshot::CreateKey)
+  /// @return true if a new result set was created, false if there is no valid snapshot
+  bool ImportSnapshot(std::string file, const std::string &key);
+
+  /// @brief Writes an imported simulation result to a snapshot file
+  /// @param id The sim id of the result set
+  /// @param file The path to the snapshot file
+  /// @param key The key of the QLOG files the result set was imported from
+  void WriteSnapshot(SimId id, std::string file, const std::string &key);
+
+  /// @brief Imports the summary as well as all client and server traces of a simulation run using
+  /// its trace index. Observer traces are only imported on demand (see
+  /// SimResultSet::LoadVantagePoints).
+  /// @param index The trace index of the run
+  void ImportIndexed(SimTraceIndexPointer index);
+
+  /// @brief Restricts all following imports to the specified event types, events of other types
+  /// are skipped without being parsed
+  /// @param eventTypes The event types to import, all if not set
+  void SetEventTypes(std::optional<SimEventTypeSet> eventTypes) { m_eventTypes = eventTypes; }
+  const std::optional<SimEventTypeSet> &GetEventTypes() const { return m_eventTypes; }
+
   bool GetResultSet(SimId id, SimResultSetPointer &resultSet);
 
   std::vector<SimId> GetSimIds();
@@ -81,6 +115,8 @@ protected:
   typedef std::map<SimId, SimResultSetPointer> SimResultMap;
   SimResultMap m_simResultMap;
 
+  std::optional<SimEventTypeSet> m_eventTypes;
+
 private:
 };
 
@@ -1,10 +1,24 @@
 #include "sim-events.h"
 
+#include <algorithm>
 #include <iostream>
+#include <memory_resource>
+#include <type_traits>
 
 namespace simdata {
 
 namespace {
+
+// Creates an event from the memory resource, or on the heap if it is nullptr
+template <typename T, typename... Args>
+std::shared_ptr<T> MakeEvent(std::pmr::memory_resource *memory, Args &&...args)
+{
+  if (!memory)
+    return std::make_shared<T>(std::forward<Args>(args)...);
+  return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(memory),
+                                 std::forward<Args>(args)...);
+}
+
 SimEventType StringToEventType(std::string eventString)
 {
   static const std::unordered_map<std::string, SimEventType> mapping = {
@@ -74,9 +88,8 @@ void FilterLBitTriggeredMonitoring(SimEventMap &simEventMap)
   uint32_t packetCountOffset = 0;
   double monitorBeginTime = 0;
 
-  auto lBitSetEvent = std::static_pointer_cast<EfmBitSetPCountEvent>(*lbitIt->second.begin());
-  packetCountOffset = lBitSetEvent->pkt_count;
-  monitorBeginTime = lBitSetEvent->time;
+  packetCountOffset = lbitIt->second->pktCount.front();
+  monitorBeginTime = lbitIt->second->time.front();
 
   packetCountOffset--;  // The first L bit set event counts as the first observed packet
 
@@ -84,122 +97,74 @@ void FilterLBitTriggeredMonitoring(SimEventMap &simEventMap)
   bool firstRMeasurementDiscarded = false;
   bool firstTMeasurementDiscarded = false;
 
+  // Discards the first remaining event of a measurement (once per flag)
+  auto discardFirst = [](SimEventColumns &events, bool &discarded) {
+    if (!discarded && events.Size() > 0)
+    {
+      discarded = true;
+      events.Erase(0, 1);
+    }
+  };
+
   for (SimEventType simEvType : nonGroundTruthLossObserverEvents)
   {
-    auto setIt = simEventMap.find(simEvType);
-    if (setIt == simEventMap.end())
+    if (simEventMap.find(simEvType) == simEventMap.end())
       continue;
-    SimEventSet &simEventSet = setIt->second;
+    SimEventColumns &events = GetMutableEvents(simEventMap, simEvType);
 
-    std::vector<EventPointer> modifiedEvents;
+    // Delete all loss-related observer events before the first L bit set event
+    // Except for the groundtruth related events
+    auto monitorBegin = std::lower_bound(events.time.begin(), events.time.end(), monitorBeginTime);
+    events.Erase(0, monitorBegin - events.time.begin());
 
-    for (auto it = simEventSet.begin(); it != simEventSet.end();)
+    bool modifyPktCount = false;
+    switch (simEvType)
     {
-      // Delete all loss-related observer events before the first L bit set event
-      // Except for the groundtruth related events
-      if ((*it)->time < monitorBeginTime)
-      {
-        it = simEventSet.erase(it);
-        continue;
-      }
+      case SimEventType::OBSV_L_BIT_SET:
+        modifyPktCount = true;
+        break;
+      case SimEventType::OBSV_Q_BIT_LOSS:
+        discardFirst(events, firstQMeasurementDiscarded);
+        modifyPktCount = true;
+        break;
+      case SimEventType::OBSV_R_BIT_LOSS:
+        discardFirst(events, firstRMeasurementDiscarded);
+        modifyPktCount = true;
+        break;
+      case SimEventType::OBSV_SEQ_LOSS:
+      case SimEventType::OBSV_ACK_SEQ_LOSS:
+        break;  // We want to keep the groundtruth independent
+      case SimEventType::OBSV_T_BIT_FULL_LOSS:
+      case SimEventType::OBSV_T_BIT_HALF_LOSS:
+        discardFirst(events, firstTMeasurementDiscarded);
+        modifyPktCount = true;
+        break;
+      default:
+        break;
+    }
 
-      switch (simEvType)
-      {
-        case SimEventType::OBSV_L_BIT_SET:
-        {
-          auto modifiedEvent = std::make_shared<EfmBitSetPCountEvent>(
-              *std::static_pointer_cast<EfmBitSetPCountEvent>(*it));
-          modifiedEvent->pkt_count -= packetCountOffset;
-          modifiedEvents.push_back(modifiedEvent);
-          it = simEventSet.erase(it);
-          continue;
-        }
-        case SimEventType::OBSV_Q_BIT_LOSS:
-          if (!firstQMeasurementDiscarded)
-          {
-            firstQMeasurementDiscarded = true;
-            it = simEventSet.erase(it);
-            continue;
-          }
-          else
-          {
-            auto modifiedEvent = std::make_shared<EfmLossMeasurementEvent>(
-                *std::static_pointer_cast<EfmLossMeasurementEvent>(*it));
-            modifiedEvent->pkt_count -= packetCountOffset;
-            modifiedEvents.push_back(modifiedEvent);
-            it = simEventSet.erase(it);
-            continue;
-          }
-          break;
-        case SimEventType::OBSV_R_BIT_LOSS:
-          if (!firstRMeasurementDiscarded)
-          {
-            firstRMeasurementDiscarded = true;
-            it = simEventSet.erase(it);
-            continue;
-          }
-          else
-          {
-            auto modifiedEvent = std::make_shared<EfmLossMeasurementEvent>(
-                *std::static_pointer_cast<EfmLossMeasurementEvent>(*it));
-            modifiedEvent->pkt_count -= packetCountOffset;
-            modifiedEvents.push_back(modifiedEvent);
-            it = simEventSet.erase(it);
-            continue;
-          }
-          break;
-        case SimEventType::OBSV_SEQ_LOSS:
-        case SimEventType::OBSV_ACK_SEQ_LOSS:
-          break;  // We want to keep the groundtruth independent
-        case SimEventType::OBSV_T_BIT_FULL_LOSS:
-        case SimEventType::OBSV_T_BIT_HALF_LOSS:
-          if (!firstTMeasurementDiscarded)
-          {
-            firstTMeasurementDiscarded = true;
-            it = simEventSet.erase(it);
-            continue;
-          }
-          else
-          {
-            auto modifiedEvent = std::make_shared<EfmLossMeasurementEvent>(
-                *std::static_pointer_cast<EfmLossMeasurementEvent>(*it));
-            modifiedEvent->pkt_count -= packetCountOffset;
-            modifiedEvents.push_back(modifiedEvent);
-            it = simEventSet.erase(it);
-            continue;
-          }
-        default:
-          break;
-      }
-      it++;  // Increment iterator here to allow continue after updating it via erasing
+    if (modifyPktCount)
+    {
+      for (uint32_t &pktCount : events.pktCount) pktCount -= packetCountOffset;
+      events.UpdateAggregates();
     }
-    for (auto &ev : modifiedEvents) simEventSet.insert(ev);
   }
 }
 
 void FilterLastSpinTransients(SimEventMap &eventMap, uint32_t transientCount)
 {
-  auto it = eventMap.find(SimEventType::OBSV_SPIN_BIT_DELAY);
-
-  if (it != eventMap.end())
+  // Remove the last transientCount spin bit delay and edge events
+  for (SimEventType simEvType :
+       {SimEventType::OBSV_SPIN_BIT_DELAY, SimEventType::OBSV_SPIN_BIT_EDGE})
   {
-    // Remove the last transientCount spin bit delay events
-    auto &eventSet = it->second;
-    if (eventSet.size() < transientCount)
-      eventSet.clear();
-    else
-      eventSet.erase(std::prev(eventSet.end(), transientCount), eventSet.end());
-  }
+    if (eventMap.find(simEvType) == eventMap.end())
+      continue;
 
-  auto it2 = eventMap.find(SimEventType::OBSV_SPIN_BIT_EDGE);
-  if (it2 != eventMap.end())
-  {
-    // Remove the last transientCount spin bit delay events
-    auto &eventSet = it2->second;
-    if (eventSet.size() < transientCount)
-      eventSet.clear();
+    SimEventColumns &events = GetMutableEvents(eventMap, simEvType);
+    if (events.Size() < transientCount)
+      events.Erase(0, events.Size());
     else
-      eventSet.erase(std::prev(eventSet.end(), transientCount), eventSet.end());
+      events.Erase(events.Size() - transientCount, events.Size());
   }
 }
 
@@ -319,10 +284,21 @@ TBitClientPhase TBitClientPhaseFromString(std::string phaseString)
 }
 
 
-std::shared_ptr<SimEvent> CreateEvent(simdjson::ondemand::object &event)
+bool IsHostEventType(SimEventType eventType)
+{
+  return eventType >= SimEventType::HOST_GT_TRANS_DELAY &&
+         eventType <= SimEventType::HOST_T_BIT_PHASE_UPDATE;
+}
+
+
+std::shared_ptr<SimEvent> CreateEvent(simdjson::ondemand::object &event,
+                                      const std::optional<SimEventTypeSet> &eventTypes,
+                                      std::pmr::memory_resource *memory)
 {
   using namespace simdjson;
   SimEventType evType = StringToEventType(std::string(event["name"].get_string().value()));
+  if (eventTypes.has_value() && eventTypes->find(evType) == eventTypes->end())
+    return nullptr;
 
   double evTime = event["time"].get_double();
   uint32_t evFlowId = event["group_id"]["flow_id"].get_uint64();
@@ -331,7 +307,7 @@ std::shared_ptr<SimEvent> CreateEvent(simdjson::ondemand::object &event)
   switch (evType)
   {
     case SimEventType::OBSV_FLOW_BEGIN:
-      return std::make_shared<SimEvent>(evType, evTime, evFlowId);
+      return MakeEvent<SimEvent>(memory, evType, evTime, evFlowId);
       break;
     case SimEventType::HOST_SPIN_BIT_UDPATE:
     case SimEventType::HOST_Q_BIT_UPDATE:
@@ -339,31 +315,34 @@ std::shared_ptr<SimEvent> CreateEvent(simdjson::ondemand::object &event)
     case SimEventType::OBSV_SPIN_BIT_EDGE:
     case SimEventType::OBSV_Q_BIT_CHANGE:
     case SimEventType::OBSV_R_BIT_CHANGE:
-      return std::make_shared<EfmBitUpdateEvent>(
-          evType, evTime, evFlowId, evData["new_state"].get_bool(), evData["seq"].get_uint64());
+      return MakeEvent<EfmBitUpdateEvent>(
+          memory, evType, evTime, evFlowId, evData["new_state"].get_bool(),
+          evData["seq"].get_uint64());
       break;
     case SimEventType::HOST_L_BIT_SET:
     case SimEventType::HOST_T_BIT_SET:
     case SimEventType::OBSV_T_BIT_SET:
-      return std::make_shared<EfmBitSetEvent>(evType, evTime, evFlowId, evData["seq"].get_uint64());
+      return MakeEvent<EfmBitSetEvent>(memory, evType, evTime, evFlowId,
+                                       evData["seq"].get_uint64());
       break;
     case SimEventType::OBSV_L_BIT_SET:
     case SimEventType::OBSV_P_L_BIT_SET:
-      return std::make_shared<EfmBitSetPCountEvent>(
-          evType, evTime, evFlowId, evData["pkt_count"].get_uint64(), evData["seq"].get_uint64());
+      return MakeEvent<EfmBitSetPCountEvent>(
+          memory, evType, evTime, evFlowId, evData["pkt_count"].get_uint64(),
+          evData["seq"].get_uint64());
       break;
     case SimEventType::HOST_L_BIT_COUNTER_UPDATE:
-      return std::make_shared<EfmLBitCounterUpdateEvent>(evType, evTime, evFlowId,
-                                                         evData["old_value"].get_uint64(),
-                                                         evData["new_value"].get_uint64());
+      return MakeEvent<EfmLBitCounterUpdateEvent>(memory, evType, evTime, evFlowId,
+                                                  evData["old_value"].get_uint64(),
+                                                  evData["new_value"].get_uint64());
       break;
     case SimEventType::HOST_R_BIT_BLOCK_UPDATE:
-      return std::make_shared<EfmRBitBlockLenUpdateEvent>(evType, evTime, evFlowId,
-                                                          evData["new_length"].get_uint64());
+      return MakeEvent<EfmRBitBlockLenUpdateEvent>(memory, evType, evTime, evFlowId,
+                                                   evData["new_length"].get_uint64());
       break;
     case SimEventType::HOST_T_BIT_PHASE_UPDATE:
-      return std::make_shared<EfmTBitHostPhaseUpdateEvent>(
-          evType, evTime, evFlowId,
+      return MakeEvent<EfmTBitHostPhaseUpdateEvent>(
+          memory, evType, evTime, evFlowId,
           TBitClientPhaseFromString(std::string(evData["old_phase"].get_string().value())),
           TBitClientPhaseFromString(std::string(evData["new_phase"].get_string().value())));
       break;
@@ -378,13 +357,13 @@ std::shared_ptr<SimEvent> CreateEvent(simdjson::ondemand::object &event)
       if (evData["half_delay_ms"].get(
               halfDelay))  // Evaluates to true on error, i.e., "half_delay_ms" not found
       {
-        return std::make_shared<EfmDelayMeasurementEvent>(evType, evTime, evFlowId,
-                                                          evData["full_delay_ms"].get_uint64());
+        return MakeEvent<EfmDelayMeasurementEvent>(memory, evType, evTime, evFlowId,
+                                                   evData["full_delay_ms"].get_uint64());
       }
       else
       {
-        return std::make_shared<EfmDelayMeasurementEvent>(
-            evType, evTime, evFlowId, evData["full_delay_ms"].get_uint64(), halfDelay);
+        return MakeEvent<EfmDelayMeasurementEvent>(
+            memory, evType, evTime, evFlowId, evData["full_delay_ms"].get_uint64(), halfDelay);
       }
       break;
     }
@@ -398,13 +377,14 @@ std::shared_ptr<SimEvent> CreateEvent(simdjson::ondemand::object &event)
     case SimEventType::OBSV_TCP_REORDERING:
     case SimEventType::PING_RT_LOSS:
     case SimEventType::PING_ETE_LOSS:
-      return std::make_shared<EfmLossMeasurementEvent>(
-          evType, evTime, evFlowId, evData["pkt_count"].get_uint64(), evData["loss"].get_uint64());
+      return MakeEvent<EfmLossMeasurementEvent>(
+          memory, evType, evTime, evFlowId, evData["pkt_count"].get_uint64(),
+          evData["loss"].get_uint64());
       break;
     case SimEventType::OBSV_T_BIT_PHASE_UPDATE:
     {
-      auto evPtr = std::make_shared<EfmTBitObserverPhaseUpdateEvent>(
-          evType, evTime, evFlowId,
+      auto evPtr = MakeEvent<EfmTBitObserverPhaseUpdateEvent>(
+          memory, evType, evTime, evFlowId,
           TBitObserverPhaseFromString(std::string(evData["old_phase"].get_string().value())),
           TBitObserverPhaseFromString(std::string(evData["new_phase"].get_string().value())));
       uint64_t genTrainLength;
@@ -417,16 +397,474 @@ std::shared_ptr<SimEvent> CreateEvent(simdjson::ondemand::object &event)
       break;
     }
     case SimEventType::OBSV_P_SQ_BITS_LOSS:
-      return std::make_shared<EfmSignedLossMeasurementEvent>(
-          evType, evTime, evFlowId, evData["pkt_count"].get_uint64(), evData["loss"].get_int64());
+      return MakeEvent<EfmSignedLossMeasurementEvent>(
+          memory, evType, evTime, evFlowId, evData["pkt_count"].get_uint64(),
+          evData["loss"].get_int64());
     case SimEventType::UNKNOWN:
     default:
-      return std::make_shared<SimEvent>(evType, evTime, evFlowId);
+      return MakeEvent<SimEvent>(memory, evType, evTime, evFlowId);
       break;
   }
 }
 
 
+void MergeSimEventMap(SimEventMap &target, SimEventMap &source)
+{
+  for (auto it = source.begin(); it != source.end(); it++)
+  {
+    auto targetIt = target.find(it->first);
+    if (targetIt == target.end())
+      target.emplace(it->first, it->second);
+    else  // Events with equal time stay behind the ones already stored in target
+      GetMutableEvents(target, it->first).Merge(GetMutableEvents(source, it->first));
+  }
+  source.clear();
+}
+
+void SortSimEventMap(SimEventMap &eventMap)
+{
+  for (auto it = eventMap.begin(); it != eventMap.end(); it++)
+  {
+    if (!it->second->IsSorted())
+      GetMutableEvents(eventMap, it->first).SortByTime();
+  }
+}
+
+SimEventColumns &GetMutableEvents(SimEventMap &eventMap, SimEventType eventType)
+{
+  auto it = eventMap.find(eventType);
+  if (it == eventMap.end())
+  {
+    // New columns are allocated like the map itself (i.e., in the arena of an imported result set)
+    auto columns = MakeArenaShared<SimEventColumns>(eventMap.get_allocator().GetArena());
+    it = eventMap.emplace(eventType, std::move(columns)).first;
+  }
+  else if (it->second.use_count() > 1)
+  {
+    // Shared with a filtered copy (or the original of one), so copy before modifying
+    it->second = std::make_shared<SimEventColumns>(*it->second);
+  }
+  return *it->second;
+}
+
+// hostEvents mirrors FilterSimEventSet, which has no filters for host events yet
+bool IsAffectedByFilter(const SimEventMap &eventMap, const SimFilter &filter,
+                        bool obsvEvents /*=true*/, [[maybe_unused]] bool hostEvents /*=true*/)
+{
+  // Has to match the event types modified by FilterSimEventSet
+  if (!obsvEvents)
+    return false;
+
+  if (filter.lBitTriggeredMonitoring)
+  {
+    for (SimEventType simEvType : nonGroundTruthLossObserverEvents)
+    {
+      if (eventMap.find(simEvType) != eventMap.end())
+        return true;
+    }
+  }
+
+  if (filter.removeLastXSpinTransients > 0)
+  {
+    if (eventMap.find(SimEventType::OBSV_SPIN_BIT_DELAY) != eventMap.end() ||
+        eventMap.find(SimEventType::OBSV_SPIN_BIT_EDGE) != eventMap.end())
+      return true;
+  }
+
+  return false;
+}
+
+// ----- SimEventColumns -----
+
+void SimEventColumns::Insert(const SimEvent &event)
+{
+  // Out-of-order events are appended as well and only moved into place by SortByTime, so that
+  // ingesting them does not shift the columns
+  if (!time.empty() && event.time < time.back())
+    m_sorted = false;
+
+  auto put = [](auto &column, auto value) { column.push_back(value); };
+  put(time, event.time);
+  if (event.eventType == SimEventType::OBSV_SPIN_BIT_DELAY)
+    m_timeIndexed = true;
+
+  // The event classes per type have to match CreateEvent
+  switch (event.eventType)
+  {
+    case SimEventType::HOST_SPIN_BIT_UDPATE:
+    case SimEventType::HOST_Q_BIT_UPDATE:
+    case SimEventType::HOST_R_BIT_UPDATE:
+    case SimEventType::OBSV_SPIN_BIT_EDGE:
+    case SimEventType::OBSV_Q_BIT_CHANGE:
+    case SimEventType::OBSV_R_BIT_CHANGE:
+    {
+      auto &bitEv = static_cast<const EfmBitUpdateEvent &>(event);
+      put(newState, static_cast<uint8_t>(bitEv.new_state));
+      put(seq, bitEv.seq);
+      break;
+    }
+    case SimEventType::HOST_L_BIT_SET:
+    case SimEventType::HOST_T_BIT_SET:
+    case SimEventType::OBSV_T_BIT_SET:
+      put(seq, static_cast<const EfmBitSetEvent &>(event).seq);
+      break;
+    case SimEventType::OBSV_L_BIT_SET:
+    case SimEventType::OBSV_P_L_BIT_SET:
+    {
+      auto &setEv = static_cast<const EfmBitSetPCountEvent &>(event);
+      put(pktCount, setEv.pkt_count);
+      put(seq, setEv.seq);
+      break;
+    }
+    case SimEventType::HOST_L_BIT_COUNTER_UPDATE:
+    {
+      auto &counterEv = static_cast<const EfmLBitCounterUpdateEvent &>(event);
+      put(oldValue, counterEv.old_value);
+      put(newValue, counterEv.new_value);
+      break;
+    }
+    case SimEventType::HOST_R_BIT_BLOCK_UPDATE:
+      put(newValue, static_cast<const EfmRBitBlockLenUpdateEvent &>(event).new_length);
+      break;
+    case SimEventType::HOST_T_BIT_PHASE_UPDATE:
+    {
+      auto &phaseEv = static_cast<const EfmTBitHostPhaseUpdateEvent &>(event);
+      put(oldPhase, static_cast<int32_t>(phaseEv.old_phase));
+      put(newPhase, static_cast<int32_t>(phaseEv.new_phase));
+      break;
+    }
+    case SimEventType::OBSV_SPIN_BIT_DELAY:
+    case SimEventType::HOST_GT_TRANS_DELAY:
+    case SimEventType::HOST_GT_APP_DELAY:
+    case SimEventType::OBSV_TCP_DART_DELAY:
+    case SimEventType::PING_ETE_DELAY:
+    case SimEventType::PING_RT_DELAY:
+    {
+      auto &delayEv = static_cast<const EfmDelayMeasurementEvent &>(event);
+      put(fullDelayMs, delayEv.full_delay_ms);
+      put(halfDelayMs, delayEv.half_delay_ms);
+      break;
+    }
+    case SimEventType::OBSV_Q_BIT_LOSS:
+    case SimEventType::OBSV_R_BIT_LOSS:
+    case SimEventType::OBSV_SEQ_LOSS:
+    case SimEventType::OBSV_ACK_SEQ_LOSS:
+    case SimEventType::OBSV_T_BIT_FULL_LOSS:
+    case SimEventType::OBSV_T_BIT_HALF_LOSS:
+    case SimEventType::OBSV_TCP_REORDERING:
+    case SimEventType::PING_RT_LOSS:
+    case SimEventType::PING_ETE_LOSS:
+    {
+      auto &lossEv = static_cast<const EfmLossMeasurementEvent &>(event);
+      put(pktCount, lossEv.pkt_count);
+      put(loss, lossEv.loss);
+      break;
+    }
+    case SimEventType::OBSV_T_BIT_PHASE_UPDATE:
+    {
+      auto &phaseEv = static_cast<const EfmTBitObserverPhaseUpdateEvent &>(event);
+      put(oldPhase, static_cast<int32_t>(phaseEv.old_phase));
+      put(newPhase, static_cast<int32_t>(phaseEv.new_phase));
+      put(genTrainLength, phaseEv.gen_train_length);
+      put(refTrainLength, phaseEv.ref_train_length);
+      break;
+    }
+    case SimEventType::OBSV_P_SQ_BITS_LOSS:
+    {
+      auto &lossEv = static_cast<const EfmSignedLossMeasurementEvent &>(event);
+      put(pktCount, lossEv.pkt_count);
+      put(signedLoss, lossEv.loss);
+      break;
+    }
+    case SimEventType::OBSV_FLOW_BEGIN:
+    case SimEventType::UNKNOWN:
+    default:
+      break;
+  }
+
+  // Out-of-order events are only accounted for by SortByTime, which recomputes the aggregates
+  if (m_sorted)
+    AddToAggregates(time.size() - 1);
+}
+
+void SimEventColumns::SortByTime()
+{
+  if (m_sorted)
+    return;
+
+  std::vector<size_t> order(time.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   [this](size_t a, size_t b) { return time[a] < time[b]; });
+
+  ForEachColumn([&order](auto &column) {
+    if (column.empty())
+      return;
+    std::remove_reference_t<decltype(column)> sorted;
+    sorted.reserve(order.size());
+    for (size_t i : order) sorted.push_back(column[i]);
+    column = std::move(sorted);
+  });
+  m_sorted = true;
+  UpdateAggregates();
+}
+
+void SimEventColumns::Merge(SimEventColumns &other)
+{
+  if (other.time.empty())
+    return;
+  SortByTime();
+  other.SortByTime();
+
+  // The prefixes of the own events are missing if only other was time-indexed
+  bool indexOwnEvents = other.m_timeIndexed && !m_timeIndexed && !time.empty();
+  m_timeIndexed = m_timeIndexed || other.m_timeIndexed;
+
+  if ((time.empty() || other.time.front() >= time.back()) && !indexOwnEvents)
+  {
+    // Usual case: the other events follow in time, so the columns are just appended
+    size_t oldSize = time.size();
+    ForEachColumn(other, [](auto &column, auto &otherColumn) {
+      column.insert(column.end(), otherColumn.begin(), otherColumn.end());
+    });
+    for (size_t i = oldSize; i < time.size(); i++) AddToAggregates(i);
+  }
+  else
+  {
+    // std::merge is stable, so for equal times the own events come first
+    std::vector<size_t> order(time.size() + other.time.size());
+    std::vector<size_t> ownIndices(time.size());
+    std::vector<size_t> otherIndices(other.time.size());
+    for (size_t i = 0; i < ownIndices.size(); i++) ownIndices[i] = i;
+    for (size_t i = 0; i < otherIndices.size(); i++) otherIndices[i] = time.size() + i;
+    auto timeOf = [this, &other](size_t i) {
+      return i < time.size() ? time[i] : other.time[i - time.size()];
+    };
+    std::merge(ownIndices.begin(), ownIndices.end(), otherIndices.begin(), otherIndices.end(),
+               order.begin(), [&timeOf](size_t a, size_t b) { return timeOf(a) < timeOf(b); });
+
+    size_t ownSize = time.size();
+    ForEachColumn(other, [&order, ownSize](auto &column, auto &otherColumn) {
+      if (column.empty() && otherColumn.empty())
+        return;
+      std::remove_reference_t<decltype(column)> merged;
+      merged.reserve(order.size());
+      for (size_t i : order) merged.push_back(i < ownSize ? column[i] : otherColumn[i - ownSize]);
+      column = std::move(merged);
+    });
+    UpdateAggregates();
+  }
+
+  other.ForEachColumn([](auto &column) { column.clear(); });
+  other.UpdateAggregates();
+}
+
+void SimEventColumns::Erase(size_t begin, size_t end)
+{
+  ForEachColumn([begin, end](auto &column) {
+    if (!column.empty())
+      column.erase(column.begin() + begin, column.begin() + end);
+  });
+  UpdateAggregates();
+}
+
+void SimEventColumns::UpdateAggregates()
+{
+  m_aggregates = Aggregates();
+  m_delayPrefixes = DelayPrefixes();
+  for (size_t i = 0; i < time.size(); i++) AddToAggregates(i);
+}
+
+size_t SimEventColumns::CountBefore(double beforeTime) const
+{
+  return std::lower_bound(time.begin(), time.end(), beforeTime) - time.begin();
+}
+
+SimEventColumns::Aggregates SimEventColumns::GetDelayAggregatesBefore(double beforeTime) const
+{
+  return GetDelayAggregatesOfFirst(CountBefore(beforeTime));
+}
+
+std::vector<SimEventColumns::Aggregates> SimEventColumns::GetDelayAggregatesBefore(
+    const std::vector<double> &times) const
+{
+  // Visit the times in ascending order, so the events are only walked once
+  std::vector<size_t> order(times.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::sort(order.begin(), order.end(),
+            [&times](size_t a, size_t b) { return times[a] < times[b]; });
+
+  std::vector<Aggregates> result(times.size());
+  Aggregates running;
+  size_t count = 0;
+  for (size_t i : order)
+  {
+    size_t end = std::lower_bound(time.begin() + count, time.end(), times[i]) - time.begin();
+    if (m_timeIndexed)
+    {
+      result[i] = GetDelayAggregatesOfFirst(end);
+    }
+    else
+    {
+      for (; count < end; count++) AddDelays(running, count);
+      result[i] = running;
+    }
+    count = end;
+  }
+  return result;
+}
+
+SimEventColumns::Aggregates SimEventColumns::GetDelayAggregatesOfFirst(size_t count) const
+{
+  if (count == time.size())
+    return m_aggregates;
+
+  Aggregates agg;
+  if (count == 0)
+    return agg;
+
+  if (m_timeIndexed)
+  {
+    const DelayPrefixes &prefixes = m_delayPrefixes;
+    agg.fullDelaySum = prefixes.fullDelaySum[count - 1];
+    agg.fullDelayMin = prefixes.fullDelayMin[count - 1];
+    agg.fullDelayMax = prefixes.fullDelayMax[count - 1];
+    agg.halfDelaySum = prefixes.halfDelaySum[count - 1];
+    agg.halfDelayCount = prefixes.halfDelayCount[count - 1];
+    agg.halfDelayMin = prefixes.halfDelayMin[count - 1];
+    agg.halfDelayMax = prefixes.halfDelayMax[count - 1];
+  }
+  else
+  {
+    for (size_t i = 0; i < count; i++) AddDelays(agg, i);
+  }
+  return agg;
+}
+
+void SimEventColumns::AddDelays(Aggregates &agg, size_t index) const
+{
+  // Only the columns of the fields of the event type are filled
+  if (!fullDelayMs.empty())
+  {
+    agg.fullDelaySum += fullDelayMs[index];
+    agg.fullDelayMin = std::min(agg.fullDelayMin, fullDelayMs[index]);
+    agg.fullDelayMax = std::max(agg.fullDelayMax, fullDelayMs[index]);
+  }
+  if (!halfDelayMs.empty() && halfDelayMs[index].has_value())
+  {
+    agg.halfDelaySum += halfDelayMs[index].value();
+    agg.halfDelayCount++;
+    agg.halfDelayMin = std::min(agg.halfDelayMin, halfDelayMs[index].value());
+    agg.halfDelayMax = std::max(agg.halfDelayMax, halfDelayMs[index].value());
+  }
+}
+
+void SimEventColumns::AddToAggregates(size_t index)
+{
+  Aggregates &agg = m_aggregates;
+  AddDelays(agg, index);
+  if (m_timeIndexed)
+  {
+    // Events are added in order, so the totals are the aggregates up to this index
+    DelayPrefixes &prefixes = m_delayPrefixes;
+    prefixes.fullDelaySum.push_back(agg.fullDelaySum);
+    prefixes.fullDelayMin.push_back(agg.fullDelayMin);
+    prefixes.fullDelayMax.push_back(agg.fullDelayMax);
+    prefixes.halfDelaySum.push_back(agg.halfDelaySum);
+    prefixes.halfDelayCount.push_back(agg.halfDelayCount);
+    prefixes.halfDelayMin.push_back(agg.halfDelayMin);
+    prefixes.halfDelayMax.push_back(agg.halfDelayMax);
+  }
+
+  // Only the columns of the fields of the event type are filled
+  if (!loss.empty())
+    agg.lossSum += loss[index];
+  if (!signedLoss.empty())
+  {
+    agg.signedLossSum += signedLoss[index];
+    agg.relativeSignedLossSum += (double)signedLoss[index] / (pktCount[index] + signedLoss[index]);
+  }
+  if (!pktCount.empty())
+  {
+    agg.pktCountSum += pktCount[index];
+    agg.pktCountMax = std::max(agg.pktCountMax, pktCount[index]);
+  }
+}
+
+EventPointer SimEventColumns::GetEvent(SimEventType eventType, uint32_t flowId, size_t index) const
+{
+  double evTime = time.at(index);
+
+  switch (eventType)
+  {
+    case SimEventType::HOST_SPIN_BIT_UDPATE:
+    case SimEventType::HOST_Q_BIT_UPDATE:
+    case SimEventType::HOST_R_BIT_UPDATE:
+    case SimEventType::OBSV_SPIN_BIT_EDGE:
+    case SimEventType::OBSV_Q_BIT_CHANGE:
+    case SimEventType::OBSV_R_BIT_CHANGE:
+      return std::make_shared<EfmBitUpdateEvent>(eventType, evTime, flowId, newState[index],
+                                                 seq[index]);
+    case SimEventType::HOST_L_BIT_SET:
+    case SimEventType::HOST_T_BIT_SET:
+    case SimEventType::OBSV_T_BIT_SET:
+      return std::make_shared<EfmBitSetEvent>(eventType, evTime, flowId, seq[index]);
+    case SimEventType::OBSV_L_BIT_SET:
+    case SimEventType::OBSV_P_L_BIT_SET:
+      return std::make_shared<EfmBitSetPCountEvent>(eventType, evTime, flowId, pktCount[index],
+                                                    seq[index]);
+    case SimEventType::HOST_L_BIT_COUNTER_UPDATE:
+      return std::make_shared<EfmLBitCounterUpdateEvent>(eventType, evTime, flowId,
+                                                         oldValue[index], newValue[index]);
+    case SimEventType::HOST_R_BIT_BLOCK_UPDATE:
+      return std::make_shared<EfmRBitBlockLenUpdateEvent>(eventType, evTime, flowId,
+                                                          newValue[index]);
+    case SimEventType::HOST_T_BIT_PHASE_UPDATE:
+      return std::make_shared<EfmTBitHostPhaseUpdateEvent>(
+          eventType, evTime, flowId, static_cast<TBitClientPhase>(oldPhase[index]),
+          static_cast<TBitClientPhase>(newPhase[index]));
+    case SimEventType::OBSV_SPIN_BIT_DELAY:
+    case SimEventType::HOST_GT_TRANS_DELAY:
+    case SimEventType::HOST_GT_APP_DELAY:
+    case SimEventType::OBSV_TCP_DART_DELAY:
+    case SimEventType::PING_ETE_DELAY:
+    case SimEventType::PING_RT_DELAY:
+    {
+      auto evPtr =
+          std::make_shared<EfmDelayMeasurementEvent>(eventType, evTime, flowId, fullDelayMs[index]);
+      evPtr->half_delay_ms = halfDelayMs[index];
+      return evPtr;
+    }
+    case SimEventType::OBSV_Q_BIT_LOSS:
+    case SimEventType::OBSV_R_BIT_LOSS:
+    case SimEventType::OBSV_SEQ_LOSS:
+    case SimEventType::OBSV_ACK_SEQ_LOSS:
+    case SimEventType::OBSV_T_BIT_FULL_LOSS:
+    case SimEventType::OBSV_T_BIT_HALF_LOSS:
+    case SimEventType::OBSV_TCP_REORDERING:
+    case SimEventType::PING_RT_LOSS:
+    case SimEventType::PING_ETE_LOSS:
+      return std::make_shared<EfmLossMeasurementEvent>(eventType, evTime, flowId, pktCount[index],
+                                                       loss[index]);
+    case SimEventType::OBSV_T_BIT_PHASE_UPDATE:
+    {
+      auto evPtr = std::make_shared<EfmTBitObserverPhaseUpdateEvent>(
+          eventType, evTime, flowId, static_cast<TBitObserverPhase>(oldPhase[index]),
+          static_cast<TBitObserverPhase>(newPhase[index]));
+      evPtr->gen_train_length = genTrainLength[index];
+      evPtr->ref_train_length = refTrainLength[index];
+      return evPtr;
+    }
+    case SimEventType::OBSV_P_SQ_BITS_LOSS:
+      return std::make_shared<EfmSignedLossMeasurementEvent>(eventType, evTime, flowId,
+                                                             pktCount[index], signedLoss[index]);
+    case SimEventType::OBSV_FLOW_BEGIN:
+    case SimEventType::UNKNOWN:
+    default:
+      return std::make_shared<SimEvent>(eventType, evTime, flowId);
+  }
+}
+
 void FilterSimEventSet(SimEventMap &eventMap, const SimFilter &filter, bool obsvEvents /*=true*/,
                        bool hostEvents /*=true*/)
 {
@@ -442,6 +880,40 @@ void FilterSimEventSet(SimEventMap &eventMap, const SimFilter &filter, bool obsv
   }
 }
 
+// hostEvents mirrors FilterSimEventSet, which has no filters for host events yet
+std::vector<SimEventMap> FilterSimEventSets(const SimEventMap &eventMap,
+                                            const std::vector<SimFilter> &filters,
+                                            bool obsvEvents /*=true*/,
+                                            [[maybe_unused]] bool hostEvents /*=true*/)
+{
+  std::vector<SimEventMap> filtered;
+  filtered.reserve(filters.size());
+
+  // The L bit filter only changes loss events and the spin transient filter only spin events, so
+  // the L bit filtered loss events are computed once and shared by all filters that use it
+  std::optional<SimEventMap> lBitFiltered;
+  for (const SimFilter &filter : filters)
+  {
+    if (obsvEvents && filter.lBitTriggeredMonitoring)
+    {
+      if (!lBitFiltered)
+      {
+        lBitFiltered = eventMap;
+        FilterLBitTriggeredMonitoring(*lBitFiltered);
+      }
+      filtered.push_back(*lBitFiltered);
+    }
+    else
+      filtered.push_back(eventMap);
+
+    // Event types shared with eventMap or other results are copied before they are changed
+    if (obsvEvents && filter.removeLastXSpinTransients > 0)
+      FilterLastSpinTransients(filtered.back(), filter.removeLastXSpinTransients);
+  }
+
+  return filtered;
+}
+
 bool SimEvent::IsPathEvent() const
 {
   return eventType == SimEventType::OBSV_P_L_BIT_SET ||
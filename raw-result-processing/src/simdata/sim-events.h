@@ -4,25 +4,15 @@
 #include <memory>
 #include <nlohmann/json.hpp>
 #include <optional>
+#include <set>
+#include <vector>
 
+#include "sim-arena.h"
 #include "sim-filter.h"
 #include "simdjson.h"
 
 namespace simdata {
 
-// Allows comparison of shared pointers via a specific comparator of the underlying object
-// See https://stackoverflow.com/questions/11774761
-template <typename T, typename Pred = std::less<T>>
-struct shared_ptr_compare : Pred
-{
-  shared_ptr_compare(Pred const& p = Pred()) : Pred(p) {}
-
-  bool operator()(std::shared_ptr<T> const p1, std::shared_ptr<T> const p2) const
-  {
-    return Pred::operator()(*p1, *p2);
-  }
-};
-
 enum class SimEventType
 {
   UNKNOWN = 0,
@@ -63,6 +53,10 @@ enum class SimEventType
 
 std::string EventTypeToString(const SimEventType& eventType);
 
+typedef std::set<SimEventType> SimEventTypeSet;
+
+bool IsHostEventType(SimEventType eventType);
+
 
 enum class TBitObserverPhase
 {
@@ -130,12 +124,181 @@ struct SimEvent
 };
 
 typedef std::shared_ptr<SimEvent> EventPointer;
-typedef std::multiset<EventPointer, shared_ptr_compare<SimEvent>> SimEventSet;
-typedef std::map<SimEventType, SimEventSet> SimEventMap;
+
+// Stores the events of one type (of one flow, path, or ping pair) in time order. Each field is kept
+// in its own contiguous array (column), so getters scan plain arrays instead of following pointers
+// to separately allocated events. Only the columns of the fields the event type has are filled
+// (the event classes per type are the ones CreateEvent uses), all other columns stay empty.
+struct SimEventColumns
+{
+  std::vector<double> time;
+
+  std::vector<uint32_t> seq;
+  std::vector<uint8_t> newState;  // Not std::vector<bool>, since that is not contiguous
+  std::vector<uint32_t> pktCount;
+  std::vector<uint32_t> loss;
+  std::vector<int32_t> signedLoss;
+  std::vector<uint32_t> fullDelayMs;
+  std::vector<std::optional<uint32_t>> halfDelayMs;
+  std::vector<uint32_t> oldValue;
+  std::vector<uint32_t> newValue;   // Also stores the new length of R bit block updates
+  std::vector<int32_t> oldPhase;    // TBitClientPhase or TBitObserverPhase
+  std::vector<int32_t> newPhase;    // TBitClientPhase or TBitObserverPhase
+  std::vector<std::optional<uint32_t>> genTrainLength;
+  std::vector<std::optional<uint32_t>> refTrainLength;
+
+  // Aggregates over all events, kept up to date by Insert, SortByTime, Merge, and Erase. Sums are
+  // accumulated in event order, so they equal a scan over the columns.
+  struct Aggregates
+  {
+    double fullDelaySum = 0.0;
+    uint32_t fullDelayMin = UINT32_MAX;
+    uint32_t fullDelayMax = 0;
+    double halfDelaySum = 0.0;
+    uint32_t halfDelayCount = 0;  // Number of events with a half delay
+    uint32_t halfDelayMin = UINT32_MAX;
+    uint32_t halfDelayMax = 0;
+    uint32_t lossSum = 0;
+    double signedLossSum = 0.0;
+    double relativeSignedLossSum = 0.0;  // Sum of loss / (pktCount + loss) of all events
+    uint32_t pktCountSum = 0;
+    uint32_t pktCountMax = 0;
+  };
+
+  size_t Size() const { return time.size(); }
+
+  const Aggregates& GetAggregates() const { return m_aggregates; }
+
+  /// @brief Recomputes the aggregates, has to be called after modifying columns directly
+  void UpdateAggregates();
+
+  /// @brief Number of events with a time lower than the specified one
+  size_t CountBefore(double time) const;
+
+  /// @brief Aggregates of the delays of all events with a time lower than the specified one (only
+  /// the delay fields are set). Costs a binary search for time-indexed columns (spin bit delays,
+  /// which are queried with time filters), otherwise a scan of the events before the time.
+  Aggregates GetDelayAggregatesBefore(double time) const;
+  /// @brief GetDelayAggregatesBefore for several times, evaluated in one pass over the events
+  std::vector<Aggregates> GetDelayAggregatesBefore(const std::vector<double>& times) const;
+
+  /// @brief Appends an event. Events are usually added in time order, the ones that are not are
+  /// only moved behind all events with a lower or equal time by SortByTime, which has to be called
+  /// before the events are read.
+  void Insert(const SimEvent& event);
+
+  /// @brief Whether the events are in time order, false after out-of-order inserts
+  bool IsSorted() const { return m_sorted; }
+
+  /// @brief Stably sorts the events by time (events with equal time keep their insertion order)
+  /// and recomputes the aggregates. Does nothing if the events are already sorted.
+  void SortByTime();
+
+  /// @brief Moves all events of other (same event type) into these columns, events of other
+  /// stay behind events with equal time that are already stored
+  void Merge(SimEventColumns& other);
+
+  /// @brief Removes the events with indices in [begin, end)
+  void Erase(size_t begin, size_t end);
+
+  /// @brief Creates a separate event object from the fields at an index
+  EventPointer GetEvent(SimEventType eventType, uint32_t flowId, size_t index) const;
+
+private:
+  // Adds the event at an index to the aggregates
+  void AddToAggregates(size_t index);
+  // Adds the delays of the event at an index to agg
+  void AddDelays(Aggregates& agg, size_t index) const;
+  // Delay aggregates of the first count events
+  Aggregates GetDelayAggregatesOfFirst(size_t count) const;
+
+  Aggregates m_aggregates;
+  bool m_sorted = true;
+
+  // Delay aggregates of the events up to (including) each index, only kept if time-indexed
+  struct DelayPrefixes
+  {
+    std::vector<double> fullDelaySum;
+    std::vector<uint32_t> fullDelayMin;
+    std::vector<uint32_t> fullDelayMax;
+    std::vector<double> halfDelaySum;
+    std::vector<uint32_t> halfDelayCount;
+    std::vector<uint32_t> halfDelayMin;
+    std::vector<uint32_t> halfDelayMax;
+  };
+  bool m_timeIndexed = false;
+  DelayPrefixes m_delayPrefixes;
+
+  // Calls f for each column, the columns are listed only here
+  template <typename F>
+  void ForEachColumn(F&& f)
+  {
+    f(time);
+    f(seq);
+    f(newState);
+    f(pktCount);
+    f(loss);
+    f(signedLoss);
+    f(fullDelayMs);
+    f(halfDelayMs);
+    f(oldValue);
+    f(newValue);
+    f(oldPhase);
+    f(newPhase);
+    f(genTrainLength);
+    f(refTrainLength);
+  }
+  template <typename F>
+  void ForEachColumn(SimEventColumns& other, F&& f)
+  {
+    f(time, other.time);
+    f(seq, other.seq);
+    f(newState, other.newState);
+    f(pktCount, other.pktCount);
+    f(loss, other.loss);
+    f(signedLoss, other.signedLoss);
+    f(fullDelayMs, other.fullDelayMs);
+    f(halfDelayMs, other.halfDelayMs);
+    f(oldValue, other.oldValue);
+    f(newValue, other.newValue);
+    f(oldPhase, other.oldPhase);
+    f(newPhase, other.newPhase);
+    f(genTrainLength, other.genTrainLength);
+    f(refTrainLength, other.refTrainLength);
+  }
+};
+
+typedef std::shared_ptr<SimEventColumns> SimEventColumnsPointer;
+
+// Copies of an event map share the columns of each event type until one of the copies modifies
+// them (copy-on-write via GetMutableEvents), so filtered copies only copy the event types that the
+// filter changes
+typedef SimArenaMap<SimEventType, SimEventColumnsPointer> SimEventMap;
 
 void FilterSimEventSet(SimEventMap& eventMap, const SimFilter& filter, bool obsvEvents = true,
                        bool hostEvents = true);
 
+/// @brief Applies several filters to the same events at once. Work shared by the filters (the L
+/// bit filter) is only done once, and filtered event types are shared between the results.
+/// @return One filtered copy of eventMap per filter, in the order of filters
+std::vector<SimEventMap> FilterSimEventSets(const SimEventMap& eventMap,
+                                            const std::vector<SimFilter>& filters,
+                                            bool obsvEvents = true, bool hostEvents = true);
+
+/// @brief Whether FilterSimEventSet would change any events of the map
+bool IsAffectedByFilter(const SimEventMap& eventMap, const SimFilter& filter,
+                        bool obsvEvents = true, bool hostEvents = true);
+
+/// @brief Sorts the events of all types that were inserted out of time order
+void SortSimEventMap(SimEventMap& eventMap);
+
+// Moves all events of source into target (source is empty afterwards)
+void MergeSimEventMap(SimEventMap& target, SimEventMap& source);
+
+/// @brief Returns the events of a type for modification. They are created if missing and copied
+/// first if they are shared with another map.
+SimEventColumns& GetMutableEvents(SimEventMap& eventMap, SimEventType eventType);
+
 
 struct EfmBitUpdateEvent : SimEvent
 {
@@ -294,7 +457,15 @@ struct EfmSignedLossMeasurementEvent : SimEvent
   int32_t loss;
 };
 
-std::shared_ptr<SimEvent> CreateEvent(simdjson::ondemand::object& event);
+/// @brief Creates an event from its QLOG representation
+/// @param eventTypes If set, only events of these types are created
+/// @param memory If set, the event is allocated from this memory resource instead of the heap
+/// @return The event or nullptr if its type is not contained in eventTypes (the event data is not
+/// parsed in this case)
+std::shared_ptr<SimEvent> CreateEvent(
+    simdjson::ondemand::object& event,
+    const std::optional<SimEventTypeSet>& eventTypes = std::nullopt,
+    std::pmr::memory_resource* memory = nullptr);
 
 }  // namespace simdata
 
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <nlohmann/json.hpp>
 #include <set>
+#include <tuple>
 
 namespace simdata {
 
@@ -12,6 +13,19 @@ struct SimFilter
   bool lBitTriggeredMonitoring = false;
   uint32_t removeLastXSpinTransients = 0;
   bool IsDefault() const { return !lBitTriggeredMonitoring && removeLastXSpinTransients == 0; }
+
+  bool operator==(const SimFilter &other) const
+  {
+    return lBitTriggeredMonitoring == other.lBitTriggeredMonitoring &&
+           removeLastXSpinTransients == other.removeLastXSpinTransients;
+  }
+  bool operator!=(const SimFilter &other) const { return !(*this == other); }
+  // Orders filters, e.g., to use them as map keys
+  bool operator<(const SimFilter &other) const
+  {
+    return std::tie(lBitTriggeredMonitoring, removeLastXSpinTransients) <
+           std::tie(other.lBitTriggeredMonitoring, other.removeLastXSpinTransients);
+  }
 };
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(SimFilter, lBitTriggeredMonitoring, removeLastXSpinTransients)
 
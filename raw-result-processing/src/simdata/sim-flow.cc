@@ -30,19 +30,26 @@ std::string LossMmntTypeToString(const LossMmntType &lossMmntType)
   }
 }
 
-void SimFlow::AddEvent(EventPointer simEvent) { m_simEvents[simEvent->eventType].insert(simEvent); }
+void SimFlow::AddEvent(EventPointer simEvent)
+{
+  GetMutableEvents(m_simEvents, simEvent->eventType).Insert(*simEvent);
+}
+
+void SimFlow::SortEvents() { SortSimEventMap(m_simEvents); }
 
-uint32_t SimFlow::GetEventCount()
+void SimFlow::Merge(SimFlow &other) { MergeSimEventMap(m_simEvents, other.m_simEvents); }
+
+uint32_t SimFlow::GetEventCount() const
 {
   uint32_t count = 0;
   for (auto it = m_simEvents.begin(); it != m_simEvents.end(); it++)
   {
-    count += it->second.size();
+    count += it->second->Size();
   }
   return count;
 }
 
-uint32_t SimFlow::GetFlowId() { return m_flowId; }
+uint32_t SimFlow::GetFlowId() const { return m_flowId; }
 
 // ---------------------------------------------------
 // ----------------- SimObserverFlow -----------------
@@ -59,119 +66,117 @@ SimObsvFlowPointer SimObserverFlow::ApplyFilter(const SimFilter &filter)
   return ofp;
 }
 
+std::vector<SimObsvFlowPointer> SimObserverFlow::ApplyFilters(const std::vector<SimFilter> &filters)
+{
+  std::vector<SimObsvFlowPointer> ofps;
+  ofps.reserve(filters.size());
+
+  for (SimEventMap &filteredEvents : FilterSimEventSets(m_simEvents, filters, true, false))
+  {
+    // Clone flow with the filtered events
+    SimObsvFlowPointer ofp = std::make_shared<SimObserverFlow>(*this);
+    ofp->m_simEvents = std::move(filteredEvents);
+    ofps.push_back(ofp);
+  }
+
+  return ofps;
+}
+
+bool SimObserverFlow::IsAffectedBy(const SimFilter &filter) const
+{
+  return IsAffectedByFilter(m_simEvents, filter, true, false);
+}
+
 std::optional<std::list<double>> SimObserverFlow::GetRawSpinRTValues(double time_filter) const
 {
-    auto it = m_simEvents.find(SimEventType::OBSV_SPIN_BIT_DELAY);
-    if (it == m_simEvents.end() || it->second.size() == 0)
-        return std::nullopt;
+  auto it = m_simEvents.find(SimEventType::OBSV_SPIN_BIT_DELAY);
+  if (it == m_simEvents.end() || it->second->Size() == 0)
+    return std::nullopt;
 
-    std::list<double> result;
-    for (const auto &ev : it->second)
-    {
-        if (ev-> time < time_filter) {
-            result.push_back(std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms);
-        }
-    }
-    return result;
+  const SimEventColumns &events = *it->second;
+  return std::list<double>(events.fullDelayMs.begin(),
+                           events.fullDelayMs.begin() + events.CountBefore(time_filter));
 }
 
 std::optional<double> SimObserverFlow::GetAvgSpinRTDelay(double time_filter) const
 {
   auto it = m_simEvents.find(SimEventType::OBSV_SPIN_BIT_DELAY);
-  if (it == m_simEvents.end() || it->second.size() == 0)
+  if (it == m_simEvents.end() || it->second->Size() == 0)
     return std::nullopt;
 
-  double result = 0.0;
-  for (const auto &ev : it->second)
-  {
-    if (ev-> time < time_filter) {
-        result += std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-    }
-  }
-  return result / it->second.size();
+  // The sum only contains the delays before the time filter, but is divided by the number of all
+  // delays
+  return it->second->GetDelayAggregatesBefore(time_filter).fullDelaySum / it->second->Size();
+}
+
+std::vector<std::optional<double>> SimObserverFlow::GetAvgSpinRTDelays(
+    const std::vector<double> &time_filters) const
+{
+  auto it = m_simEvents.find(SimEventType::OBSV_SPIN_BIT_DELAY);
+  if (it == m_simEvents.end() || it->second->Size() == 0)
+    return std::vector<std::optional<double>>(time_filters.size());
+
+  std::vector<std::optional<double>> result;
+  for (const auto &agg : it->second->GetDelayAggregatesBefore(time_filters))
+    result.push_back(agg.fullDelaySum / it->second->Size());
+  return result;
 }
 
 std::optional<uint32_t> SimObserverFlow::GetMinSpinRTDelay(double time_filter) const
 {
   auto it = m_simEvents.find(SimEventType::OBSV_SPIN_BIT_DELAY);
-  if (it == m_simEvents.end() || it->second.size() == 0)
+  if (it == m_simEvents.end() || it->second->Size() == 0)
     return std::nullopt;
 
-  uint32_t result = UINT32_MAX;
-  for (const auto &ev : it->second)
-  {
-    if (ev-> time < time_filter) {
-        uint32_t tmp = std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-        if (tmp < result)
-        result = tmp;
-    }
-  }
-
-  return result;
+  return it->second->GetDelayAggregatesBefore(time_filter).fullDelayMin;
 }
 
 std::optional<uint32_t> SimObserverFlow::GetMaxSpinRTDelay(double time_filter) const
 {
   auto it = m_simEvents.find(SimEventType::OBSV_SPIN_BIT_DELAY);
-  if (it == m_simEvents.end() || it->second.size() == 0)
+  if (it == m_simEvents.end() || it->second->Size() == 0)
     return std::nullopt;
 
-  uint32_t result = 0;
-  for (const auto &ev : it->second)
-  {
-    if (ev-> time < time_filter) {
-        uint32_t tmp = std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-        if (tmp > result)
-        result = tmp;
-    }
-  }
-
-  return result;
+  return it->second->GetDelayAggregatesBefore(time_filter).fullDelayMax;
 }
 
 std::optional<double> SimObserverFlow::GetAvgSpinEtEDelay(double time_filter) const
 {
   auto it = m_simEvents.find(SimEventType::OBSV_SPIN_BIT_DELAY);
-  if (it == m_simEvents.end() || it->second.size() == 0)
+  if (it == m_simEvents.end() || it->second->Size() == 0)
+    return std::nullopt;
+
+  auto agg = it->second->GetDelayAggregatesBefore(time_filter);
+  if (agg.halfDelayCount == 0)
     return std::nullopt;
+  return agg.halfDelaySum / agg.halfDelayCount;
+}
+
+std::vector<std::optional<double>> SimObserverFlow::GetAvgSpinEtEDelays(
+    const std::vector<double> &time_filters) const
+{
+  auto it = m_simEvents.find(SimEventType::OBSV_SPIN_BIT_DELAY);
+  if (it == m_simEvents.end() || it->second->Size() == 0)
+    return std::vector<std::optional<double>>(time_filters.size());
 
-  double result = 0.0;
-  uint32_t resCount = 0;
-  for (const auto &ev : it->second)
+  std::vector<std::optional<double>> result;
+  for (const auto &agg : it->second->GetDelayAggregatesBefore(time_filters))
   {
-    if (ev-> time < time_filter) {
-        auto halfOpt = std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->half_delay_ms;
-        if (halfOpt.has_value())
-        {
-        result += halfOpt.value();
-        resCount++;
-        }
-    }
+    if (agg.halfDelayCount == 0)
+      result.push_back(std::nullopt);
+    else
+      result.push_back(agg.halfDelaySum / agg.halfDelayCount);
   }
-
-  if (resCount == 0)
-    return std::nullopt;
-  return result / resCount;
+  return result;
 }
 
 std::optional<uint32_t> SimObserverFlow::GetMinSpinEtEDelay(double time_filter) const
 {
   auto it = m_simEvents.find(SimEventType::OBSV_SPIN_BIT_DELAY);
-  if (it == m_simEvents.end() || it->second.size() == 0)
+  if (it == m_simEvents.end() || it->second->Size() == 0)
     return std::nullopt;
-  uint32_t result = UINT32_MAX;
-  for (const auto &ev : it->second)
-  {
-    if (ev-> time < time_filter) {
-        auto halfOpt = std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->half_delay_ms;
-        if (halfOpt.has_value())
-        {
-        if (halfOpt.value() < result)
-            result = halfOpt.value();
-        }
-    }
-  }
 
+  uint32_t result = it->second->GetDelayAggregatesBefore(time_filter).halfDelayMin;
   if (result == UINT32_MAX)
     return std::nullopt;
   return result;
@@ -180,104 +185,57 @@ std::optional<uint32_t> SimObserverFlow::GetMinSpinEtEDelay(double time_filter)
 std::optional<uint32_t> SimObserverFlow::GetMaxSpinEtEDelay(double time_filter) const
 {
   auto it = m_simEvents.find(SimEventType::OBSV_SPIN_BIT_DELAY);
-  uint32_t result = 0;
-  bool found = false;
-  for (const auto &ev : it->second)
-  {
-    if (ev-> time < time_filter) {
-        auto halfOpt = std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->half_delay_ms;
-        if (halfOpt.has_value())
-        {
-        if (halfOpt.value() > result)
-            result = halfOpt.value();
-        found = true;
-        }
-    }
-  }
+  if (it == m_simEvents.end())
+    return std::nullopt;
 
-  if (!found)
+  auto agg = it->second->GetDelayAggregatesBefore(time_filter);
+  if (agg.halfDelayCount == 0)
     return std::nullopt;
-  return result;
+  return agg.halfDelayMax;
 }
 
 std::optional<double> SimObserverFlow::GetAvgTcpHRTDelay() const
 {
   auto it = m_simEvents.find(SimEventType::OBSV_TCP_DART_DELAY);
 
-  if (it == m_simEvents.end() || it->second.size() == 0)
+  if (it == m_simEvents.end() || it->second->Size() == 0)
     return std::nullopt;
 
-  double result = 0.0;
-  for (const auto &ev : it->second)
-  {
-    result += std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-  }
-  return result / it->second.size();
+  return it->second->GetAggregates().fullDelaySum / it->second->Size();
 }
 
 std::optional<uint32_t> SimObserverFlow::GetMinTcpHRTDelay() const
 {
   auto it = m_simEvents.find(SimEventType::OBSV_TCP_DART_DELAY);
-  if (it == m_simEvents.end() || it->second.size() == 0)
+  if (it == m_simEvents.end() || it->second->Size() == 0)
     return std::nullopt;
 
-  uint32_t result = UINT32_MAX;
-  for (const auto &ev : it->second)
-  {
-    uint32_t tmp = std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-    if (tmp < result)
-      result = tmp;
-  }
-
-  return result;
+  return it->second->GetAggregates().fullDelayMin;
 }
 
 std::optional<uint32_t> SimObserverFlow::GetMaxTcpHRTDelay() const
 {
   auto it = m_simEvents.find(SimEventType::OBSV_TCP_DART_DELAY);
-  if (it == m_simEvents.end() || it->second.size() == 0)
+  if (it == m_simEvents.end() || it->second->Size() == 0)
     return std::nullopt;
 
-  uint32_t result = 0;
-  for (const auto &ev : it->second)
-  {
-    uint32_t tmp = std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-    if (tmp > result)
-      result = tmp;
-  }
-
-  return result;
+  return it->second->GetAggregates().fullDelayMax;
 }
 
 std::optional<std::list<double>> SimObserverFlow::GetRawTcpHRTValues() const
 {
-    auto it = m_simEvents.find(SimEventType::OBSV_TCP_DART_DELAY);
-
-    if (it == m_simEvents.end() || it->second.size() == 0)
-        return std::nullopt;
+  auto it = m_simEvents.find(SimEventType::OBSV_TCP_DART_DELAY);
 
-    std::list<double> result;
-    for (const auto &ev : it->second)
-    {
-        result.push_back(std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms);
+  if (it == m_simEvents.end() || it->second->Size() == 0)
+    return std::nullopt;
 
-    }
-    return result;
+  return std::list<double>(it->second->fullDelayMs.begin(), it->second->fullDelayMs.end());
 }
 
 
 uint32_t SimObserverFlow::GetAbsoluteQBitLoss() const
 {
-  auto it = m_simEvents.find(SimEventType::OBSV_Q_BIT_LOSS);
-  if (it == m_simEvents.end())
-    return 0;
-  uint32_t result = 0;
-  for (const auto &ev : it->second)
-  {
-    result += std::static_pointer_cast<EfmLossMeasurementEvent>(ev)->loss;
-  }
-
-  return result;
+  return SumLoss(SimEventType::OBSV_Q_BIT_LOSS);
 }
 
 uint32_t SimObserverFlow::GetAbsoluteQBitPacketCount() const
@@ -285,23 +243,14 @@ uint32_t SimObserverFlow::GetAbsoluteQBitPacketCount() const
   auto it = m_simEvents.find(SimEventType::OBSV_Q_BIT_LOSS);
   if (it == m_simEvents.end())
     return 0.0;
-  return (it->second.size() * EFM_Q_BLOCK_SIZE);
+  return (it->second->Size() * EFM_Q_BLOCK_SIZE);
 }
 
 
 
 uint32_t SimObserverFlow::GetAbsoluteRBitLoss() const
 {
-  auto it = m_simEvents.find(SimEventType::OBSV_R_BIT_LOSS);
-  if (it == m_simEvents.end())
-    return 0;
-  uint32_t result = 0;
-  for (const auto &ev : it->second)
-  {
-    result += std::static_pointer_cast<EfmLossMeasurementEvent>(ev)->loss;
-  }
-
-  return result;
+  return SumLoss(SimEventType::OBSV_R_BIT_LOSS);
 }
 
 uint32_t SimObserverFlow::GetAbsoluteLBitLoss() const
@@ -310,35 +259,17 @@ uint32_t SimObserverFlow::GetAbsoluteLBitLoss() const
   if (it == m_simEvents.end())
     return 0;
 
-  return it->second.size();
+  return it->second->Size();
 }
 
 uint32_t SimObserverFlow::GetAbsoluteTBitFullLoss() const
 {
-  auto it = m_simEvents.find(SimEventType::OBSV_T_BIT_FULL_LOSS);
-  if (it == m_simEvents.end())
-    return 0;
-  uint32_t result = 0;
-  for (const auto &ev : it->second)
-  {
-    result += std::static_pointer_cast<EfmLossMeasurementEvent>(ev)->loss;
-  }
-
-  return result;
+  return SumLoss(SimEventType::OBSV_T_BIT_FULL_LOSS);
 }
 
 uint32_t SimObserverFlow::GetAbsoluteTBitHalfLoss() const
 {
-  auto it = m_simEvents.find(SimEventType::OBSV_T_BIT_HALF_LOSS);
-  if (it == m_simEvents.end())
-    return 0;
-  uint32_t result = 0;
-  for (const auto &ev : it->second)
-  {
-    result += std::static_pointer_cast<EfmLossMeasurementEvent>(ev)->loss;
-  }
-
-  return result;
+  return SumLoss(SimEventType::OBSV_T_BIT_HALF_LOSS);
 }
 
 uint32_t SimObserverFlow::GetAbsoluteSeqLoss() const
@@ -359,16 +290,7 @@ uint32_t SimObserverFlow::GetAbsoluteAckSeqLoss() const
 
 uint32_t SimObserverFlow::GetAbsoluteTcpReordering() const
 {
-  auto it = m_simEvents.find(SimEventType::OBSV_TCP_REORDERING);
-  if (it == m_simEvents.end())
-    return 0;
-  uint32_t result = 0;
-  for (const auto &ev : it->second)
-  {
-    result += std::static_pointer_cast<EfmLossMeasurementEvent>(ev)->loss;
-  }
-
-  return result;
+  return SumLoss(SimEventType::OBSV_TCP_REORDERING);
 }
 
 double SimObserverFlow::GetRelativeQBitLoss() const
@@ -376,15 +298,11 @@ double SimObserverFlow::GetRelativeQBitLoss() const
   auto it = m_simEvents.find(SimEventType::OBSV_Q_BIT_LOSS);
   if (it == m_simEvents.end())
     return 0.0;
-  uint32_t totalLoss = 0;
-  for (const auto &ev : it->second)
-  {
-    totalLoss += std::static_pointer_cast<EfmLossMeasurementEvent>(ev)->loss;
-  }
+  uint32_t totalLoss = SumLoss(SimEventType::OBSV_Q_BIT_LOSS);
 
   // TODO: Recheck computation
   // Each Q loss measurement event corresponds to one Q block
-  return ((double)totalLoss) / (it->second.size() * EFM_Q_BLOCK_SIZE);
+  return ((double)totalLoss) / (it->second->Size() * EFM_Q_BLOCK_SIZE);
 }
 
 double SimObserverFlow::GetRelativeRBitLoss() const
@@ -392,16 +310,12 @@ double SimObserverFlow::GetRelativeRBitLoss() const
   auto it = m_simEvents.find(SimEventType::OBSV_R_BIT_LOSS);
   if (it == m_simEvents.end())
     return 0.0;
-  uint32_t totalLoss = 0;
-  for (const auto &ev : it->second)
-  {
-    totalLoss += std::static_pointer_cast<EfmLossMeasurementEvent>(ev)->loss;
-  }
+  uint32_t totalLoss = SumLoss(SimEventType::OBSV_R_BIT_LOSS);
 
   // TODO: Recheck computation
   // Each R loss measurement event corresponds to one R block
   // Which has the same size as a Q block
-  return ((double)totalLoss) / (it->second.size() * EFM_Q_BLOCK_SIZE);
+  return ((double)totalLoss) / (it->second->Size() * EFM_Q_BLOCK_SIZE);
 }
 
 double SimObserverFlow::GetRelativeLBitLoss() const
@@ -409,15 +323,10 @@ double SimObserverFlow::GetRelativeLBitLoss() const
   auto it = m_simEvents.find(SimEventType::OBSV_L_BIT_SET);
   if (it == m_simEvents.end())
     return 0.0;
-  uint32_t totalPackets = 0;
-  for (const auto &ev : it->second)
-  {
-    uint32_t pkt_count = std::static_pointer_cast<EfmBitSetPCountEvent>(ev)->pkt_count;
-    totalPackets = totalPackets > pkt_count ? totalPackets : pkt_count;
-  }
+  uint32_t totalPackets = it->second->GetAggregates().pktCountMax;
 
   if (totalPackets > 0)
-    return ((double)it->second.size()) / (totalPackets);
+    return ((double)it->second->Size()) / (totalPackets);
   else
     return 0.0;
 }
@@ -427,13 +336,8 @@ double SimObserverFlow::GetRelativeTBitFullLoss() const
   auto it = m_simEvents.find(SimEventType::OBSV_T_BIT_FULL_LOSS);
   if (it == m_simEvents.end())
     return 0.0;
-  uint32_t totalLoss = 0;
-  uint32_t totalPackets = 0;
-  for (const auto &ev : it->second)
-  {
-    totalLoss += std::static_pointer_cast<EfmLossMeasurementEvent>(ev)->loss;
-    totalPackets += std::static_pointer_cast<EfmLossMeasurementEvent>(ev)->pkt_count;
-  }
+  uint32_t totalLoss = it->second->GetAggregates().lossSum;
+  uint32_t totalPackets = it->second->GetAggregates().pktCountSum;
 
   if (totalPackets > 0)
     return ((double)totalLoss) / (totalPackets);
@@ -446,13 +350,8 @@ double SimObserverFlow::GetRelativeTBitHalfLoss() const
   auto it = m_simEvents.find(SimEventType::OBSV_T_BIT_HALF_LOSS);
   if (it == m_simEvents.end())
     return 0.0;
-  uint32_t totalLoss = 0;
-  uint32_t totalPackets = 0;
-  for (const auto &ev : it->second)
-  {
-    totalLoss += std::static_pointer_cast<EfmLossMeasurementEvent>(ev)->loss;
-    totalPackets += std::static_pointer_cast<EfmLossMeasurementEvent>(ev)->pkt_count;
-  }
+  uint32_t totalLoss = it->second->GetAggregates().lossSum;
+  uint32_t totalPackets = it->second->GetAggregates().pktCountSum;
 
   if (totalPackets > 0)
     return ((double)totalLoss) / (totalPackets);  // TODO: Reevaluate this computation
@@ -485,30 +384,25 @@ double SimObserverFlow::GetRelativeTcpReordering() const
   auto it = m_simEvents.find(SimEventType::OBSV_TCP_REORDERING);
   if (it == m_simEvents.end())
     return 0.0;
-  uint32_t totalLoss = 0;
-  for (const auto &ev : it->second)
-  {
-    totalLoss += std::static_pointer_cast<EfmLossMeasurementEvent>(ev)->loss;
-  }
+  uint32_t totalLoss = SumLoss(SimEventType::OBSV_TCP_REORDERING);
 
-  // The multiset is ordered by time, so the last element is the final one
-  uint32_t pktCount =
-      std::static_pointer_cast<EfmLossMeasurementEvent>(*it->second.rbegin())->pkt_count;
+  // The events are ordered by time, so the last element is the final one
+  uint32_t pktCount = it->second->pktCount.back();
 
   // TODO: Recheck computation
   return ((double)totalLoss) / (pktCount);
 }
 
-double SimObserverFlow::GetFlowBegin()
+double SimObserverFlow::GetFlowBegin() const
 {
   auto it = m_simEvents.find(SimEventType::OBSV_FLOW_BEGIN);
   if (it == m_simEvents.end())
     throw std::runtime_error("Flow begin event missing!");
 
-  if (it->second.size() > 1)
+  if (it->second->Size() > 1)
     throw std::runtime_error("Multiple flow begin events!");
 
-  return (*it->second.begin())->time;
+  return it->second->time.front();
 }
 
 void SimObserverFlow::GetFinalSeqLoss(uint32_t &loss, uint32_t &pktCount) const
@@ -521,9 +415,9 @@ void SimObserverFlow::GetFinalSeqLoss(uint32_t &loss, uint32_t &pktCount) const
     return;
   }
 
-  // The multiset is ordered by time, so the last element is the final one
-  loss = std::static_pointer_cast<EfmLossMeasurementEvent>(*it->second.rbegin())->loss;
-  pktCount = std::static_pointer_cast<EfmLossMeasurementEvent>(*it->second.rbegin())->pkt_count;
+  // The events are ordered by time, so the last element is the final one
+  loss = it->second->loss.back();
+  pktCount = it->second->pktCount.back();
 }
 
 void SimObserverFlow::GetFinalAckSeqLoss(uint32_t &loss, uint32_t &pktCount) const
@@ -535,9 +429,17 @@ void SimObserverFlow::GetFinalAckSeqLoss(uint32_t &loss, uint32_t &pktCount) con
     pktCount = 0;
     return;
   }
-  // The multiset is ordered by time, so the last element is the final one
-  loss = std::static_pointer_cast<EfmLossMeasurementEvent>(*it->second.rbegin())->loss;
-  pktCount = std::static_pointer_cast<EfmLossMeasurementEvent>(*it->second.rbegin())->pkt_count;
+  // The events are ordered by time, so the last element is the final one
+  loss = it->second->loss.back();
+  pktCount = it->second->pktCount.back();
+}
+
+uint32_t SimObserverFlow::SumLoss(SimEventType eventType) const
+{
+  auto it = m_simEvents.find(eventType);
+  if (it == m_simEvents.end())
+    return 0;
+  return it->second->GetAggregates().lossSum;
 }
 
 uint32_t SimObserverFlow::GetAbsolutePacketCountLossMmnt(LossMmntType lossMmntType) const
@@ -612,103 +514,75 @@ SimHostFlowPointer SimHostFlow::ApplyFilter(const SimFilter &filter)
   return hfp;
 }
 
+bool SimHostFlow::IsAffectedBy(const SimFilter &filter) const
+{
+  return IsAffectedByFilter(m_simEvents, filter, false, true);
+}
+
 uint32_t SimHostFlow::GetTotalLBitsSent() const
 {
   auto it = m_simEvents.find(SimEventType::HOST_L_BIT_SET);
   if (it == m_simEvents.end())
     return 0;
 
-  return it->second.size();
+  return it->second->Size();
 }
 
 std::optional<double> SimHostFlow::GetAvgGtTransDelay() const
 {
-  auto it = m_simEvents.find(SimEventType::HOST_GT_TRANS_DELAY);
-  if (it == m_simEvents.end())
-    return std::nullopt;
-
-  double result = 0.0;
-  for (const auto &ev : it->second)
-    result += std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-
-  return result / it->second.size();
+  return GetAvgDelay(SimEventType::HOST_GT_TRANS_DELAY);
 }
 
 std::optional<uint32_t> SimHostFlow::GetMinGtTransDelay() const
 {
-  auto it = m_simEvents.find(SimEventType::HOST_GT_TRANS_DELAY);
-  if (it == m_simEvents.end())
-    return std::nullopt;
-  uint32_t result = UINT32_MAX;
-  for (const auto &ev : it->second)
-  {
-    uint32_t tmp = std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-    if (tmp < result)
-      result = tmp;
-  }
-
-  return result;
+  return GetMinDelay(SimEventType::HOST_GT_TRANS_DELAY);
 }
 
 std::optional<uint32_t> SimHostFlow::GetMaxGtTransDelay() const
 {
-  auto it = m_simEvents.find(SimEventType::HOST_GT_TRANS_DELAY);
-  if (it == m_simEvents.end())
-    return std::nullopt;
+  return GetMaxDelay(SimEventType::HOST_GT_TRANS_DELAY);
+}
 
-  uint32_t result = 0;
-  for (const auto &ev : it->second)
-  {
-    uint32_t tmp = std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-    if (tmp > result)
-      result = tmp;
-  }
+std::optional<double> SimHostFlow::GetAvgGtAppDelay() const
+{
+  return GetAvgDelay(SimEventType::HOST_GT_APP_DELAY);
+}
 
-  return result;
+std::optional<uint32_t> SimHostFlow::GetMinGtAppDelay() const
+{
+  return GetMinDelay(SimEventType::HOST_GT_APP_DELAY);
 }
 
-std::optional<double> SimHostFlow::GetAvgGtAppDelay() const
+std::optional<uint32_t> SimHostFlow::GetMaxGtAppDelay() const
+{
+  return GetMaxDelay(SimEventType::HOST_GT_APP_DELAY);
+}
+
+std::optional<double> SimHostFlow::GetAvgDelay(SimEventType eventType) const
 {
-  auto it = m_simEvents.find(SimEventType::HOST_GT_APP_DELAY);
+  auto it = m_simEvents.find(eventType);
   if (it == m_simEvents.end())
     return std::nullopt;
-  double result = 0.0;
-  for (const auto &ev : it->second)
-    result += std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
 
-  return result / it->second.size();
+  return it->second->GetAggregates().fullDelaySum / it->second->Size();
 }
 
-std::optional<uint32_t> SimHostFlow::GetMinGtAppDelay() const
+std::optional<uint32_t> SimHostFlow::GetMinDelay(SimEventType eventType) const
 {
-  auto it = m_simEvents.find(SimEventType::HOST_GT_APP_DELAY);
+  auto it = m_simEvents.find(eventType);
   if (it == m_simEvents.end())
     return std::nullopt;
-  uint32_t result = UINT32_MAX;
-  for (const auto &ev : it->second)
-  {
-    uint32_t tmp = std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-    if (tmp < result)
-      result = tmp;
-  }
 
-  return result;
+  return it->second->GetAggregates().fullDelayMin;
 }
 
-std::optional<uint32_t> SimHostFlow::GetMaxGtAppDelay() const
+std::optional<uint32_t> SimHostFlow::GetMaxDelay(SimEventType eventType) const
 {
-  auto it = m_simEvents.find(SimEventType::HOST_GT_APP_DELAY);
+  auto it = m_simEvents.find(eventType);
   if (it == m_simEvents.end())
     return std::nullopt;
-  uint32_t result = 0;
-  for (const auto &ev : it->second)
-  {
-    uint32_t tmp = std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-    if (tmp > result)
-      result = tmp;
-  }
 
-  return result;
+  return it->second->GetAggregates().fullDelayMax;
 }
 
 }  // namespace simdata
@@ -16,15 +16,24 @@ typedef std::shared_ptr<SimObserverFlow> SimObsvFlowPointer;
 class SimFlow
 {
 public:
-  SimFlow(uint32_t flowId) : m_flowId(flowId) {}
+  SimFlow(uint32_t flowId, SimArenaPointer arena = nullptr)
+      : m_simEvents(SimEventMap::allocator_type(std::move(arena))), m_flowId(flowId)
+  {
+  }
   virtual ~SimFlow() = default;
 
   void AddEvent(EventPointer simEvent);
 
-  uint32_t GetEventCount();
+  // Puts the events added out of time order in place, has to be called before they are read
+  void SortEvents();
 
+  // Moves all events of other into this flow
+  void Merge(SimFlow &other);
 
-  uint32_t GetFlowId();
+  uint32_t GetEventCount() const;
+
+
+  uint32_t GetFlowId() const;
 
 protected:
   SimEventMap m_simEvents;  // Stores all events for this flow
@@ -32,6 +41,7 @@ protected:
   uint32_t m_flowId;
 
 private:
+  friend class SimSnapshot;
 };
 
 enum class LossMmntType
@@ -52,19 +62,33 @@ std::string LossMmntTypeToString(const LossMmntType &lossMmntType);
 class SimObserverFlow : public SimFlow
 {
 public:
-  SimObserverFlow(uint32_t flowId) : SimFlow(flowId) {}
+  SimObserverFlow(uint32_t flowId, SimArenaPointer arena = nullptr)
+      : SimFlow(flowId, std::move(arena))
+  {
+  }
 
+  // The filtered flow shares all event types the filter does not change with this flow
   SimObsvFlowPointer ApplyFilter(const SimFilter &filter);
+  // Applies several filters in one pass over the events, returns one flow per filter
+  std::vector<SimObsvFlowPointer> ApplyFilters(const std::vector<SimFilter> &filters);
+  // Whether ApplyFilter changes any events, unaffected flows can be used as filtered flows
+  bool IsAffectedBy(const SimFilter &filter) const;
 
-  double GetFlowBegin();
+  double GetFlowBegin() const;
 
 
   std::optional<double> GetAvgSpinRTDelay(double time_filter) const;
+  // GetAvgSpinRTDelay for several time filters, evaluated in one pass over the events
+  std::vector<std::optional<double>> GetAvgSpinRTDelays(
+      const std::vector<double> &time_filters) const;
   std::optional<uint32_t> GetMinSpinRTDelay(double time_filter) const;
   std::optional<uint32_t> GetMaxSpinRTDelay(double time_filter) const;
   std::optional<std::list<double>> GetRawSpinRTValues(double time_filter) const;
 
   std::optional<double> GetAvgSpinEtEDelay(double time_filter) const;
+  // GetAvgSpinEtEDelay for several time filters, evaluated in one pass over the events
+  std::vector<std::optional<double>> GetAvgSpinEtEDelays(
+      const std::vector<double> &time_filters) const;
   std::optional<uint32_t> GetMinSpinEtEDelay(double time_filter) const;
   std::optional<uint32_t> GetMaxSpinEtEDelay(double time_filter) const;
   std::optional<std::list<double>> GetRawSpinEtEValues(double time_filter) const;
@@ -101,6 +125,8 @@ public:
   double GetRelativeLossMmnt(LossMmntType lossMmntType) const;
 
 protected:
+  // Sum of the losses of all loss measurement events of a type
+  uint32_t SumLoss(SimEventType eventType) const;
 
 private:
 };
@@ -108,9 +134,15 @@ private:
 class SimHostFlow : public SimFlow
 {
 public:
-  SimHostFlow(uint32_t flowId) : SimFlow(flowId) {}
+  SimHostFlow(uint32_t flowId, SimArenaPointer arena = nullptr)
+      : SimFlow(flowId, std::move(arena))
+  {
+  }
 
+  // The filtered flow shares all event types the filter does not change with this flow
   SimHostFlowPointer ApplyFilter(const SimFilter &filter);
+  // Whether ApplyFilter changes any events, unaffected flows can be used as filtered flows
+  bool IsAffectedBy(const SimFilter &filter) const;
 
   uint32_t GetTotalLBitsSent() const;
 
@@ -123,6 +155,9 @@ public:
   std::optional<uint32_t> GetMaxGtAppDelay() const;
 
 protected:
+  std::optional<double> GetAvgDelay(SimEventType eventType) const;
+  std::optional<uint32_t> GetMinDelay(SimEventType eventType) const;
+  std::optional<uint32_t> GetMaxDelay(SimEventType eventType) const;
 
 private:
 };
@@ -0,0 +1,92 @@
+#ifndef SIM_ID_MAP_H
+#define SIM_ID_MAP_H
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace simdata {
+
+// Map from ids (node ids, flow ids, or pairs of them) to values, stored in one vector sorted by
+// id. Lookups are a binary search over contiguous memory instead of a tree walk, and iteration
+// visits the entries in ascending id order like std::map.
+//
+// Inserting an id greater than all others is an append, which is the common case when importing
+// (ids mostly appear in ascending order). Other inserts move the following entries, and like for
+// std::vector, inserts invalidate iterators and references to entries.
+template <typename Key, typename Value>
+class SimIdMap
+{
+public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+  typedef std::pair<Key, Value> value_type;
+  typedef typename std::vector<value_type>::iterator iterator;
+  typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+  iterator begin() { return m_entries.begin(); }
+  iterator end() { return m_entries.end(); }
+  const_iterator begin() const { return m_entries.begin(); }
+  const_iterator end() const { return m_entries.end(); }
+
+  size_t size() const { return m_entries.size(); }
+  bool empty() const { return m_entries.empty(); }
+  void clear() { m_entries.clear(); }
+  void reserve(size_t n) { m_entries.reserve(n); }
+
+  iterator find(const Key &key)
+  {
+    iterator it = LowerBound(key);
+    return it != m_entries.end() && it->first == key ? it : m_entries.end();
+  }
+  const_iterator find(const Key &key) const
+  {
+    return const_cast<SimIdMap *>(this)->find(key);
+  }
+  size_t count(const Key &key) const { return find(key) != end() ? 1 : 0; }
+
+  Value &at(const Key &key)
+  {
+    iterator it = find(key);
+    if (it == m_entries.end())
+      throw std::out_of_range("Id not found.");
+    return it->second;
+  }
+  const Value &at(const Key &key) const { return const_cast<SimIdMap *>(this)->at(key); }
+
+  Value &operator[](const Key &key) { return insert(value_type(key, Value())).first->second; }
+
+  /// @brief Inserts an entry unless the id exists already (like std::map::insert)
+  std::pair<iterator, bool> insert(value_type entry)
+  {
+    if (m_entries.empty() || m_entries.back().first < entry.first)
+    {
+      m_entries.push_back(std::move(entry));
+      return std::make_pair(m_entries.end() - 1, true);
+    }
+
+    iterator it = LowerBound(entry.first);
+    if (it != m_entries.end() && it->first == entry.first)
+      return std::make_pair(it, false);
+    return std::make_pair(m_entries.insert(it, std::move(entry)), true);
+  }
+  /// @brief Inserts an entry, the hint is ignored (appending is fast anyway)
+  iterator insert(const_iterator /*hint*/, value_type entry)
+  {
+    return insert(std::move(entry)).first;
+  }
+
+private:
+  iterator LowerBound(const Key &key)
+  {
+    return std::lower_bound(m_entries.begin(), m_entries.end(), key,
+                            [](const value_type &entry, const Key &k) { return entry.first < k; });
+  }
+
+  std::vector<value_type> m_entries;
+};
+
+}  // namespace simdata
+
+#endif  // SIM_ID_MAP_H
@@ -6,15 +6,19 @@ void SimPath::AddEvent(EventPointer simEvent)
 {
   if (!simEvent->IsPathEvent())
     throw std::runtime_error("SimPath::AddEvent: Event is not a path event");
-  m_simEvents[simEvent->eventType].insert(simEvent);
+  GetMutableEvents(m_simEvents, simEvent->eventType).Insert(*simEvent);
 }
 
+void SimPath::SortEvents() { SortSimEventMap(m_simEvents); }
+
+void SimPath::Merge(SimPath &other) { MergeSimEventMap(m_simEvents, other.m_simEvents); }
+
 uint32_t SimPath::GetEventCount() const
 {
   uint32_t count = 0;
   for (auto it = m_simEvents.begin(); it != m_simEvents.end(); it++)
   {
-    count += it->second.size();
+    count += it->second->Size();
   }
   return count;
 }
@@ -27,8 +31,8 @@ uint32_t SimPath::GetSQPacketCount() const
     return 0;
   }
 
-  // The multiset is ordered by time, so the last element is the final one
-  return std::static_pointer_cast<EfmSignedLossMeasurementEvent>(*it->second.rbegin())->pkt_count;
+  // The events are ordered by time, so the last element is the final one
+  return it->second->pktCount.back();
 }
 
 uint32_t SimPath::GetAbsoluteLBitLoss() const
@@ -37,7 +41,7 @@ uint32_t SimPath::GetAbsoluteLBitLoss() const
   if (it == m_simEvents.end())
     return 0;
 
-  return it->second.size();
+  return it->second->Size();
 }
 
 int32_t SimPath::GetAbsoluteFinalSQBitsLoss() const
@@ -48,8 +52,8 @@ int32_t SimPath::GetAbsoluteFinalSQBitsLoss() const
     return 0;
   }
 
-  // The multiset is ordered by time, so the last element is the final one
-  return std::static_pointer_cast<EfmSignedLossMeasurementEvent>(*it->second.rbegin())->loss;
+  // The events are ordered by time, so the last element is the final one
+  return it->second->signedLoss.back();
 }
 
 double SimPath::GetAbsoluteAvgSQBitsLoss() const
@@ -60,12 +64,7 @@ double SimPath::GetAbsoluteAvgSQBitsLoss() const
     return 0;
   }
 
-  double avg = 0.0;
-  for (const auto &ev : it->second)
-  {
-    avg += std::static_pointer_cast<EfmSignedLossMeasurementEvent>(ev)->loss;
-  }
-  return avg / it->second.size();
+  return it->second->GetAggregates().signedLossSum / it->second->Size();
 }
 
 double SimPath::GetRelativeLBitLoss() const
@@ -73,15 +72,10 @@ double SimPath::GetRelativeLBitLoss() const
   auto it = m_simEvents.find(SimEventType::OBSV_P_L_BIT_SET);
   if (it == m_simEvents.end())
     return 0.0;
-  uint32_t totalPackets = 0;
-  for (const auto &ev : it->second)
-  {
-    uint32_t pkt_count = std::static_pointer_cast<EfmBitSetPCountEvent>(ev)->pkt_count;
-    totalPackets = totalPackets > pkt_count ? totalPackets : pkt_count;
-  }
+  uint32_t totalPackets = it->second->GetAggregates().pktCountMax;
 
   if (totalPackets > 0)
-    return ((double)it->second.size()) / (totalPackets);
+    return ((double)it->second->Size()) / (totalPackets);
   else
     return 0.0;
 }
@@ -94,9 +88,10 @@ double SimPath::GetRelativeFinalSQBitsLoss() const
     return 0;
   }
 
-  // The multiset is ordered by time, so the last element is the final one
-  auto event = std::static_pointer_cast<EfmSignedLossMeasurementEvent>(*it->second.rbegin());
-  return (double)event->loss / (event->pkt_count + event->loss);  // TODO: Rethink this computation
+  // The events are ordered by time, so the last element is the final one
+  int32_t loss = it->second->signedLoss.back();
+  uint32_t pktCount = it->second->pktCount.back();
+  return (double)loss / (pktCount + loss);  // TODO: Rethink this computation
 }
 
 double SimPath::GetRelativeAvgSQBitsLoss() const
@@ -107,14 +102,8 @@ double SimPath::GetRelativeAvgSQBitsLoss() const
     return 0;
   }
 
-  double avg = 0.0;
-  for (const auto &ev : it->second)
-  {
-    auto event = std::static_pointer_cast<EfmSignedLossMeasurementEvent>(ev);
-    avg +=
-        (double)event->loss / (event->pkt_count + event->loss);  // TODO: Rethink this computation
-  }
-  return avg / it->second.size();
+  // Sum of loss / (pktCount + loss) of all events, TODO: Rethink this computation
+  return it->second->GetAggregates().relativeSignedLossSum / it->second->Size();
 }
 
 }  // namespace simdata
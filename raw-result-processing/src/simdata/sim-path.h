@@ -10,10 +10,19 @@ namespace simdata {
 class SimPath
 {
 public:
-  SimPath(uint32_t pathId) : m_pathId(pathId) {}
+  SimPath(uint32_t pathId, SimArenaPointer arena = nullptr)
+      : m_simEvents(SimEventMap::allocator_type(std::move(arena))), m_pathId(pathId)
+  {
+  }
 
   void AddEvent(EventPointer simEvent);
 
+  // Puts the events added out of time order in place, has to be called before they are read
+  void SortEvents();
+
+  // Moves all events of other into this path
+  void Merge(SimPath &other);
+
   uint32_t GetPathId() const { return m_pathId; }
 
   uint32_t GetEventCount() const;
@@ -35,6 +44,7 @@ protected:
   uint32_t m_pathId;
 
 private:
+  friend class SimSnapshot;
 };
 typedef std::shared_ptr<SimPath> SimPathPointer;
 
@@ -7,15 +7,19 @@ void SimPingPair::AddEvent(EventPointer simEvent)
   if ((m_ppType == PingPairType::CLIENT && !simEvent->IsPingClientEvent()) ||
       (m_ppType == PingPairType::SERVER && !simEvent->IsPingServerEvent()))
     throw std::runtime_error("SimPingPair::AddEvent: Event does not have the correct type");
-  m_simEvents[simEvent->eventType].insert(simEvent);
+  GetMutableEvents(m_simEvents, simEvent->eventType).Insert(*simEvent);
 }
 
+void SimPingPair::SortEvents() { SortSimEventMap(m_simEvents); }
+
+void SimPingPair::Merge(SimPingPair &other) { MergeSimEventMap(m_simEvents, other.m_simEvents); }
+
 uint32_t SimPingPair::GetEventCount() const
 {
   uint32_t count = 0;
   for (auto it = m_simEvents.begin(); it != m_simEvents.end(); it++)
   {
-    count += it->second.size();
+    count += it->second->Size();
   }
   return count;
 }
@@ -26,20 +30,20 @@ uint32_t SimPingPair::GetAbsoluteLoss() const
   if (m_ppType == PingPairType::CLIENT)
   {
     auto it = m_simEvents.find(SimEventType::PING_RT_LOSS);
-    if (it == m_simEvents.end() || it->second.size() == 0)
+    if (it == m_simEvents.end() || it->second->Size() == 0)
       return 0;
 
-    // The multiset is ordered by time, so the last element is the final one
-    return std::static_pointer_cast<EfmLossMeasurementEvent>(*it->second.rbegin())->loss;
+    // The events are ordered by time, so the last element is the final one
+    return it->second->loss.back();
   }
   else if (m_ppType == PingPairType::SERVER)
   {
     auto it = m_simEvents.find(SimEventType::PING_ETE_LOSS);
-    if (it == m_simEvents.end() || it->second.size() == 0)
+    if (it == m_simEvents.end() || it->second->Size() == 0)
       return 0;
 
-    // The multiset is ordered by time, so the last element is the final one
-    return std::static_pointer_cast<EfmLossMeasurementEvent>(*it->second.rbegin())->loss;
+    // The events are ordered by time, so the last element is the final one
+    return it->second->loss.back();
   }
   else
   {
@@ -52,28 +56,18 @@ std::optional<double> SimPingPair::GetAvgDelay() const
   if (m_ppType == PingPairType::CLIENT)
   {
     auto it = m_simEvents.find(SimEventType::PING_RT_DELAY);
-    if (it == m_simEvents.end() || it->second.size() == 0)
+    if (it == m_simEvents.end() || it->second->Size() == 0)
       return std::nullopt;
 
-    double result = 0.0;
-    for (const auto &ev : it->second)
-    {
-      result += std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-    }
-    return result / it->second.size();
+    return it->second->GetAggregates().fullDelaySum / it->second->Size();
   }
   else if (m_ppType == PingPairType::SERVER)
   {
     auto it = m_simEvents.find(SimEventType::PING_ETE_DELAY);
-    if (it == m_simEvents.end() || it->second.size() == 0)
+    if (it == m_simEvents.end() || it->second->Size() == 0)
       return std::nullopt;
 
-    double result = 0.0;
-    for (const auto &ev : it->second)
-    {
-      result += std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms;
-    }
-    return result / it->second.size();
+    return it->second->GetAggregates().fullDelaySum / it->second->Size();
   }
   else
   {
@@ -87,26 +81,26 @@ std::optional<std::list<double>> SimPingPair::GetRawPingDelayValues() const
   if (m_ppType == PingPairType::CLIENT)
   {
     auto it = m_simEvents.find(SimEventType::PING_RT_DELAY);
-    if (it == m_simEvents.end() || it->second.size() == 0)
+    if (it == m_simEvents.end() || it->second->Size() == 0)
       return std::nullopt;
 
     std::list<double> result;
-    for (const auto &ev : it->second)
+    for (uint32_t delay : it->second->fullDelayMs)
     {
-      result.push_back(std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms);
+      result.push_back(delay);
     }
     return result;
   }
   else if (m_ppType == PingPairType::SERVER)
   {
     auto it = m_simEvents.find(SimEventType::PING_ETE_DELAY);
-    if (it == m_simEvents.end() || it->second.size() == 0)
+    if (it == m_simEvents.end() || it->second->Size() == 0)
       return std::nullopt;
 
     std::list<double> result;
-    for (const auto &ev : it->second)
+    for (uint32_t delay : it->second->fullDelayMs)
     {
-      result.push_back(std::static_pointer_cast<EfmDelayMeasurementEvent>(ev)->full_delay_ms);
+      result.push_back(delay);
     }
     return result;
   }
@@ -123,22 +117,22 @@ double SimPingPair::GetRelativeLoss() const
   if (m_ppType == PingPairType::CLIENT)
   {
     auto it = m_simEvents.find(SimEventType::PING_RT_LOSS);
-    if (it == m_simEvents.end() || it->second.size() == 0)
+    if (it == m_simEvents.end() || it->second->Size() == 0)
       return 0.0;
 
-    // The multiset is ordered by time, so the last element is the final one
-    auto event = std::static_pointer_cast<EfmLossMeasurementEvent>(*it->second.rbegin());
-    return event->loss / (event->pkt_count + event->loss);
+    // The events are ordered by time, so the last element is the final one
+    uint32_t loss = it->second->loss.back();
+    return loss / (it->second->pktCount.back() + loss);
   }
   else if (m_ppType == PingPairType::SERVER)
   {
     auto it = m_simEvents.find(SimEventType::PING_ETE_LOSS);
-    if (it == m_simEvents.end() || it->second.size() == 0)
+    if (it == m_simEvents.end() || it->second->Size() == 0)
       return 0.0;
 
-    // The multiset is ordered by time, so the last element is the final one
-    auto event = std::static_pointer_cast<EfmLossMeasurementEvent>(*it->second.rbegin());
-    return event->loss / (event->pkt_count + event->loss);
+    // The events are ordered by time, so the last element is the final one
+    uint32_t loss = it->second->loss.back();
+    return loss / (it->second->pktCount.back() + loss);
   }
   else
   {
@@ -16,13 +16,21 @@ enum class PingPairType
 class SimPingPair
 {
 public:
-  SimPingPair(PingPairType ppType, uint32_t targetNodeId)
-      : m_ppType(ppType), m_targetNodeId(targetNodeId)
+  SimPingPair(PingPairType ppType, uint32_t targetNodeId, SimArenaPointer arena = nullptr)
+      : m_simEvents(SimEventMap::allocator_type(std::move(arena))),
+        m_ppType(ppType),
+        m_targetNodeId(targetNodeId)
   {
   }
 
   void AddEvent(EventPointer simEvent);
 
+  // Puts the events added out of time order in place, has to be called before they are read
+  void SortEvents();
+
+  // Moves all events of other into this ping pair
+  void Merge(SimPingPair &other);
+
   uint32_t GetTargetNodeId() const { return m_targetNodeId; }
 
   PingPairType GetPingPairType() const { return m_ppType; }
@@ -42,6 +50,7 @@ protected:
   uint32_t m_targetNodeId;
 
 private:
+  friend class SimSnapshot;
 };
 typedef std::shared_ptr<SimPingPair> SimPingPairPointer;
 
@@ -1,11 +1,17 @@
 #include "sim-result-set.h"
 
+#include <algorithm>
 #include <iostream>
+#include <memory_resource>
+
+#include "sim-trace-index.h"
 
 namespace simdata {
 
 
-SimResultSet::SimResultSet(simdjson::ondemand::object &qlog)
+SimResultSet::SimResultSet(simdjson::ondemand::object &qlog,
+                           std::optional<SimEventTypeSet> eventTypes)
+    : m_eventTypes(std::move(eventTypes))
 {
   using namespace simdjson;
 
@@ -43,6 +49,7 @@ SimResultSet::SimResultSet() {}
 void SimResultSet::ImportAndAppendResult(simdjson::ondemand::object &result)
 {
   using namespace simdjson;
+  InvalidateDerivedData();
   ondemand::array traces = result["traces"];
   try
   {
@@ -58,6 +65,141 @@ void SimResultSet::ImportAndAppendResult(simdjson::ondemand::object &result)
   }
 }
 
+SimResultSetPointer SimResultSet::ImportFragment(simdjson::ondemand::object &fragment,
+                                                 std::optional<SimEventTypeSet> eventTypes)
+{
+  // Constructor is private, so make_shared cannot be used here
+  SimResultSetPointer srs(new SimResultSet());
+  srs->m_eventTypes = std::move(eventTypes);
+  srs->ImportAndAppendResult(fragment);
+  return srs;
+}
+
+void SimResultSet::MergeFragment(SimResultSet &fragment)
+{
+  InvalidateDerivedData();
+  for (auto it = fragment.m_vpClients.begin(); it != fragment.m_vpClients.end(); it++)
+  {
+    auto vpIt = m_vpClients.find(it->first);
+    if (vpIt == m_vpClients.end())
+      m_vpClients.insert(*it);
+    else
+      vpIt->second->Merge(*it->second);
+  }
+
+  for (auto it = fragment.m_vpServers.begin(); it != fragment.m_vpServers.end(); it++)
+  {
+    auto vpIt = m_vpServers.find(it->first);
+    if (vpIt == m_vpServers.end())
+      m_vpServers.insert(*it);
+    else
+      vpIt->second->Merge(*it->second);
+  }
+
+  for (auto it = fragment.m_vpObservers.begin(); it != fragment.m_vpObservers.end(); it++)
+  {
+    auto vpIt = m_vpObservers.find(it->first);
+    if (vpIt == m_vpObservers.end())
+      m_vpObservers.insert(*it);
+    else
+      vpIt->second->Merge(*it->second);
+  }
+
+  for (auto it = fragment.m_eventCount.begin(); it != fragment.m_eventCount.end(); it++)
+  {
+    m_eventCount[it->first] += it->second;
+  }
+
+  fragment.m_vpClients.clear();
+  fragment.m_vpServers.clear();
+  fragment.m_vpObservers.clear();
+  fragment.m_eventCount.clear();
+}
+
+SimResultSetPointer SimResultSet::ImportIndexed(SimTraceIndexPointer index,
+                                                std::optional<SimEventTypeSet> eventTypes)
+{
+  using namespace simdjson;
+
+  // Constructor is private, so make_shared cannot be used here
+  SimResultSetPointer srs(new SimResultSet());
+  srs->m_eventTypes = std::move(eventTypes);
+  srs->m_simId = index->GetSimId();
+
+  ondemand::parser parser;
+  padded_string summaryJson = index->Load(index->GetSummaryLocation());
+  ondemand::document doc = parser.iterate(summaryJson);
+  ondemand::object summary = doc.get_object();
+  try
+  {
+    srs->ImportSummary(summary);
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "SimResultSet failed to import summary: " << e.what() << '\n';
+    throw;
+  }
+
+  srs->m_traceIndex = std::move(index);
+  return srs;
+}
+
+void SimResultSet::LoadVantagePoints(VantagePointType type, const std::set<uint32_t> &nodeIds)
+{
+  using namespace simdjson;
+
+  if (!m_traceIndex)
+    return;
+
+  ondemand::parser parser;
+  for (uint32_t nodeId : nodeIds)
+  {
+    if (m_loadedVantagePoints.count(std::make_pair(type, nodeId)))
+      continue;
+    // Cached views and flow paths do not contain the new vantage point
+    InvalidateDerivedData();
+    m_loadedVantagePoints.insert(std::make_pair(type, nodeId));
+
+    for (const auto &location : m_traceIndex->GetTraceLocations(type, nodeId))
+    {
+      padded_string traceJson = m_traceIndex->Load(location);
+      ondemand::document doc = parser.iterate(traceJson);
+      ondemand::object trace = doc.get_object();
+      try
+      {
+        ImportTrace(trace);
+      }
+      catch (const std::exception &e)
+      {
+        std::cerr << "SimResultSet failed to import trace: " << e.what() << '\n';
+        throw;
+      }
+    }
+  }
+}
+
+void SimResultSet::LoadVantagePoints(VantagePointType type)
+{
+  if (m_traceIndex)
+    LoadVantagePoints(type, m_traceIndex->GetNodeIds(type));
+}
+
+ConstSimResultSetPointer SimResultSet::Freeze()
+{
+  if (!m_frozen)
+  {
+    if (!m_flowPaths)
+      BuildFlowPaths();
+    BuildIdSets();
+
+    std::lock_guard<std::mutex> lock(*m_viewMutex);
+    for (auto it = m_filteredViews.begin(); it != m_filteredViews.end(); it++)
+      it->second->Freeze();
+    m_frozen = true;
+  }
+  return shared_from_this();
+}
+
 void SimResultSet::ImportSummary(simdjson::ondemand::object &summary)
 {
   using namespace simdjson;
@@ -286,6 +428,26 @@ void SimResultSet::ImportSummary(simdjson::ondemand::object &summary)
       m_backboneOverrides[std::make_pair(lc.sourceNodeId, lc.destNodeId)] = lc;
     }
   }
+
+  IndexObserverFlows();
+}
+
+void SimResultSet::IndexObserverFlows()
+{
+  m_observerFlowIndex.clear();
+  m_reverseFlowIds.clear();
+  m_observerFlowIndex.reserve(m_observerFlowInfo.size());
+
+  // Flows are visited in ascending id order, so emplace keeps the lowest id per five tuple
+  for (auto it = m_observerFlowInfo.begin(); it != m_observerFlowInfo.end(); it++)
+    m_observerFlowIndex.emplace(it->second, it->first);
+
+  for (auto it = m_observerFlowInfo.begin(); it != m_observerFlowInfo.end(); it++)
+  {
+    auto revIt = m_observerFlowIndex.find(it->second.GetReversed());
+    if (revIt != m_observerFlowIndex.end())
+      m_reverseFlowIds[it->first] = revIt->second;
+  }
 }
 
 void SimResultSet::ImportTrace(simdjson::ondemand::object &trace)
@@ -311,7 +473,8 @@ void SimResultSet::ImportTrace(simdjson::ondemand::object &trace)
       hvp_it = m_vpClients.find(vp_nodeId);
       if (hvp_it == m_vpClients.end())
       {
-        HostVantagePointPointer hvp_p = std::make_shared<SimHostVantagePoint>(vp_type, vp_nodeId);
+        HostVantagePointPointer hvp_p =
+            MakeArenaShared<SimHostVantagePoint>(m_arena, vp_type, vp_nodeId, m_arena);
         m_vpClients.insert(std::make_pair(vp_nodeId, hvp_p));
         vp_p = hvp_p;
       }
@@ -322,7 +485,8 @@ void SimResultSet::ImportTrace(simdjson::ondemand::object &trace)
       hvp_it = m_vpServers.find(vp_nodeId);
       if (hvp_it == m_vpServers.end())
       {
-        HostVantagePointPointer hvp_p = std::make_shared<SimHostVantagePoint>(vp_type, vp_nodeId);
+        HostVantagePointPointer hvp_p =
+            MakeArenaShared<SimHostVantagePoint>(m_arena, vp_type, vp_nodeId, m_arena);
         m_vpServers.insert(std::make_pair(vp_nodeId, hvp_p));
         vp_p = hvp_p;
       }
@@ -333,7 +497,8 @@ void SimResultSet::ImportTrace(simdjson::ondemand::object &trace)
       ovp_it = m_vpObservers.find(vp_nodeId);
       if (ovp_it == m_vpObservers.end())
       {
-        ObsvVantagePointPointer ovp_p = std::make_shared<SimObsvVantagePoint>(vp_type, vp_nodeId);
+        ObsvVantagePointPointer ovp_p =
+            MakeArenaShared<SimObsvVantagePoint>(m_arena, vp_type, vp_nodeId, m_arena);
         m_vpObservers.insert(std::make_pair(vp_nodeId, ovp_p));
         vp_p = ovp_p;
       }
@@ -345,10 +510,17 @@ void SimResultSet::ImportTrace(simdjson::ondemand::object &trace)
       return;
       break;
   }
+
+  // Host traces only contain host events, so skip them as a whole if none of those are needed
+  if (m_eventTypes.has_value() && vp_type != VantagePointType::NETWORK &&
+      std::none_of(m_eventTypes->begin(), m_eventTypes->end(), IsHostEventType))
+    return;
+
   try
   {
     ondemand::array events = trace["events"];
     CreateAndStoreEvents(events, vp_p);
+    vp_p->SortEvents();
   }
   catch (const std::exception &e)
   {
@@ -359,9 +531,14 @@ void SimResultSet::ImportTrace(simdjson::ondemand::object &trace)
 
 void SimResultSet::CreateAndStoreEvents(simdjson::ondemand::array &events, VantagePointPointer &vp)
 {
+  // Events are only needed until their data is stored by the vantage point, so the pool reuses the
+  // memory of the previous event instead of allocating from the heap for every event
+  std::pmr::unsynchronized_pool_resource eventMemory;
   for (simdjson::ondemand::object it : events)
   {
-    EventPointer ev_p = CreateEvent(it);
+    EventPointer ev_p = CreateEvent(it, m_eventTypes, &eventMemory);
+    if (!ev_p)
+      continue;
     vp->AddEvent(ev_p);
     m_eventCount[ev_p->eventType]++;
   }
@@ -370,30 +547,109 @@ void SimResultSet::CreateAndStoreEvents(simdjson::ondemand::array &events, Vanta
 
 SimResultSetPointer SimResultSet::ApplyFilter(const SimFilter &filter) const
 {
-  // Clone result set
-  SimResultSetPointer srs = std::make_shared<SimResultSet>(*this);
-
-  srs->m_filter = filter;
-
+  return ApplyFilters({filter}).front();
+}
 
-  // Apply filter recursively to all VantagePoints
+std::vector<SimResultSetPointer> SimResultSet::ApplyFilters(
+    const std::vector<SimFilter> &filters) const
+{
+  std::lock_guard<std::mutex> lock(*m_viewMutex);
 
-  for (auto it = srs->m_vpClients.begin(); it != srs->m_vpClients.end(); it++)
+  // Filters whose views have to be created, without duplicates
+  std::vector<SimFilter> missing;
+  for (const SimFilter &filter : filters)
   {
-    srs->m_vpClients[it->first] = it->second->ApplyFilter(filter);
+    // The default filter does not change anything, the result set is only read by the analyses
+    if (!filter.IsDefault() && m_filteredViews.find(filter) == m_filteredViews.end() &&
+        std::find(missing.begin(), missing.end(), filter) == missing.end())
+      missing.push_back(filter);
   }
 
-  for (auto it = srs->m_vpServers.begin(); it != srs->m_vpServers.end(); it++)
+  if (!missing.empty())
   {
-    srs->m_vpServers[it->first] = it->second->ApplyFilter(filter);
+    // Build the flow paths before cloning, so that the views share them
+    if (!m_flowPaths)
+      BuildFlowPaths();
+
+    std::vector<SimResultSetPointer> views;
+    for (const SimFilter &filter : missing)
+    {
+      // Clone result set
+      SimResultSetPointer srs = std::make_shared<SimResultSet>(*this);
+
+      srs->m_filter = filter;
+      srs->m_filteredViews.clear();
+      srs->m_viewMutex = std::make_shared<std::mutex>();
+      srs->m_idSets = IdSets();
+      srs->m_frozen = false;
+      // Vantage points have to be loaded into the unfiltered result set
+      srs->m_traceIndex.reset();
+      srs->m_loadedVantagePoints.clear();
+      srs->m_arena.reset();
+      views.push_back(srs);
+    }
+
+
+    // Apply filters recursively to all VantagePoints they change, the others are shared
+
+    for (auto it = m_vpClients.begin(); it != m_vpClients.end(); it++)
+    {
+      for (size_t i = 0; i < missing.size(); i++)
+      {
+        if (it->second->IsAffectedBy(missing[i]))
+          views[i]->m_vpClients[it->first] = it->second->ApplyFilter(missing[i]);
+      }
+    }
+
+    for (auto it = m_vpServers.begin(); it != m_vpServers.end(); it++)
+    {
+      for (size_t i = 0; i < missing.size(); i++)
+      {
+        if (it->second->IsAffectedBy(missing[i]))
+          views[i]->m_vpServers[it->first] = it->second->ApplyFilter(missing[i]);
+      }
+    }
+
+    // Observers are filtered by all filters that change them at once
+    for (auto it = m_vpObservers.begin(); it != m_vpObservers.end(); it++)
+    {
+      std::vector<SimFilter> vpFilters;
+      std::vector<size_t> vpFilterIndices;
+      for (size_t i = 0; i < missing.size(); i++)
+      {
+        if (it->second->IsAffectedBy(missing[i]))
+        {
+          vpFilters.push_back(missing[i]);
+          vpFilterIndices.push_back(i);
+        }
+      }
+      if (vpFilters.empty())
+        continue;
+
+      std::vector<ObsvVantagePointPointer> filteredVps = it->second->ApplyFilters(vpFilters);
+      for (size_t i = 0; i < filteredVps.size(); i++)
+        views[vpFilterIndices[i]]->m_vpObservers[it->first] = filteredVps[i];
+    }
+
+    for (size_t i = 0; i < missing.size(); i++)
+    {
+      // Views of a frozen result set are read concurrently as well
+      if (m_frozen)
+        views[i]->Freeze();
+      m_filteredViews[missing[i]] = views[i];
+    }
   }
 
-  for (auto it = srs->m_vpObservers.begin(); it != srs->m_vpObservers.end(); it++)
+  std::vector<SimResultSetPointer> result;
+  result.reserve(filters.size());
+  for (const SimFilter &filter : filters)
   {
-    srs->m_vpObservers[it->first] = it->second->ApplyFilter(filter);
+    if (filter.IsDefault())
+      result.push_back(std::const_pointer_cast<SimResultSet>(shared_from_this()));
+    else
+      result.push_back(m_filteredViews.at(filter));
   }
-
-  return srs;
+  return result;
 }
 
 
@@ -483,47 +739,56 @@ ObsvVantagePointPointer SimResultSet::GetObserverVP(uint32_t id) const
     throw std::runtime_error("SimResultSet::GetObserverVP: No such VP");
 }
 
-std::set<uint32_t> SimResultSet::GetServerVPIds(bool relevantOnly) const
+const std::set<uint32_t> &SimResultSet::GetServerVPIds(bool relevantOnly) const
 {
-  if (relevantOnly)
+  if (!relevantOnly)
+    return m_serverIds;
+
+  if (!m_idSets.relevantServerIds)
   {
-    std::set<uint32_t> ids;
+    std::set<uint32_t> &ids = m_idSets.relevantServerIds.emplace();
     for (auto it = m_vpServers.begin(); it != m_vpServers.end(); it++)
     {
       if (it->second->GetEventCount() > 0)
-        ids.insert(it->first);
+        ids.insert(ids.end(), it->first);
     }
-    return ids;
   }
-  else
-    return m_serverIds;
+  return *m_idSets.relevantServerIds;
 }
 
-std::set<uint32_t> SimResultSet::GetClientVPIds(bool relevantOnly) const
+const std::set<uint32_t> &SimResultSet::GetClientVPIds(bool relevantOnly) const
 {
-  if (relevantOnly)
+  if (!relevantOnly)
+    return m_clientIds;
+
+  if (!m_idSets.relevantClientIds)
   {
-    std::set<uint32_t> ids;
+    std::set<uint32_t> &ids = m_idSets.relevantClientIds.emplace();
     for (auto it = m_vpClients.begin(); it != m_vpClients.end(); it++)
     {
       if (it->second->GetEventCount() > 0)
-        ids.insert(it->first);
+        ids.insert(ids.end(), it->first);
     }
-    return ids;
   }
-  else
-    return m_clientIds;
+  return *m_idSets.relevantClientIds;
 }
 
-std::set<uint32_t> SimResultSet::GetObserverVPIds(bool relevantOnly, bool realOnly) const
+const std::set<uint32_t> &SimResultSet::GetObserverVPIds(bool relevantOnly, bool realOnly) const
 {
+  if (!relevantOnly && !realOnly)
+    return m_observerIds;
+
+  auto cached = m_idSets.observerIds.find(std::make_pair(relevantOnly, realOnly));
+  if (cached != m_idSets.observerIds.end())
+    return cached->second;
+
   std::set<uint32_t> ids;
   if (relevantOnly)
   {
     for (auto it = m_vpObservers.begin(); it != m_vpObservers.end(); it++)
     {
       if (it->second->GetEventCount() > 0)
-        ids.insert(it->first);
+        ids.insert(ids.end(), it->first);
     }
   }
   else
@@ -534,140 +799,212 @@ std::set<uint32_t> SimResultSet::GetObserverVPIds(bool relevantOnly, bool realOn
   if (realOnly)
   {
     std::set<uint32_t> realIds;
-    auto serverIds = GetServerVPIds(false);
-    auto clientIds = GetClientVPIds(false);
+    const std::set<uint32_t> &serverIds = GetServerVPIds(false);
+    const std::set<uint32_t> &clientIds = GetClientVPIds(false);
 
     for (auto &id : ids)
     {
       if (serverIds.find(id) == serverIds.end() && clientIds.find(id) == clientIds.end())
-        realIds.insert(id);
+        realIds.insert(realIds.end(), id);
     }
-    return realIds;
+    ids = std::move(realIds);
   }
-  else
-    return ids;
+
+  return m_idSets.observerIds[std::make_pair(relevantOnly, realOnly)] = std::move(ids);
 }
 
-std::set<uint32_t> SimResultSet::GetClientConnIds() const
+const std::set<uint32_t> &SimResultSet::GetClientConnIds() const
 {
-  std::set<uint32_t> ids;
-  for (auto &cid : GetClientVPIds(true))
+  if (!m_idSets.clientConnIds)
   {
-    auto fids = GetClientConnIds(cid);
-    ids.insert(fids.begin(), fids.end());
+    std::set<uint32_t> &ids = m_idSets.clientConnIds.emplace();
+    for (auto &cid : GetClientVPIds(true))
+    {
+      const std::set<uint32_t> &fids = GetClientConnIds(cid);
+      ids.insert(fids.begin(), fids.end());
+    }
   }
-  return ids;
+  return *m_idSets.clientConnIds;
 }
 
-std::set<uint32_t> SimResultSet::GetClientConnIds(uint32_t clientId) const
+const std::set<uint32_t> &SimResultSet::GetClientConnIds(uint32_t clientId) const
 {
-  std::set<uint32_t> ids;
-  HostVantagePointPointer client;
-  if (!TryGetClientVP(clientId, client))
+  auto it = m_vpClients.find(clientId);
+  if (it == m_vpClients.end())
     throw std::runtime_error("Invalid client id.");
 
-  return client->GetFlowIds();
+  return it->second->GetFlowIds();
 }
 
-std::set<uint32_t> SimResultSet::GetServerConnIds() const
+const std::set<uint32_t> &SimResultSet::GetServerConnIds() const
 {
-  std::set<uint32_t> ids;
-  for (auto &sid : GetServerVPIds(true))
+  if (!m_idSets.serverConnIds)
   {
-    auto fids = GetServerConnIds(sid);
-    ids.insert(fids.begin(), fids.end());
+    std::set<uint32_t> &ids = m_idSets.serverConnIds.emplace();
+    for (auto &sid : GetServerVPIds(true))
+    {
+      const std::set<uint32_t> &fids = GetServerConnIds(sid);
+      ids.insert(fids.begin(), fids.end());
+    }
   }
-  return ids;
+  return *m_idSets.serverConnIds;
 }
 
-std::set<uint32_t> SimResultSet::GetServerConnIds(uint32_t serverId) const
+const std::set<uint32_t> &SimResultSet::GetServerConnIds(uint32_t serverId) const
 {
-  std::set<uint32_t> ids;
-  HostVantagePointPointer server;
-  if (!TryGetServerVP(serverId, server))
+  auto it = m_vpServers.find(serverId);
+  if (it == m_vpServers.end())
     throw std::runtime_error("Invalid server id.");
 
-  return server->GetFlowIds();
+  return it->second->GetFlowIds();
 }
 
-std::set<uint32_t> SimResultSet::GetObserverFlowIds(bool realOnly) const
+const std::set<uint32_t> &SimResultSet::GetObserverFlowIds(bool realOnly) const
 {
+  auto cached = m_idSets.observerFlowIds.find(realOnly);
+  if (cached != m_idSets.observerFlowIds.end())
+    return cached->second;
+
   std::set<uint32_t> ids;
   for (auto &oid : GetObserverVPIds(true, realOnly))
   {
-    auto fids = GetObserverFlowIds(oid);
+    const std::set<uint32_t> &fids = GetObserverFlowIds(oid);
     ids.insert(fids.begin(), fids.end());
   }
-  return ids;
+  return m_idSets.observerFlowIds[realOnly] = std::move(ids);
 }
 
-std::set<uint32_t> SimResultSet::GetObserverFlowIds(uint32_t observerId) const
+const std::set<uint32_t> &SimResultSet::GetObserverFlowIds(uint32_t observerId) const
 {
-  std::set<uint32_t> ids;
-  ObsvVantagePointPointer obsv;
-  if (!TryGetObserverVP(observerId, obsv))
+  auto it = m_vpObservers.find(observerId);
+  if (it == m_vpObservers.end())
     throw std::runtime_error("Invalid observer id.");
 
-  return obsv->GetFlowIds();
+  return it->second->GetFlowIds();
 }
 
-std::set<uint32_t> SimResultSet::GetObserverFlowIds(uint32_t observerId, std::map<uint32_t, std::set<uint32_t>> flowSelectionMap) const
+std::set<uint32_t> SimResultSet::GetObserverFlowIds(
+    uint32_t observerId, const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap) const
 {
-  std::set<uint32_t> ids;
-  ObsvVantagePointPointer obsv;
-  if (!TryGetObserverVP(observerId, obsv))
-    throw std::runtime_error("Invalid observer id.");
-  std::set<uint32_t> tmp_flow_ids = obsv->GetFlowIds();
-  std::set<uint32_t> final_flow_ids;
-  for (const auto flow_id: tmp_flow_ids){
-    if (flowSelectionMap[observerId].count(flow_id)){
-        final_flow_ids.insert(flow_id);
-    }
+  const std::set<uint32_t> &flowIds = GetObserverFlowIds(observerId);
+  std::set<uint32_t> selectedFlowIds;
+  auto selection = flowSelectionMap.find(observerId);
+  if (selection == flowSelectionMap.end())
+    return selectedFlowIds;
+
+  for (uint32_t flowId : flowIds)
+  {
+    if (selection->second.count(flowId))
+      selectedFlowIds.insert(selectedFlowIds.end(), flowId);
   }
-  return final_flow_ids;
+  return selectedFlowIds;
 }
 
-std::vector<ObsvVantagePointPointer> SimResultSet::CalculateFlowPath(uint32_t flowId) const
+void SimResultSet::BuildFlowPaths() const
 {
-  std::vector<ObsvVantagePointPointer> flowPathVec;
-
-  std::map<double, ObsvVantagePointPointer> flowPath;
-
-
+  // Collect the flow begin times at all observers in one pass, instead of searching all observers
+  // for every flow
+  std::unordered_map<uint32_t, std::map<double, uint32_t>> flowBegins;
+  std::shared_ptr<FlowPathMap> flowPaths = std::make_shared<FlowPathMap>();
   for (auto it = m_vpObservers.begin(); it != m_vpObservers.end(); it++)
   {
-    SimObsvFlowPointer obsvFlow;
-    if (it->second->TryGetFlow(flowId, obsvFlow))
+    const SimObsvVantagePoint::SimObsvFlowMap &flows = it->second->GetFlows();
+    for (auto flowIt = flows.begin(); flowIt != flows.end(); flowIt++)
     {
-      double begin = obsvFlow->GetFlowBegin();
-      if (flowPath.find(begin) != flowPath.end())
-        throw std::runtime_error("Duplicate flow begin time.");
-      flowPath[begin] = it->second;
+      FlowPath &flowPath = (*flowPaths)[flowIt->first];
+      if (flowPath.error)
+        continue;
+      try
+      {
+        double begin = flowIt->second->GetFlowBegin();
+        if (!flowBegins[flowIt->first].emplace(begin, it->first).second)
+          throw std::runtime_error("Duplicate flow begin time.");
+      }
+      catch (const std::exception &)
+      {
+        // Only fail if the path of this flow is requested
+        flowPath.error = std::current_exception();
+      }
     }
   }
 
-  for (auto it = flowPath.begin(); it != flowPath.end(); it++) flowPathVec.push_back(it->second);
+  for (auto it = flowPaths->begin(); it != flowPaths->end(); it++)
+  {
+    if (it->second.error)
+      continue;
+    const std::map<double, uint32_t> &begins = flowBegins[it->first];
+    for (auto beginIt = begins.begin(); beginIt != begins.end(); beginIt++)
+    {
+      if (!it->second.observerIds.empty())
+        it->second.links.push_back(std::make_pair(it->second.observerIds.back(), beginIt->second));
+      it->second.observerIds.push_back(beginIt->second);
+    }
+  }
 
-  return flowPathVec;
+  m_flowPaths = flowPaths;
 }
 
-uint32_t SimResultSet::GetReverseFlowId(uint32_t flowId) const
+void SimResultSet::BuildIdSets() const
 {
-  auto iter = m_observerFlowInfo.find(flowId);
-  if (iter == m_observerFlowInfo.end())
-    throw std::runtime_error("FlowId not found.");
+  GetServerVPIds(true);
+  GetClientVPIds(true);
+  for (bool relevantOnly : {false, true})
+  {
+    for (bool realOnly : {false, true}) GetObserverVPIds(relevantOnly, realOnly);
+  }
+  GetClientConnIds();
+  GetServerConnIds();
+  GetObserverFlowIds(false);
+  GetObserverFlowIds(true);
+}
 
-  const FiveTuple &ft = iter->second;
+void SimResultSet::InvalidateDerivedData()
+{
+  if (m_frozen)
+    throw std::logic_error("Cannot import into a frozen result set.");
 
-  FiveTuple rev = ft.GetReversed();
+  std::lock_guard<std::mutex> lock(*m_viewMutex);
+  m_filteredViews.clear();
+  m_flowPaths.reset();
+  m_idSets = IdSets();
+}
 
-  for (auto it = m_observerFlowInfo.begin(); it != m_observerFlowInfo.end(); it++)
-  {
-    if (it->second == rev)
-      return it->first;
-  }
+const SimResultSet::FlowPath &SimResultSet::GetFlowPath(uint32_t flowId) const
+{
+  static const FlowPath noFlowPath;
+
+  if (!m_flowPaths)
+    BuildFlowPaths();
+
+  auto it = m_flowPaths->find(flowId);
+  if (it == m_flowPaths->end())
+    return noFlowPath;
+  if (it->second.error)
+    std::rethrow_exception(it->second.error);
+  return it->second;
+}
+
+std::vector<ObsvVantagePointPointer> SimResultSet::CalculateFlowPath(uint32_t flowId) const
+{
+  const FlowPath &flowPath = GetFlowPath(flowId);
+
+  std::vector<ObsvVantagePointPointer> flowPathVec;
+  flowPathVec.reserve(flowPath.observerIds.size());
+  for (uint32_t observerId : flowPath.observerIds)
+    flowPathVec.push_back(m_vpObservers.at(observerId));
 
-  throw std::runtime_error("Reverse flow ID not found.");
+  return flowPathVec;
+}
+
+uint32_t SimResultSet::GetReverseFlowId(uint32_t flowId) const
+{
+  if (m_observerFlowInfo.find(flowId) == m_observerFlowInfo.end())
+    throw std::runtime_error("FlowId not found.");
+
+  auto it = m_reverseFlowIds.find(flowId);
+  if (it == m_reverseFlowIds.end())
+    throw std::runtime_error("Reverse flow ID not found.");
+  return it->second;
 }
 
 uint32_t SimResultSet::GetObserverFlowStart(uint32_t flowId) const
@@ -686,7 +1023,8 @@ uint32_t SimResultSet::GetObserverFlowEnd(uint32_t flowId) const
   return iter->second.destNodeId;
 }
 
-std::vector<uint32_t> SimResultSet::GetPingPath(uint32_t srcNodeId, uint32_t destNodeId) const
+const std::vector<uint32_t> &SimResultSet::GetPingPath(uint32_t srcNodeId,
+                                                       uint32_t destNodeId) const
 {
   auto it = m_pingPaths.find(std::make_pair(srcNodeId, destNodeId));
   if (it == m_pingPaths.end())
@@ -696,7 +1034,7 @@ std::vector<uint32_t> SimResultSet::GetPingPath(uint32_t srcNodeId, uint32_t des
     return it->second;
 }
 
-void SimResultSet::PrintEventCounts()
+void SimResultSet::PrintEventCounts() const
 {
   std::cout << "Event Counts:" << std::endl;
   for (auto it = m_eventCount.begin(); it != m_eventCount.end(); it++)
@@ -724,6 +1062,15 @@ std::string FiveTuple::Serialize() const
          std::to_string(protocol);
 }
 
+size_t FiveTupleHash::operator()(const FiveTuple &ft) const
+{
+  // Node ids and ports fit into one 64 bit word, the protocol is mixed in separately
+  uint64_t key = (static_cast<uint64_t>(ft.sourceNodeId) << 48) ^
+                 (static_cast<uint64_t>(ft.destNodeId) << 32) ^
+                 (static_cast<uint64_t>(ft.sourcePort) << 16) ^ ft.destPort;
+  return std::hash<uint64_t>()(key) ^ (std::hash<uint8_t>()(ft.protocol) << 1);
+}
+
 bool operator==(const FiveTuple &lhs, const FiveTuple &rhs)
 {
   if (lhs.sourceNodeId != rhs.sourceNodeId)
@@ -3,14 +3,18 @@
 
 #include <simdjson.h>
 
+#include <exception>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "sim-events.h"
 #include "sim-filter.h"
+#include "sim-id-map.h"
 #include "sim-vantage-point.h"
 
 namespace simdata {
@@ -19,6 +23,10 @@ typedef std::string SimId;
 
 class SimResultSet;
 typedef std::shared_ptr<SimResultSet> SimResultSetPointer;
+typedef std::shared_ptr<const SimResultSet> ConstSimResultSetPointer;
+
+class SimTraceIndex;
+typedef std::shared_ptr<SimTraceIndex> SimTraceIndexPointer;
 
 struct FiveTuple
 {
@@ -82,16 +90,78 @@ void from_json(const nlohmann::json &j, LinkStats &stats);
 
 bool operator==(const FiveTuple &lhs, const FiveTuple &rhs);
 
+struct FiveTupleHash
+{
+  size_t operator()(const FiveTuple &ft) const;
+};
 
-// Stores all results from a single simulation run
-class SimResultSet
+
+// Stores all results from a single simulation run.
+//
+// Importing is not thread-safe. Once a result set is frozen (see Freeze), all const methods may be
+// called by any number of threads at once: the data derived on first use is created by Freeze,
+// and only the cache of filtered views is still filled later, under a lock.
+class SimResultSet : public std::enable_shared_from_this<SimResultSet>
 {
 public:
-  SimResultSet(simdjson::ondemand::object &qlog);
+  /// @param qlog The root object of a QLOG file containing a title and summary
+  /// @param eventTypes If set, only events of these types are imported, all others are skipped
+  /// without being parsed (also applies to results appended later)
+  SimResultSet(simdjson::ondemand::object &qlog,
+               std::optional<SimEventTypeSet> eventTypes = std::nullopt);
 
   void ImportAndAppendResult(simdjson::ondemand::object &result);
 
+  /// @brief Imports the traces of a fragment (a file with a title_ref instead of a title) into a
+  /// detached result set that only holds vantage points and events. Fragments can be imported
+  /// concurrently and merged into the result set they refer to afterwards.
+  /// @param fragment The root object of the fragment file
+  /// @param eventTypes If set, only events of these types are imported
+  static SimResultSetPointer ImportFragment(
+      simdjson::ondemand::object &fragment,
+      std::optional<SimEventTypeSet> eventTypes = std::nullopt);
+
+  /// @brief Moves all vantage points and events of a fragment into this result set
+  /// @param fragment A result set created by ImportFragment; it is empty afterwards
+  void MergeFragment(SimResultSet &fragment);
+
+  /// @brief Imports only the summary of a simulation run, traces are imported on demand by
+  /// LoadVantagePoints
+  /// @param index The trace index of the run
+  /// @param eventTypes If set, only events of these types are imported
+  static SimResultSetPointer ImportIndexed(
+      SimTraceIndexPointer index, std::optional<SimEventTypeSet> eventTypes = std::nullopt);
+
+  /// @brief Imports the traces of the specified vantage points unless they were imported before.
+  /// Does nothing for result sets that were not created by ImportIndexed, since those already
+  /// contain all vantage points.
+  void LoadVantagePoints(VantagePointType type, const std::set<uint32_t> &nodeIds);
+  /// @brief Imports the traces of all vantage points of a type
+  void LoadVantagePoints(VantagePointType type);
+  /// @brief Whether vantage points are imported on demand, i.e., some may be missing
+  bool IsPartiallyLoaded() const { return m_traceIndex != nullptr; }
+
+  /// @brief Ends the import: creates all data that the const methods would otherwise derive on
+  /// first use, so that the result set can be read by several threads at once. Importing into a
+  /// frozen result set (including loading further vantage points) throws std::logic_error.
+  /// Filtered views of a frozen result set are frozen as well.
+  /// @return This result set, read-only
+  ConstSimResultSetPointer Freeze();
+  bool IsFrozen() const { return m_frozen; }
+
+  /// @brief Creates a filtered view of this result set. Vantage points, flows, and event types
+  /// that the filter does not change are shared with this result set, which must not be modified
+  /// (i.e., imported into) afterwards.
+  /// @param filter The filter
+  /// @return The filtered result set, or this result set itself for the default filter. Views are
+  /// cached per filter value, so applying the same filter again returns the same view. Creating
+  /// views is thread-safe, unlike importing.
   SimResultSetPointer ApplyFilter(const SimFilter &filter) const;
+  /// @brief Creates filtered views for several filters (see ApplyFilter). Views that are not cached
+  /// yet are created in a single pass over the vantage points and flows, sharing the work and the
+  /// filtered events of filters with common parts.
+  /// @return One view per filter, in the order of filters
+  std::vector<SimResultSetPointer> ApplyFilters(const std::vector<SimFilter> &filters) const;
 
 
   SimId GetSimId() const { return m_simId; }
@@ -103,8 +173,22 @@ public:
   typedef std::map<std::pair<uint32_t, uint32_t>, LinkConfig> LinkOverrideMap;
   typedef std::pair<uint32_t, uint32_t> Link;
   typedef std::vector<Link> LinkVector;
+  // Maps each observer flow id to the id of its reverse flow
+  typedef std::unordered_map<uint32_t, uint32_t> FlowPairMap;
+
+  struct FlowPath
+  {
+    // The observers that saw the flow, ordered by the begin of the flow at the observer
+    std::vector<uint32_t> observerIds;
+    // The links between consecutive observers, empty for paths with less than two observers
+    LinkVector links;
+    // Set if the path could not be calculated, rethrown by GetFlowPath
+    std::exception_ptr error;
+  };
 
   const FlowInfoMap &GetObserverFlowInfo() const { return m_observerFlowInfo; }
+  /// @brief Forward/reverse pairs of all observer flows, flows without reverse flow are missing
+  const FlowPairMap &GetReverseFlowIds() const { return m_reverseFlowIds; }
   const FlowInfoMap &GetHostConnInfo() const { return m_hostConnInfo; }
   const PathInfoMap &GetObserverPathInfo() const { return m_observerPathInfo; }
   const FailedLinkMap &GetFailedLinks() const { return m_failedLinks; }
@@ -130,36 +214,44 @@ public:
   HostVantagePointPointer GetClientVP(uint32_t id) const;
   ObsvVantagePointPointer GetObserverVP(uint32_t id) const;
 
-  std::set<uint32_t> GetServerVPIds(bool relevantOnly) const;
-  std::set<uint32_t> GetClientVPIds(bool relevantOnly) const;
+  // The id sets are created once (by Freeze at the latest) and returned by reference, they stay
+  // valid until vantage points or events are added to the result set
+
+  const std::set<uint32_t> &GetServerVPIds(bool relevantOnly) const;
+  const std::set<uint32_t> &GetClientVPIds(bool relevantOnly) const;
   /// @brief Get all observer VP ids with certain filters
   /// @param relevantOnly Only include observers that recorded any events
   /// @param realOnly Only include observers at core nodes, not the ones at endhost nodes
-  std::set<uint32_t> GetObserverVPIds(bool relevantOnly, bool realOnly) const;
-
-  std::set<uint32_t> GetClientConnIds() const;
-  std::set<uint32_t> GetClientConnIds(uint32_t clientId) const;
-  std::set<uint32_t> GetServerConnIds() const;
-  std::set<uint32_t> GetServerConnIds(uint32_t serverId) const;
-  std::set<uint32_t> GetObserverFlowIds(bool realOnly) const;
-  std::set<uint32_t> GetObserverFlowIds(uint32_t observerId) const;
-  std::set<uint32_t> GetObserverFlowIds(uint32_t observerId, std::map<uint32_t, std::set<uint32_t>> flowSelectionMap) const;
-
+  const std::set<uint32_t> &GetObserverVPIds(bool relevantOnly, bool realOnly) const;
+
+  const std::set<uint32_t> &GetClientConnIds() const;
+  const std::set<uint32_t> &GetClientConnIds(uint32_t clientId) const;
+  const std::set<uint32_t> &GetServerConnIds() const;
+  const std::set<uint32_t> &GetServerConnIds(uint32_t serverId) const;
+  const std::set<uint32_t> &GetObserverFlowIds(bool realOnly) const;
+  const std::set<uint32_t> &GetObserverFlowIds(uint32_t observerId) const;
+  std::set<uint32_t> GetObserverFlowIds(
+      uint32_t observerId, const std::map<uint32_t, std::set<uint32_t>> &flowSelectionMap) const;
+
+  /// @brief The path of a flow, taken from a table that is computed for all flows on first use
+  /// @return The path, empty for unknown flows
+  const FlowPath &GetFlowPath(uint32_t flowId) const;
+  /// @return The observer vantage points on the path of a flow (see GetFlowPath)
   std::vector<ObsvVantagePointPointer> CalculateFlowPath(uint32_t flowId) const;
   uint32_t GetReverseFlowId(uint32_t flowId) const;
   uint32_t GetObserverFlowStart(uint32_t flowId) const;
   uint32_t GetObserverFlowEnd(uint32_t flowId) const;
 
-  std::vector<uint32_t> GetPingPath(uint32_t srcNodeId, uint32_t destNodeId) const;
+  const std::vector<uint32_t> &GetPingPath(uint32_t srcNodeId, uint32_t destNodeId) const;
 
-  void PrintEventCounts();
+  void PrintEventCounts() const;
 
 
 protected:
   std::map<SimEventType, uint32_t> m_eventCount;  // Stores the number of events of each type
 
-  typedef std::map<uint32_t, HostVantagePointPointer> HostVantagePointMap;
-  typedef std::map<uint32_t, ObsvVantagePointPointer> ObsvVantagePointMap;
+  typedef SimIdMap<uint32_t, HostVantagePointPointer> HostVantagePointMap;
+  typedef SimIdMap<uint32_t, ObsvVantagePointPointer> ObsvVantagePointMap;
   HostVantagePointMap m_vpClients;    // Stores all vantage points with type client
   HostVantagePointMap m_vpServers;    // Stores all vantage points with type server
   ObsvVantagePointMap m_vpObservers;  // Stores all vantage points with type network
@@ -177,6 +269,9 @@ protected:
 
   // Stores the five tuple associated with each observer flow id
   FlowInfoMap m_observerFlowInfo;
+  // Observer flow ids by five tuple (the lowest id if several flows have the same five tuple)
+  std::unordered_map<FiveTuple, uint32_t, FiveTupleHash> m_observerFlowIndex;
+  FlowPairMap m_reverseFlowIds;
   // Stores the five tuple associated with each host connection id
   FlowInfoMap m_hostConnInfo;
   // Stores the links configured to fail
@@ -187,7 +282,7 @@ protected:
   PathInfoMap m_observerPathInfo;
 
   // Stores the flow stats per observer id and flow id
-  std::map<std::pair<uint32_t, uint32_t>, FlowStats> m_observerFlowStats;
+  SimIdMap<std::pair<uint32_t, uint32_t>, FlowStats> m_observerFlowStats;
 
   std::map<std::pair<uint32_t, uint32_t>, std::vector<uint32_t>> m_pingPaths;
 
@@ -198,8 +293,56 @@ protected:
 
   std::optional<SimFilter> m_filter;
 
+  // Filtered views created by ApplyFilter(s), dropped whenever vantage points or events are added.
+  // Guarded by m_viewMutex, views are not shared with the copies made for filtering.
+  mutable std::map<SimFilter, SimResultSetPointer> m_filteredViews;
+  std::shared_ptr<std::mutex> m_viewMutex = std::make_shared<std::mutex>();
+
+  // Paths of all flows, created by BuildFlowPaths on first use and dropped together with the
+  // filtered views. Filters do not change flow begin events, so filtered views share the table.
+  typedef std::unordered_map<uint32_t, FlowPath> FlowPathMap;
+  mutable std::shared_ptr<const FlowPathMap> m_flowPaths;
+
+  // Id sets derived from the vantage points, created on first use by the Get*Ids methods and
+  // dropped together with the filtered views. Filtered views have their own, since filters can
+  // remove all events of a vantage point.
+  struct IdSets
+  {
+    std::optional<std::set<uint32_t>> relevantClientIds;
+    std::optional<std::set<uint32_t>> relevantServerIds;
+    std::map<std::pair<bool, bool>, std::set<uint32_t>> observerIds;  // (relevantOnly, realOnly)
+    std::map<bool, std::set<uint32_t>> observerFlowIds;              // realOnly
+    std::optional<std::set<uint32_t>> clientConnIds;
+    std::optional<std::set<uint32_t>> serverConnIds;
+  };
+  mutable IdSets m_idSets;
+
+  // Set by Freeze, no vantage points or events can be added afterwards
+  bool m_frozen = false;
+
+  // The event types to import, all if not set
+  std::optional<SimEventTypeSet> m_eventTypes;
+
+  // Set if vantage points are imported on demand
+  SimTraceIndexPointer m_traceIndex;
+  // Stores the vantage points imported so far if m_traceIndex is set
+  std::set<std::pair<VantagePointType, uint32_t>> m_loadedVantagePoints;
+
+  // Imported vantage points, flows, paths, and ping pairs are allocated from this arena, so that
+  // importing does not allocate each of them separately and dropping the result set releases the
+  // memory in a few large blocks. Filtered result sets do not have an arena.
+  SimArenaPointer m_arena = std::make_shared<SimArena>();
+
 
   void ImportSummary(simdjson::ondemand::object &summary);
+  // Builds m_observerFlowIndex and m_reverseFlowIds from m_observerFlowInfo
+  void IndexObserverFlows();
+  void BuildFlowPaths() const;
+  // Drops data derived from the vantage points, called before vantage points or events are added.
+  // Throws for frozen result sets.
+  void InvalidateDerivedData();
+  // Creates all id sets of IdSets
+  void BuildIdSets() const;
   void ImportTrace(simdjson::ondemand::object &trace);
 
 
@@ -207,6 +350,8 @@ protected:
 
 private:
   SimResultSet();
+
+  friend class SimSnapshot;
 };
 
 }  // namespace simdata
@@ -0,0 +1,715 @@
+#include "sim-snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace simdata {
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'E', 'F', 'M', 'S', 'N', 'A', 'P', '\0'};
+
+class SnapshotWriter
+{
+public:
+  SnapshotWriter(std::ostream &out) : m_out(out) {}
+
+  template <typename T>
+  void Put(const T &value)
+  {
+    static_assert(std::is_arithmetic<T>::value, "Only arithmetic values can be written directly");
+    m_out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void PutString(const std::string &value)
+  {
+    Put<uint64_t>(value.size());
+    m_out.write(value.data(), value.size());
+  }
+
+  template <typename T>
+  void PutOptional(const std::optional<T> &value)
+  {
+    Put<uint8_t>(value.has_value());
+    if (value.has_value())
+      Put<T>(*value);
+  }
+
+  template <typename T>
+  void PutVector(const std::vector<T> &values)
+  {
+    Put<uint64_t>(values.size());
+    for (const T &value : values) Put<T>(value);
+  }
+
+  void PutIdSet(const std::set<uint32_t> &ids)
+  {
+    Put<uint64_t>(ids.size());
+    for (uint32_t id : ids) Put<uint32_t>(id);
+  }
+
+  void PutFiveTuple(const FiveTuple &ft)
+  {
+    Put<uint32_t>(ft.sourceNodeId);
+    Put<uint32_t>(ft.destNodeId);
+    Put<uint16_t>(ft.sourcePort);
+    Put<uint16_t>(ft.destPort);
+    Put<uint8_t>(ft.protocol);
+  }
+
+  void PutEvent(const SimEvent &ev);
+
+private:
+  std::ostream &m_out;
+};
+
+class SnapshotReader
+{
+public:
+  SnapshotReader(std::vector<char> data) : m_data(std::move(data)) {}
+
+  template <typename T>
+  T Get()
+  {
+    static_assert(std::is_arithmetic<T>::value, "Only arithmetic values can be read directly");
+    T value;
+    std::memcpy(&value, Consume(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  std::string GetString()
+  {
+    uint64_t size = Get<uint64_t>();
+    return std::string(Consume(size), size);
+  }
+
+  template <typename T>
+  std::optional<T> GetOptional()
+  {
+    if (Get<uint8_t>())
+      return Get<T>();
+    return std::nullopt;
+  }
+
+  template <typename T>
+  std::vector<T> GetVector()
+  {
+    uint64_t size = Get<uint64_t>();
+    std::vector<T> values;
+    values.reserve(size);
+    for (uint64_t i = 0; i < size; i++) values.push_back(Get<T>());
+    return values;
+  }
+
+  std::set<uint32_t> GetIdSet()
+  {
+    uint64_t size = Get<uint64_t>();
+    std::set<uint32_t> ids;
+    for (uint64_t i = 0; i < size; i++) ids.insert(ids.end(), Get<uint32_t>());
+    return ids;
+  }
+
+  FiveTuple GetFiveTuple()
+  {
+    FiveTuple ft;
+    ft.sourceNodeId = Get<uint32_t>();
+    ft.destNodeId = Get<uint32_t>();
+    ft.sourcePort = Get<uint16_t>();
+    ft.destPort = Get<uint16_t>();
+    ft.protocol = Get<uint8_t>();
+    return ft;
+  }
+
+  EventPointer GetEvent();
+
+  bool AtEnd() const { return m_pos == m_data.size(); }
+
+private:
+  const char *Consume(uint64_t size)
+  {
+    if (size > m_data.size() - m_pos)
+      throw std::runtime_error("Snapshot file is truncated.");
+    const char *begin = m_data.data() + m_pos;
+    m_pos += size;
+    return begin;
+  }
+
+  std::vector<char> m_data;
+  size_t m_pos = 0;
+};
+
+// The event classes per type have to match CreateEvent
+void SnapshotWriter::PutEvent(const SimEvent &ev)
+{
+  Put<uint32_t>(static_cast<uint32_t>(ev.eventType));
+  Put<double>(ev.time);
+  Put<uint32_t>(ev.flowId);
+
+  switch (ev.eventType)
+  {
+    case SimEventType::HOST_SPIN_BIT_UDPATE:
+    case SimEventType::HOST_Q_BIT_UPDATE:
+    case SimEventType::HOST_R_BIT_UPDATE:
+    case SimEventType::OBSV_SPIN_BIT_EDGE:
+    case SimEventType::OBSV_Q_BIT_CHANGE:
+    case SimEventType::OBSV_R_BIT_CHANGE:
+    {
+      auto &bitEv = static_cast<const EfmBitUpdateEvent &>(ev);
+      Put<uint8_t>(bitEv.new_state);
+      Put<uint32_t>(bitEv.seq);
+      break;
+    }
+    case SimEventType::HOST_L_BIT_SET:
+    case SimEventType::HOST_T_BIT_SET:
+    case SimEventType::OBSV_T_BIT_SET:
+      Put<uint32_t>(static_cast<const EfmBitSetEvent &>(ev).seq);
+      break;
+    case SimEventType::OBSV_L_BIT_SET:
+    case SimEventType::OBSV_P_L_BIT_SET:
+    {
+      auto &setEv = static_cast<const EfmBitSetPCountEvent &>(ev);
+      Put<uint32_t>(setEv.pkt_count);
+      Put<uint32_t>(setEv.seq);
+      break;
+    }
+    case SimEventType::HOST_L_BIT_COUNTER_UPDATE:
+    {
+      auto &counterEv = static_cast<const EfmLBitCounterUpdateEvent &>(ev);
+      Put<uint32_t>(counterEv.old_value);
+      Put<uint32_t>(counterEv.new_value);
+      break;
+    }
+    case SimEventType::HOST_R_BIT_BLOCK_UPDATE:
+      Put<uint32_t>(static_cast<const EfmRBitBlockLenUpdateEvent &>(ev).new_length);
+      break;
+    case SimEventType::HOST_T_BIT_PHASE_UPDATE:
+    {
+      auto &phaseEv = static_cast<const EfmTBitHostPhaseUpdateEvent &>(ev);
+      Put<int32_t>(static_cast<int32_t>(phaseEv.old_phase));
+      Put<int32_t>(static_cast<int32_t>(phaseEv.new_phase));
+      break;
+    }
+    case SimEventType::OBSV_SPIN_BIT_DELAY:
+    case SimEventType::HOST_GT_TRANS_DELAY:
+    case SimEventType::HOST_GT_APP_DELAY:
+    case SimEventType::OBSV_TCP_DART_DELAY:
+    case SimEventType::PING_ETE_DELAY:
+    case SimEventType::PING_RT_DELAY:
+    {
+      auto &delayEv = static_cast<const EfmDelayMeasurementEvent &>(ev);
+      Put<uint32_t>(delayEv.full_delay_ms);
+      PutOptional<uint32_t>(delayEv.half_delay_ms);
+      break;
+    }
+    case SimEventType::OBSV_Q_BIT_LOSS:
+    case SimEventType::OBSV_R_BIT_LOSS:
+    case SimEventType::OBSV_SEQ_LOSS:
+    case SimEventType::OBSV_ACK_SEQ_LOSS:
+    case SimEventType::OBSV_T_BIT_FULL_LOSS:
+    case SimEventType::OBSV_T_BIT_HALF_LOSS:
+    case SimEventType::OBSV_TCP_REORDERING:
+    case SimEventType::PING_RT_LOSS:
+    case SimEventType::PING_ETE_LOSS:
+    {
+      auto &lossEv = static_cast<const EfmLossMeasurementEvent &>(ev);
+      Put<uint32_t>(lossEv.pkt_count);
+      Put<uint32_t>(lossEv.loss);
+      break;
+    }
+    case SimEventType::OBSV_T_BIT_PHASE_UPDATE:
+    {
+      auto &phaseEv = static_cast<const EfmTBitObserverPhaseUpdateEvent &>(ev);
+      Put<int32_t>(static_cast<int32_t>(phaseEv.old_phase));
+      Put<int32_t>(static_cast<int32_t>(phaseEv.new_phase));
+      PutOptional<uint32_t>(phaseEv.gen_train_length);
+      PutOptional<uint32_t>(phaseEv.ref_train_length);
+      break;
+    }
+    case SimEventType::OBSV_P_SQ_BITS_LOSS:
+    {
+      auto &lossEv = static_cast<const EfmSignedLossMeasurementEvent &>(ev);
+      Put<uint32_t>(lossEv.pkt_count);
+      Put<int32_t>(lossEv.loss);
+      break;
+    }
+    case SimEventType::OBSV_FLOW_BEGIN:
+    case SimEventType::UNKNOWN:
+    default:
+      break;
+  }
+}
+
+EventPointer SnapshotReader::GetEvent()
+{
+  SimEventType evType = static_cast<SimEventType>(Get<uint32_t>());
+  double evTime = Get<double>();
+  uint32_t evFlowId = Get<uint32_t>();
+
+  switch (evType)
+  {
+    case SimEventType::HOST_SPIN_BIT_UDPATE:
+    case SimEventType::HOST_Q_BIT_UPDATE:
+    case SimEventType::HOST_R_BIT_UPDATE:
+    case SimEventType::OBSV_SPIN_BIT_EDGE:
+    case SimEventType::OBSV_Q_BIT_CHANGE:
+    case SimEventType::OBSV_R_BIT_CHANGE:
+    {
+      bool newState = Get<uint8_t>();
+      uint32_t seq = Get<uint32_t>();
+      return std::make_shared<EfmBitUpdateEvent>(evType, evTime, evFlowId, newState, seq);
+    }
+    case SimEventType::HOST_L_BIT_SET:
+    case SimEventType::HOST_T_BIT_SET:
+    case SimEventType::OBSV_T_BIT_SET:
+      return std::make_shared<EfmBitSetEvent>(evType, evTime, evFlowId, Get<uint32_t>());
+    case SimEventType::OBSV_L_BIT_SET:
+    case SimEventType::OBSV_P_L_BIT_SET:
+    {
+      uint32_t pktCount = Get<uint32_t>();
+      uint32_t seq = Get<uint32_t>();
+      return std::make_shared<EfmBitSetPCountEvent>(evType, evTime, evFlowId, pktCount, seq);
+    }
+    case SimEventType::HOST_L_BIT_COUNTER_UPDATE:
+    {
+      uint32_t oldValue = Get<uint32_t>();
+      uint32_t newValue = Get<uint32_t>();
+      return std::make_shared<EfmLBitCounterUpdateEvent>(evType, evTime, evFlowId, oldValue,
+                                                         newValue);
+    }
+    case SimEventType::HOST_R_BIT_BLOCK_UPDATE:
+      return std::make_shared<EfmRBitBlockLenUpdateEvent>(evType, evTime, evFlowId,
+                                                          Get<uint32_t>());
+    case SimEventType::HOST_T_BIT_PHASE_UPDATE:
+    {
+      auto oldPhase = static_cast<TBitClientPhase>(Get<int32_t>());
+      auto newPhase = static_cast<TBitClientPhase>(Get<int32_t>());
+      return std::make_shared<EfmTBitHostPhaseUpdateEvent>(evType, evTime, evFlowId, oldPhase,
+                                                           newPhase);
+    }
+    case SimEventType::OBSV_SPIN_BIT_DELAY:
+    case SimEventType::HOST_GT_TRANS_DELAY:
+    case SimEventType::HOST_GT_APP_DELAY:
+    case SimEventType::OBSV_TCP_DART_DELAY:
+    case SimEventType::PING_ETE_DELAY:
+    case SimEventType::PING_RT_DELAY:
+    {
+      uint32_t fullDelay = Get<uint32_t>();
+      auto evPtr = std::make_shared<EfmDelayMeasurementEvent>(evType, evTime, evFlowId, fullDelay);
+      evPtr->half_delay_ms = GetOptional<uint32_t>();
+      return evPtr;
+    }
+    case SimEventType::OBSV_Q_BIT_LOSS:
+    case SimEventType::OBSV_R_BIT_LOSS:
+    case SimEventType::OBSV_SEQ_LOSS:
+    case SimEventType::OBSV_ACK_SEQ_LOSS:
+    case SimEventType::OBSV_T_BIT_FULL_LOSS:
+    case SimEventType::OBSV_T_BIT_HALF_LOSS:
+    case SimEventType::OBSV_TCP_REORDERING:
+    case SimEventType::PING_RT_LOSS:
+    case SimEventType::PING_ETE_LOSS:
+    {
+      uint32_t pktCount = Get<uint32_t>();
+      uint32_t loss = Get<uint32_t>();
+      return std::make_shared<EfmLossMeasurementEvent>(evType, evTime, evFlowId, pktCount, loss);
+    }
+    case SimEventType::OBSV_T_BIT_PHASE_UPDATE:
+    {
+      auto oldPhase = static_cast<TBitObserverPhase>(Get<int32_t>());
+      auto newPhase = static_cast<TBitObserverPhase>(Get<int32_t>());
+      auto evPtr = std::make_shared<EfmTBitObserverPhaseUpdateEvent>(evType, evTime, evFlowId,
+                                                                     oldPhase, newPhase);
+      evPtr->gen_train_length = GetOptional<uint32_t>();
+      evPtr->ref_train_length = GetOptional<uint32_t>();
+      return evPtr;
+    }
+    case SimEventType::OBSV_P_SQ_BITS_LOSS:
+    {
+      uint32_t pktCount = Get<uint32_t>();
+      int32_t loss = Get<int32_t>();
+      return std::make_shared<EfmSignedLossMeasurementEvent>(evType, evTime, evFlowId, pktCount,
+                                                             loss);
+    }
+    case SimEventType::OBSV_FLOW_BEGIN:
+    case SimEventType::UNKNOWN:
+    default:
+      return std::make_shared<SimEvent>(evType, evTime, evFlowId);
+  }
+}
+
+// Event maps of the flows/paths/ping pairs of a vantage point with their flow ids
+typedef std::vector<std::pair<uint32_t, const SimEventMap *>> FlowEventMaps;
+
+void PutEventMaps(SnapshotWriter &writer, const FlowEventMaps &eventMaps)
+{
+  uint64_t count = 0;
+  for (const auto &[flowId, eventMap] : eventMaps)
+  {
+    for (auto it = eventMap->begin(); it != eventMap->end(); it++) count += it->second->Size();
+  }
+
+  // Events are stored per flow/path/ping pair in their current order. Adding them to a vantage
+  // point in this order restores the same containers and the order of events with equal time.
+  writer.Put<uint64_t>(count);
+  for (const auto &[flowId, eventMap] : eventMaps)
+  {
+    for (auto it = eventMap->begin(); it != eventMap->end(); it++)
+    {
+      for (size_t i = 0; i < it->second->Size(); i++)
+        writer.PutEvent(*it->second->GetEvent(it->first, flowId, i));
+    }
+  }
+}
+
+void GetEvents(SnapshotReader &reader, SimVantagePoint &vp)
+{
+  uint64_t count = reader.Get<uint64_t>();
+  for (uint64_t i = 0; i < count; i++) vp.AddEvent(reader.GetEvent());
+  vp.SortEvents();
+}
+
+}  // namespace
+
+
+std::string SimSnapshot::CreateKey(const std::vector<std::string> &files,
+                                   const std::optional<SimEventTypeSet> &eventTypes)
+{
+  std::vector<std::string> sortedFiles(files);
+  std::sort(sortedFiles.begin(), sortedFiles.end());
+
+  std::string key = "v" + std::to_string(FORMAT_VERSION) + "\n";
+  if (eventTypes.has_value())
+  {
+    key += "events";
+    for (SimEventType evType : *eventTypes) key += " " + EventTypeToString(evType);
+    key += "\n";
+  }
+  for (const std::string &file : sortedFiles)
+  {
+    std::filesystem::path path(file);
+    key += path.filename().string() + "\t" + std::to_string(std::filesystem::file_size(path)) +
+           "\t" +
+           std::to_string(std::filesystem::last_write_time(path).time_since_epoch().count()) +
+           "\n";
+  }
+  return key;
+}
+
+void SimSnapshot::Write(const SimResultSet &srs, const std::string &file, const std::string &key)
+{
+  if (srs.m_filter.has_value())
+    throw std::invalid_argument("Snapshots can only be created for unfiltered result sets.");
+  if (srs.m_traceIndex)
+    throw std::invalid_argument("Snapshots cannot be created for partially loaded result sets.");
+
+  std::string tmpFile = file + ".tmp";
+  std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+  if (!out.is_open())
+    throw std::runtime_error("Could not open snapshot file " + tmpFile + " for writing.");
+
+  SnapshotWriter writer(out);
+  out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  writer.Put<uint32_t>(FORMAT_VERSION);
+  writer.PutString(key);
+
+  writer.PutString(srs.m_simId);
+  writer.PutString(srs.m_simConfigJson);
+  writer.PutIdSet(srs.m_clientIds);
+  writer.PutIdSet(srs.m_serverIds);
+  writer.PutIdSet(srs.m_observerIds);
+
+  for (const SimResultSet::FlowInfoMap *flowInfo : {&srs.m_observerFlowInfo, &srs.m_hostConnInfo})
+  {
+    writer.Put<uint64_t>(flowInfo->size());
+    for (auto it = flowInfo->begin(); it != flowInfo->end(); it++)
+    {
+      writer.Put<uint32_t>(it->first);
+      writer.PutFiveTuple(it->second);
+    }
+  }
+
+  writer.Put<uint64_t>(srs.m_failedLinks.size());
+  for (auto it = srs.m_failedLinks.begin(); it != srs.m_failedLinks.end(); it++)
+  {
+    writer.Put<uint32_t>(it->second.sourceNodeId);
+    writer.Put<uint32_t>(it->second.destNodeId);
+    writer.Put<double>(it->second.lossRate);
+    writer.Put<uint32_t>(it->second.delayMs);
+  }
+
+  writer.Put<uint64_t>(srs.m_backboneOverrides.size());
+  for (auto it = srs.m_backboneOverrides.begin(); it != srs.m_backboneOverrides.end(); it++)
+  {
+    writer.Put<uint32_t>(it->second.sourceNodeId);
+    writer.Put<uint32_t>(it->second.destNodeId);
+    writer.Put<uint32_t>(it->second.delayMus);
+  }
+
+  writer.Put<uint64_t>(srs.m_observerPathInfo.size());
+  for (auto it = srs.m_observerPathInfo.begin(); it != srs.m_observerPathInfo.end(); it++)
+  {
+    writer.Put<uint32_t>(it->first);
+    writer.PutString(it->second.sourceNet);
+    writer.PutString(it->second.destNet);
+    writer.PutVector<uint32_t>(it->second.sourceNodeIds);
+    writer.PutVector<uint32_t>(it->second.destNodeIds);
+  }
+
+  writer.Put<uint64_t>(srs.m_observerFlowStats.size());
+  for (auto it = srs.m_observerFlowStats.begin(); it != srs.m_observerFlowStats.end(); it++)
+  {
+    writer.Put<uint32_t>(it->first.first);
+    writer.Put<uint32_t>(it->first.second);
+    writer.Put<uint32_t>(it->second.totalPackets);
+    writer.Put<uint32_t>(it->second.totalEfmPackets);
+  }
+
+  writer.Put<uint64_t>(srs.m_pingPaths.size());
+  for (auto it = srs.m_pingPaths.begin(); it != srs.m_pingPaths.end(); it++)
+  {
+    writer.Put<uint32_t>(it->first.first);
+    writer.Put<uint32_t>(it->first.second);
+    writer.PutVector<uint32_t>(it->second);
+  }
+
+  for (const SimResultSet::LinkVector *links : {&srs.m_edgeLinks, &srs.m_coreLinks})
+  {
+    writer.Put<uint64_t>(links->size());
+    for (const SimResultSet::Link &link : *links)
+    {
+      writer.Put<uint32_t>(link.first);
+      writer.Put<uint32_t>(link.second);
+    }
+  }
+
+  writer.Put<uint64_t>(srs.m_linkGroundtruthStats.size());
+  for (auto it = srs.m_linkGroundtruthStats.begin(); it != srs.m_linkGroundtruthStats.end(); it++)
+  {
+    writer.Put<uint32_t>(it->first.first);
+    writer.Put<uint32_t>(it->first.second);
+    writer.Put<uint32_t>(it->second.lostPackets);
+    writer.Put<uint32_t>(it->second.receivedPackets);
+    writer.PutOptional<double>(it->second.delayAvgMus);
+    writer.PutOptional<double>(it->second.delayStdMus);
+    writer.PutOptional<double>(it->second.delayMedMus);
+    writer.PutOptional<double>(it->second.delay99thMus);
+    writer.PutOptional<uint32_t>(it->second.delayMinMus);
+    writer.PutOptional<uint32_t>(it->second.delayMaxMus);
+  }
+
+  writer.Put<uint64_t>(srs.m_eventCount.size());
+  for (auto it = srs.m_eventCount.begin(); it != srs.m_eventCount.end(); it++)
+  {
+    writer.Put<uint32_t>(static_cast<uint32_t>(it->first));
+    writer.Put<uint32_t>(it->second);
+  }
+
+  for (const SimResultSet::HostVantagePointMap *vps : {&srs.m_vpClients, &srs.m_vpServers})
+  {
+    writer.Put<uint64_t>(vps->size());
+    for (auto it = vps->begin(); it != vps->end(); it++)
+    {
+      writer.Put<uint32_t>(it->first);
+      FlowEventMaps eventMaps;
+      for (auto &flow : it->second->m_simFlows)
+        eventMaps.emplace_back(flow.first, &flow.second->m_simEvents);
+      PutEventMaps(writer, eventMaps);
+    }
+  }
+
+  writer.Put<uint64_t>(srs.m_vpObservers.size());
+  for (auto it = srs.m_vpObservers.begin(); it != srs.m_vpObservers.end(); it++)
+  {
+    writer.Put<uint32_t>(it->first);
+    const SimObsvVantagePoint &vp = *it->second;
+    FlowEventMaps eventMaps;
+    for (auto &flow : vp.m_simFlows) eventMaps.emplace_back(flow.first, &flow.second->m_simEvents);
+    for (auto &path : vp.m_simPaths) eventMaps.emplace_back(path.first, &path.second->m_simEvents);
+    for (auto &pp : vp.m_simPingClientPairs)
+      eventMaps.emplace_back(pp.first, &pp.second->m_simEvents);
+    for (auto &pp : vp.m_simPingServerPairs)
+      eventMaps.emplace_back(pp.first, &pp.second->m_simEvents);
+    PutEventMaps(writer, eventMaps);
+  }
+
+  out.close();
+  if (!out)
+    throw std::runtime_error("Failed to write snapshot file " + tmpFile + ".");
+
+  // Readers never see a partially written snapshot
+  std::filesystem::rename(tmpFile, file);
+}
+
+SimResultSetPointer SimSnapshot::Read(const std::string &file, const std::string &key)
+{
+  std::ifstream in(file, std::ios::binary | std::ios::ate);
+  if (!in.is_open())
+    return nullptr;
+
+  std::vector<char> data(in.tellg());
+  in.seekg(0);
+  in.read(data.data(), data.size());
+  if (!in)
+  {
+    std::cout << "Warning: Could not read snapshot file " << file << "." << std::endl;
+    return nullptr;
+  }
+  in.close();
+
+  if (data.size() < sizeof(SNAPSHOT_MAGIC) ||
+      std::memcmp(data.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+  {
+    std::cout << "Warning: File " << file << " is not a snapshot." << std::endl;
+    return nullptr;
+  }
+  data.erase(data.begin(), data.begin() + sizeof(SNAPSHOT_MAGIC));
+
+  SnapshotReader reader(std::move(data));
+  try
+  {
+    if (reader.Get<uint32_t>() != FORMAT_VERSION || reader.GetString() != key)
+      return nullptr;
+
+    // Constructor is private, so make_shared cannot be used here
+    SimResultSetPointer srs(new SimResultSet());
+    srs->m_simId = reader.GetString();
+    srs->m_simConfigJson = reader.GetString();
+    srs->m_clientIds = reader.GetIdSet();
+    srs->m_serverIds = reader.GetIdSet();
+    srs->m_observerIds = reader.GetIdSet();
+
+    for (SimResultSet::FlowInfoMap *flowInfo : {&srs->m_observerFlowInfo, &srs->m_hostConnInfo})
+    {
+      uint64_t size = reader.Get<uint64_t>();
+      for (uint64_t i = 0; i < size; i++)
+      {
+        uint32_t flowId = reader.Get<uint32_t>();
+        (*flowInfo)[flowId] = reader.GetFiveTuple();
+      }
+    }
+    srs->IndexObserverFlows();
+
+    uint64_t size = reader.Get<uint64_t>();
+    for (uint64_t i = 0; i < size; i++)
+    {
+      FailedLink fl;
+      fl.sourceNodeId = reader.Get<uint32_t>();
+      fl.destNodeId = reader.Get<uint32_t>();
+      fl.lossRate = reader.Get<double>();
+      fl.delayMs = reader.Get<uint32_t>();
+      srs->m_failedLinks[std::make_pair(fl.sourceNodeId, fl.destNodeId)] = fl;
+    }
+
+    size = reader.Get<uint64_t>();
+    for (uint64_t i = 0; i < size; i++)
+    {
+      LinkConfig lc;
+      lc.sourceNodeId = reader.Get<uint32_t>();
+      lc.destNodeId = reader.Get<uint32_t>();
+      lc.delayMus = reader.Get<uint32_t>();
+      srs->m_backboneOverrides[std::make_pair(lc.sourceNodeId, lc.destNodeId)] = lc;
+    }
+
+    size = reader.Get<uint64_t>();
+    for (uint64_t i = 0; i < size; i++)
+    {
+      uint32_t pathId = reader.Get<uint32_t>();
+      PathInfo &pinf = srs->m_observerPathInfo[pathId];
+      pinf.sourceNet = reader.GetString();
+      pinf.destNet = reader.GetString();
+      pinf.sourceNodeIds = reader.GetVector<uint32_t>();
+      pinf.destNodeIds = reader.GetVector<uint32_t>();
+    }
+
+    size = reader.Get<uint64_t>();
+    for (uint64_t i = 0; i < size; i++)
+    {
+      uint32_t observerId = reader.Get<uint32_t>();
+      uint32_t flowId = reader.Get<uint32_t>();
+      FlowStats &fs = srs->m_observerFlowStats[std::make_pair(observerId, flowId)];
+      fs.totalPackets = reader.Get<uint32_t>();
+      fs.totalEfmPackets = reader.Get<uint32_t>();
+    }
+
+    size = reader.Get<uint64_t>();
+    for (uint64_t i = 0; i < size; i++)
+    {
+      uint32_t srcNodeId = reader.Get<uint32_t>();
+      uint32_t dstNodeId = reader.Get<uint32_t>();
+      srs->m_pingPaths[std::make_pair(srcNodeId, dstNodeId)] = reader.GetVector<uint32_t>();
+    }
+
+    for (SimResultSet::LinkVector *links : {&srs->m_edgeLinks, &srs->m_coreLinks})
+    {
+      size = reader.Get<uint64_t>();
+      for (uint64_t i = 0; i < size; i++)
+      {
+        uint32_t src = reader.Get<uint32_t>();
+        uint32_t dst = reader.Get<uint32_t>();
+        links->push_back(std::make_pair(src, dst));
+      }
+    }
+
+    size = reader.Get<uint64_t>();
+    for (uint64_t i = 0; i < size; i++)
+    {
+      uint32_t src = reader.Get<uint32_t>();
+      uint32_t dst = reader.Get<uint32_t>();
+      LinkStats &linkStats = srs->m_linkGroundtruthStats[std::make_pair(src, dst)];
+      linkStats.lostPackets = reader.Get<uint32_t>();
+      linkStats.receivedPackets = reader.Get<uint32_t>();
+      linkStats.delayAvgMus = reader.GetOptional<double>();
+      linkStats.delayStdMus = reader.GetOptional<double>();
+      linkStats.delayMedMus = reader.GetOptional<double>();
+      linkStats.delay99thMus = reader.GetOptional<double>();
+      linkStats.delayMinMus = reader.GetOptional<uint32_t>();
+      linkStats.delayMaxMus = reader.GetOptional<uint32_t>();
+    }
+
+    size = reader.Get<uint64_t>();
+    for (uint64_t i = 0; i < size; i++)
+    {
+      auto evType = static_cast<SimEventType>(reader.Get<uint32_t>());
+      srs->m_eventCount[evType] = reader.Get<uint32_t>();
+    }
+
+    for (auto vpType : {VantagePointType::CLIENT, VantagePointType::SERVER})
+    {
+      auto &vps = vpType == VantagePointType::CLIENT ? srs->m_vpClients : srs->m_vpServers;
+      size = reader.Get<uint64_t>();
+      for (uint64_t i = 0; i < size; i++)
+      {
+        uint32_t nodeId = reader.Get<uint32_t>();
+        auto vp = MakeArenaShared<SimHostVantagePoint>(srs->m_arena, vpType, nodeId, srs->m_arena);
+        GetEvents(reader, *vp);
+        vps.insert(vps.end(), std::make_pair(nodeId, vp));
+      }
+    }
+
+    size = reader.Get<uint64_t>();
+    for (uint64_t i = 0; i < size; i++)
+    {
+      uint32_t nodeId = reader.Get<uint32_t>();
+      auto vp = MakeArenaShared<SimObsvVantagePoint>(srs->m_arena, VantagePointType::NETWORK,
+                                                     nodeId, srs->m_arena);
+      GetEvents(reader, *vp);
+      srs->m_vpObservers.insert(srs->m_vpObservers.end(), std::make_pair(nodeId, vp));
+    }
+
+    if (!reader.AtEnd())
+      throw std::runtime_error("Snapshot file has unexpected trailing data.");
+
+    return srs;
+  }
+  catch (const std::exception &e)
+  {
+    std::cout << "Warning: Ignoring snapshot file " << file << ": " << e.what() << std::endl;
+    return nullptr;
+  }
+}
+
+}  // namespace simdata
@@ -0,0 +1,47 @@
+#ifndef SIM_SNAPSHOT_H
+#define SIM_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+
+#include "sim-result-set.h"
+
+namespace simdata {
+
+// Stores imported result sets in a compact binary file, so that repeated analyses of the same
+// simulation run can skip parsing the QLOG files.
+//
+// Layout (native byte order, no padding): magic, format version, cache key, sim id, summary data,
+// event counts, and all vantage points with their events. The file does not contain pointers, so
+// it is read in one piece and decoded sequentially.
+class SimSnapshot
+{
+public:
+  /// @brief Increase whenever the layout or the stored data changes
+  static constexpr uint32_t FORMAT_VERSION = 1;
+
+  /// @brief Creates the key that decides whether a snapshot is still valid for a set of QLOG files
+  /// @param files The QLOG files of one simulation run
+  /// @param eventTypes The event types that are imported, all if not set
+  /// @return A key containing the format version, the event types, as well as name, size, and
+  /// modification time of all files
+  static std::string CreateKey(const std::vector<std::string> &files,
+                               const std::optional<SimEventTypeSet> &eventTypes = std::nullopt);
+
+  /// @brief Writes a result set to a snapshot file (via a temporary file that is renamed)
+  /// @param srs The unfiltered result set
+  /// @param file The snapshot file
+  /// @param key The key created by CreateKey for the files the result set was imported from
+  static void Write(const SimResultSet &srs, const std::string &file, const std::string &key);
+
+  /// @brief Reads a result set from a snapshot file
+  /// @param file The snapshot file
+  /// @param key The key created by CreateKey for the current QLOG files
+  /// @return The result set or nullptr if the file does not exist, was written by another format
+  /// version, or was created for different QLOG files
+  static SimResultSetPointer Read(const std::string &file, const std::string &key);
+};
+
+}  // namespace simdata
+
+#endif  // SIM_SNAPSHOT_H
@@ -0,0 +1,207 @@
+#include "sim-trace-index.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace simdata {
+
+void to_json(nlohmann::json &j, const SimTraceIndex::Location &loc)
+{
+  j = nlohmann::json::array({loc.fileIndex, loc.offset, loc.length});
+}
+
+void from_json(const nlohmann::json &j, SimTraceIndex::Location &loc)
+{
+  j.at(0).get_to(loc.fileIndex);
+  j.at(1).get_to(loc.offset);
+  j.at(2).get_to(loc.length);
+}
+
+
+SimTraceIndexPointer SimTraceIndex::Build(const std::vector<std::string> &files,
+                                          simdjson::ondemand::parser &parser)
+{
+  using namespace simdjson;
+
+  SimTraceIndexPointer index = std::make_shared<SimTraceIndex>();
+  index->m_files = files;
+
+  std::vector<std::map<VantagePointKey, std::vector<Location>>> fileTraces(files.size());
+  std::vector<std::string> titleRefs;
+  bool foundHeader = false;
+  uint32_t headerIndex = 0;
+
+  for (uint32_t i = 0; i < files.size(); i++)
+  {
+    padded_string jsonstring = padded_string::load(files[i]);
+    ondemand::document doc = parser.iterate(jsonstring);
+    ondemand::object root_obj = doc.get_object();
+
+    // raw_json returns views into the loaded file, which give the location of the objects
+    auto locate = [&](std::string_view raw) {
+      return Location{i, static_cast<uint64_t>(raw.data() - jsonstring.data()), raw.size()};
+    };
+
+    std::string_view simIdView;
+    auto error = root_obj["title"].get(simIdView);
+    if (error == NO_SUCH_FIELD)
+    {
+      if (root_obj["title_ref"].get(simIdView) != SUCCESS)
+        throw std::runtime_error("Error while parsing title_ref field.");
+      titleRefs.push_back(std::string(simIdView));
+    }
+    else if (error != SUCCESS)
+      throw std::runtime_error("Error while parsing title field.");
+    else
+    {
+      if (foundHeader)
+        throw std::runtime_error("Duplicate sim id.");
+      foundHeader = true;
+      headerIndex = i;
+      index->m_simId = std::string(simIdView);
+      ondemand::object summary = root_obj["summary"];
+      index->m_summary = locate(summary.raw_json().value());
+    }
+
+    ondemand::array traces = root_obj["traces"];
+    for (ondemand::object trace : traces)
+    {
+      ondemand::object vp = trace["vantage_point"];
+      std::string vp_name(vp["name"].get_string().value());
+      uint32_t vp_nodeId = std::stoul(vp_name.substr(0, vp_name.find('/')));
+      VantagePointType vp_type =
+          VantagePointTypeFromString(std::string(vp["type"].get_string().value()));
+      if (vp_type == VantagePointType::UNKNOWN)
+      {
+        std::cerr << "Unkown Vantage Point Type" << std::endl;
+        continue;
+      }
+
+      fileTraces[i][std::make_pair(vp_type, vp_nodeId)].push_back(locate(trace.raw_json().value()));
+    }
+  }
+
+  if (!foundHeader)
+    throw std::runtime_error("No file with a title found.");
+  for (const std::string &titleRef : titleRefs)
+  {
+    if (titleRef != index->m_simId)
+      throw std::runtime_error("title_ref field points to non-existing sim id.");
+  }
+
+  auto appendFile = [&index](std::map<VantagePointKey, std::vector<Location>> &traces) {
+    for (auto &[vpKey, locations] : traces)
+    {
+      auto &allLocations = index->m_traces[vpKey];
+      allLocations.insert(allLocations.end(), locations.begin(), locations.end());
+    }
+  };
+  appendFile(fileTraces[headerIndex]);
+  for (uint32_t i = 0; i < files.size(); i++)
+  {
+    if (i != headerIndex)
+      appendFile(fileTraces[i]);
+  }
+
+  return index;
+}
+
+void SimTraceIndex::Write(const std::string &file, const std::string &key) const
+{
+  nlohmann::json j;
+  j["version"] = FORMAT_VERSION;
+  j["key"] = key;
+  j["sim_id"] = m_simId;
+  j["files"] = m_files;
+  j["summary"] = m_summary;
+  j["traces"] = nlohmann::json::array();
+  for (const auto &[vpKey, locations] : m_traces)
+  {
+    j["traces"].push_back(
+        {{"type", vpKey.first}, {"node_id", vpKey.second}, {"locations", locations}});
+  }
+
+  std::string tmpFile = file + ".tmp";
+  std::ofstream out(tmpFile, std::ios::trunc);
+  if (!out.is_open())
+    throw std::runtime_error("Could not open trace index file " + tmpFile + " for writing.");
+  out << j;
+  out.close();
+  if (!out)
+    throw std::runtime_error("Failed to write trace index file " + tmpFile + ".");
+
+  // Readers never see a partially written index
+  std::filesystem::rename(tmpFile, file);
+}
+
+SimTraceIndexPointer SimTraceIndex::Read(const std::string &file, const std::string &key)
+{
+  std::ifstream in(file);
+  if (!in.is_open())
+    return nullptr;
+
+  try
+  {
+    nlohmann::json j = nlohmann::json::parse(in);
+    if (j.at("version").get<uint32_t>() != FORMAT_VERSION || j.at("key").get<std::string>() != key)
+      return nullptr;
+
+    SimTraceIndexPointer index = std::make_shared<SimTraceIndex>();
+    j.at("sim_id").get_to(index->m_simId);
+    j.at("files").get_to(index->m_files);
+    j.at("summary").get_to(index->m_summary);
+    for (const auto &trace : j.at("traces"))
+    {
+      VantagePointKey vpKey(trace.at("type").get<VantagePointType>(),
+                            trace.at("node_id").get<uint32_t>());
+      trace.at("locations").get_to(index->m_traces[vpKey]);
+    }
+    return index;
+  }
+  catch (const nlohmann::json::exception &e)
+  {
+    std::cout << "Warning: Trace index file " << file << " is corrupt (" << e.what() << ")."
+              << std::endl;
+    return nullptr;
+  }
+}
+
+std::set<uint32_t> SimTraceIndex::GetNodeIds(VantagePointType type) const
+{
+  std::set<uint32_t> ids;
+  for (const auto &[vpKey, locations] : m_traces)
+  {
+    if (vpKey.first == type)
+      ids.insert(vpKey.second);
+  }
+  return ids;
+}
+
+const std::vector<SimTraceIndex::Location> &SimTraceIndex::GetTraceLocations(
+    VantagePointType type, uint32_t nodeId) const
+{
+  static const std::vector<Location> noLocations;
+  auto it = m_traces.find(std::make_pair(type, nodeId));
+  if (it == m_traces.end())
+    return noLocations;
+  return it->second;
+}
+
+simdjson::padded_string SimTraceIndex::Load(const Location &location) const
+{
+  const std::string &file = m_files.at(location.fileIndex);
+  std::ifstream in(file, std::ios::binary);
+  if (!in.is_open())
+    throw std::runtime_error("Could not open QLOG file " + file + ".");
+
+  simdjson::padded_string buffer(location.length);
+  in.seekg(location.offset);
+  in.read(buffer.data(), location.length);
+  if (!in)
+    throw std::runtime_error("Could not read trace index location from " + file + ".");
+  return buffer;
+}
+
+}  // namespace simdata
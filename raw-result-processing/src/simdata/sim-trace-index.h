@@ -0,0 +1,79 @@
+#ifndef SIM_TRACE_INDEX_H
+#define SIM_TRACE_INDEX_H
+
+#include <simdjson.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "sim-result-set.h"
+
+namespace simdata {
+
+// Maps each vantage point of a simulation run to the byte ranges of its traces in the QLOG files,
+// so that the traces of single vantage points can be imported without parsing the other ones.
+//
+// The index is created by one scan over all files of the run, which only locates the traces
+// (vantage point and extent) without parsing their events. It can be stored as a JSON file.
+class SimTraceIndex
+{
+public:
+  /// @brief Increase whenever the stored data changes
+  static constexpr uint32_t FORMAT_VERSION = 1;
+
+  struct Location
+  {
+    uint32_t fileIndex;  // Index into GetFiles()
+    uint64_t offset;     // Byte offset of the JSON object in the file
+    uint64_t length;     // Length of the JSON object in bytes
+  };
+
+  typedef std::pair<VantagePointType, uint32_t> VantagePointKey;
+
+  /// @brief Scans the files of one simulation run
+  /// @param files The QLOG files of the run, exactly one of them has to contain a title and summary
+  /// @param parser A simdjson parser (reusing it is more efficient)
+  /// @return The index, traces of a vantage point are ordered like they are imported by
+  /// SimDataManager::ImportResults: first the file with the summary, then the others in the given
+  /// order
+  static SimTraceIndexPointer Build(const std::vector<std::string> &files,
+                                    simdjson::ondemand::parser &parser);
+
+  /// @brief Writes the index to a JSON file
+  /// @param file The index file
+  /// @param key A key identifying the QLOG files (see SimSnapshot::CreateKey)
+  void Write(const std::string &file, const std::string &key) const;
+
+  /// @brief Reads an index from a JSON file written by Write
+  /// @param file The index file
+  /// @param key The key of the current QLOG files
+  /// @return The index or nullptr if the file does not exist, is outdated, or was created for
+  /// different QLOG files
+  static SimTraceIndexPointer Read(const std::string &file, const std::string &key);
+
+  const SimId &GetSimId() const { return m_simId; }
+  const std::vector<std::string> &GetFiles() const { return m_files; }
+  const Location &GetSummaryLocation() const { return m_summary; }
+
+  std::set<uint32_t> GetNodeIds(VantagePointType type) const;
+  /// @return The locations of all traces of a vantage point, empty if it has no trace
+  const std::vector<Location> &GetTraceLocations(VantagePointType type, uint32_t nodeId) const;
+
+  /// @brief Reads the JSON object at a location into a buffer that can be parsed by simdjson
+  simdjson::padded_string Load(const Location &location) const;
+
+private:
+  SimId m_simId;
+  std::vector<std::string> m_files;
+  Location m_summary;
+  std::map<VantagePointKey, std::vector<Location>> m_traces;
+};
+
+void to_json(nlohmann::json &j, const SimTraceIndex::Location &loc);
+void from_json(const nlohmann::json &j, SimTraceIndex::Location &loc);
+
+}  // namespace simdata
+
+#endif  // SIM_TRACE_INDEX_H
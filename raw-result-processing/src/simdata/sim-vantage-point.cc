@@ -5,6 +5,25 @@
 
 namespace simdata {
 
+namespace {
+
+// Moves all entries of source into target, merging the events of entries with the same id
+template <typename Map>
+void MergeEntries(Map &target, Map &source)
+{
+  for (auto it = source.begin(); it != source.end(); it++)
+  {
+    auto targetIt = target.find(it->first);
+    if (targetIt == target.end())
+      target.insert(*it);
+    else
+      targetIt->second->Merge(*it->second);
+  }
+  source.clear();
+}
+
+}  // namespace
+
 std::string VantagePointTypeToString(VantagePointType &vpt)
 {
   switch (vpt)
@@ -39,8 +58,9 @@ VantagePointType VantagePointTypeFromString(std::string s)
 
 // ####### SimHostVantagePoint #######
 
-SimHostVantagePoint::SimHostVantagePoint(VantagePointType type, uint32_t nodeId)
-    : SimVantagePoint(type, nodeId)
+SimHostVantagePoint::SimHostVantagePoint(VantagePointType type, uint32_t nodeId,
+                                         SimArenaPointer arena)
+    : SimVantagePoint(type, nodeId, arena)
 {
   if (type == VantagePointType::NETWORK)
     throw std::invalid_argument("Try to create host vantage point with type network.");
@@ -49,24 +69,38 @@ SimHostVantagePoint::SimHostVantagePoint(VantagePointType type, uint32_t nodeId)
 HostVantagePointPointer SimHostVantagePoint::ApplyFilter(const SimFilter &filter)
 {
   HostVantagePointPointer hvpp = std::make_shared<SimHostVantagePoint>(*this);
+  // Filtered copies are not imported into, so they do not need the arena
+  hvpp->m_arena.reset();
 
-  // Recursively apply filter to all flows
+  // Recursively apply filter to all flows it changes, the others are shared
   for (auto it = m_simFlows.begin(); it != m_simFlows.end(); it++)
   {
-    hvpp->m_simFlows[it->first] = it->second->ApplyFilter(filter);
+    if (it->second->IsAffectedBy(filter))
+      hvpp->m_simFlows[it->first] = it->second->ApplyFilter(filter);
   }
 
   return hvpp;
 }
 
+bool SimHostVantagePoint::IsAffectedBy(const SimFilter &filter) const
+{
+  for (auto it = m_simFlows.begin(); it != m_simFlows.end(); it++)
+  {
+    if (it->second->IsAffectedBy(filter))
+      return true;
+  }
+  return false;
+}
+
 void SimHostVantagePoint::AddEvent(EventPointer simEvent)
 {
   auto it = m_simFlows.find(simEvent->flowId);
   SimHostFlowPointer hostFlow;
   if (it == m_simFlows.end())
   {
-    hostFlow = std::make_shared<SimHostFlow>(simEvent->flowId);
+    hostFlow = MakeArenaShared<SimHostFlow>(m_arena, simEvent->flowId, m_arena);
     m_simFlows.insert(std::make_pair(simEvent->flowId, hostFlow));
+    m_flowIds.insert(simEvent->flowId);
   }
   else
     hostFlow = it->second;
@@ -74,7 +108,22 @@ void SimHostVantagePoint::AddEvent(EventPointer simEvent)
   hostFlow->AddEvent(simEvent);
 }
 
-uint32_t SimHostVantagePoint::GetEventCount()
+void SimHostVantagePoint::SortEvents()
+{
+  for (auto it = m_simFlows.begin(); it != m_simFlows.end(); it++) it->second->SortEvents();
+}
+
+void SimHostVantagePoint::Merge(SimHostVantagePoint &other)
+{
+  if (other.m_nodeId != m_nodeId || other.m_type != m_type)
+    throw std::invalid_argument("Try to merge vantage points of different nodes.");
+
+  MergeEntries(m_simFlows, other.m_simFlows);
+  m_flowIds.merge(other.m_flowIds);
+  other.m_flowIds.clear();
+}
+
+uint32_t SimHostVantagePoint::GetEventCount() const
 {
   uint32_t count = 0;
   for (auto it = m_simFlows.begin(); it != m_simFlows.end(); it++)
@@ -84,7 +133,7 @@ uint32_t SimHostVantagePoint::GetEventCount()
   return count;
 }
 
-bool SimHostVantagePoint::TryGetFlow(uint32_t flowId, SimHostFlowPointer &hostFlow)
+bool SimHostVantagePoint::TryGetFlow(uint32_t flowId, SimHostFlowPointer &hostFlow) const
 {
   auto it = m_simFlows.find(flowId);
   if (it != m_simFlows.end())
@@ -96,21 +145,14 @@ bool SimHostVantagePoint::TryGetFlow(uint32_t flowId, SimHostFlowPointer &hostFl
   return false;
 }
 
-std::set<uint32_t> SimHostVantagePoint::GetFlowIds()
-{
-  std::set<uint32_t> ids;
-  for (auto it = m_simFlows.begin(); it != m_simFlows.end(); it++)
-  {
-    ids.insert(it->first);
-  }
-
-  return ids;
-}
-
 // ####### SimObsvVantagePoint #######
 
-SimObsvVantagePoint::SimObsvVantagePoint(VantagePointType type, uint32_t nodeId)
-    : SimVantagePoint(type, nodeId)
+SimObsvVantagePoint::SimObsvVantagePoint(VantagePointType type, uint32_t nodeId,
+                                         SimArenaPointer arena)
+    : SimVantagePoint(type, nodeId, arena),
+      m_simPaths(SimPathMap::allocator_type(arena)),
+      m_simPingClientPairs(SimPingPairMap::allocator_type(arena)),
+      m_simPingServerPairs(SimPingPairMap::allocator_type(arena))
 {
   if (type == VantagePointType::CLIENT || type == VantagePointType::SERVER)
     throw std::invalid_argument("Try to create observer vantage point with type client or server.");
@@ -119,16 +161,65 @@ SimObsvVantagePoint::SimObsvVantagePoint(VantagePointType type, uint32_t nodeId)
 ObsvVantagePointPointer SimObsvVantagePoint::ApplyFilter(const SimFilter &filter)
 {
   ObsvVantagePointPointer ovpp = std::make_shared<SimObsvVantagePoint>(*this);
+  // Filtered copies are not imported into, so they do not need the arena
+  ovpp->m_arena.reset();
 
-  // Recursively apply filter to all flows
+  // Recursively apply filter to all flows it changes, the others are shared
   for (auto it = m_simFlows.begin(); it != m_simFlows.end(); it++)
   {
-    ovpp->m_simFlows[it->first] = it->second->ApplyFilter(filter);
+    if (it->second->IsAffectedBy(filter))
+      ovpp->m_simFlows[it->first] = it->second->ApplyFilter(filter);
   }
 
   return ovpp;
 }
 
+std::vector<ObsvVantagePointPointer> SimObsvVantagePoint::ApplyFilters(
+    const std::vector<SimFilter> &filters)
+{
+  std::vector<ObsvVantagePointPointer> ovpps;
+  ovpps.reserve(filters.size());
+  for (size_t i = 0; i < filters.size(); i++)
+  {
+    ovpps.push_back(std::make_shared<SimObsvVantagePoint>(*this));
+    ovpps.back()->m_arena.reset();
+  }
+
+  // Each flow is filtered once by all filters that change it, the others are shared
+  for (auto it = m_simFlows.begin(); it != m_simFlows.end(); it++)
+  {
+    std::vector<SimFilter> flowFilters;
+    std::vector<size_t> flowFilterIndices;
+    for (size_t i = 0; i < filters.size(); i++)
+    {
+      if (it->second->IsAffectedBy(filters[i]))
+      {
+        flowFilters.push_back(filters[i]);
+        flowFilterIndices.push_back(i);
+      }
+    }
+    if (flowFilters.empty())
+      continue;
+
+    std::vector<SimObsvFlowPointer> filteredFlows = it->second->ApplyFilters(flowFilters);
+    for (size_t i = 0; i < filteredFlows.size(); i++)
+      ovpps[flowFilterIndices[i]]->m_simFlows[it->first] = filteredFlows[i];
+  }
+
+  return ovpps;
+}
+
+bool SimObsvVantagePoint::IsAffectedBy(const SimFilter &filter) const
+{
+  // Filters only apply to flows, paths and ping pairs are always shared
+  for (auto it = m_simFlows.begin(); it != m_simFlows.end(); it++)
+  {
+    if (it->second->IsAffectedBy(filter))
+      return true;
+  }
+  return false;
+}
+
 void SimObsvVantagePoint::AddEvent(EventPointer simEvent)
 {
   if (simEvent->IsPathEvent())
@@ -137,8 +228,9 @@ void SimObsvVantagePoint::AddEvent(EventPointer simEvent)
     SimPathPointer path;
     if (it == m_simPaths.end())
     {
-      path = std::make_shared<SimPath>(simEvent->flowId);
+      path = MakeArenaShared<SimPath>(m_arena, simEvent->flowId, m_arena);
       m_simPaths.insert(std::make_pair(simEvent->flowId, path));
+      m_pathIds.insert(simEvent->flowId);
     }
     else
       path = it->second;
@@ -150,7 +242,7 @@ void SimObsvVantagePoint::AddEvent(EventPointer simEvent)
     SimPingPairPointer pp;
     if (it == m_simPingClientPairs.end())
     {
-      pp = std::make_shared<SimPingPair>(PingPairType::CLIENT, simEvent->flowId);
+      pp = MakeArenaShared<SimPingPair>(m_arena, PingPairType::CLIENT, simEvent->flowId, m_arena);
       m_simPingClientPairs.insert(std::make_pair(simEvent->flowId, pp));
     }
     else
@@ -163,7 +255,7 @@ void SimObsvVantagePoint::AddEvent(EventPointer simEvent)
     SimPingPairPointer pp;
     if (it == m_simPingServerPairs.end())
     {
-      pp = std::make_shared<SimPingPair>(PingPairType::SERVER, simEvent->flowId);
+      pp = MakeArenaShared<SimPingPair>(m_arena, PingPairType::SERVER, simEvent->flowId, m_arena);
       m_simPingServerPairs.insert(std::make_pair(simEvent->flowId, pp));
     }
     else
@@ -176,8 +268,9 @@ void SimObsvVantagePoint::AddEvent(EventPointer simEvent)
     SimObsvFlowPointer obsvFlow;
     if (it == m_simFlows.end())
     {
-      obsvFlow = std::make_shared<SimObserverFlow>(simEvent->flowId);
+      obsvFlow = MakeArenaShared<SimObserverFlow>(m_arena, simEvent->flowId, m_arena);
       m_simFlows.insert(std::make_pair(simEvent->flowId, obsvFlow));
+      m_flowIds.insert(simEvent->flowId);
     }
     else
       obsvFlow = it->second;
@@ -186,7 +279,32 @@ void SimObsvVantagePoint::AddEvent(EventPointer simEvent)
   }
 }
 
-uint32_t SimObsvVantagePoint::GetEventCount()
+void SimObsvVantagePoint::SortEvents()
+{
+  for (auto it = m_simFlows.begin(); it != m_simFlows.end(); it++) it->second->SortEvents();
+  for (auto it = m_simPaths.begin(); it != m_simPaths.end(); it++) it->second->SortEvents();
+  for (auto it = m_simPingClientPairs.begin(); it != m_simPingClientPairs.end(); it++)
+    it->second->SortEvents();
+  for (auto it = m_simPingServerPairs.begin(); it != m_simPingServerPairs.end(); it++)
+    it->second->SortEvents();
+}
+
+void SimObsvVantagePoint::Merge(SimObsvVantagePoint &other)
+{
+  if (other.m_nodeId != m_nodeId)
+    throw std::invalid_argument("Try to merge vantage points of different nodes.");
+
+  MergeEntries(m_simFlows, other.m_simFlows);
+  MergeEntries(m_simPaths, other.m_simPaths);
+  m_flowIds.merge(other.m_flowIds);
+  other.m_flowIds.clear();
+  m_pathIds.merge(other.m_pathIds);
+  other.m_pathIds.clear();
+  MergeEntries(m_simPingClientPairs, other.m_simPingClientPairs);
+  MergeEntries(m_simPingServerPairs, other.m_simPingServerPairs);
+}
+
+uint32_t SimObsvVantagePoint::GetEventCount() const
 {
   uint32_t count = 0;
   for (auto it = m_simFlows.begin(); it != m_simFlows.end(); it++)
@@ -200,7 +318,7 @@ uint32_t SimObsvVantagePoint::GetEventCount()
   return count;
 }
 
-bool SimObsvVantagePoint::TryGetFlow(uint32_t flowId, SimObsvFlowPointer &obsvFlow)
+bool SimObsvVantagePoint::TryGetFlow(uint32_t flowId, SimObsvFlowPointer &obsvFlow) const
 {
   auto it = m_simFlows.find(flowId);
   if (it != m_simFlows.end())
@@ -212,7 +330,7 @@ bool SimObsvVantagePoint::TryGetFlow(uint32_t flowId, SimObsvFlowPointer &obsvFl
   return false;
 }
 
-SimObsvFlowPointer SimObsvVantagePoint::GetFlow(uint32_t flowId)
+SimObsvFlowPointer SimObsvVantagePoint::GetFlow(uint32_t flowId) const
 {
   auto it = m_simFlows.find(flowId);
   if (it != m_simFlows.end())
@@ -223,18 +341,7 @@ SimObsvFlowPointer SimObsvVantagePoint::GetFlow(uint32_t flowId)
                            std::to_string(m_nodeId));
 }
 
-std::set<uint32_t> SimObsvVantagePoint::GetFlowIds()
-{
-  std::set<uint32_t> ids;
-  for (auto it = m_simFlows.begin(); it != m_simFlows.end(); it++)
-  {
-    ids.insert(it->first);
-  }
-
-  return ids;
-}
-
-SimPathPointer SimObsvVantagePoint::GetPath(uint32_t pathId)
+SimPathPointer SimObsvVantagePoint::GetPath(uint32_t pathId) const
 {
   auto it = m_simPaths.find(pathId);
   if (it != m_simPaths.end())
@@ -245,16 +352,5 @@ SimPathPointer SimObsvVantagePoint::GetPath(uint32_t pathId)
                            std::to_string(m_nodeId));
 }
 
-std::set<uint32_t> SimObsvVantagePoint::GetPathIds()
-{
-  std::set<uint32_t> ids;
-  for (auto it = m_simPaths.begin(); it != m_simPaths.end(); it++)
-  {
-    ids.insert(it->first);
-  }
-
-  return ids;
-}
-
 
 }  // namespace simdata
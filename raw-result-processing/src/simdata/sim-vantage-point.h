@@ -8,6 +8,7 @@
 #include "sim-events.h"
 #include "sim-filter.h"
 #include "sim-flow.h"
+#include "sim-id-map.h"
 #include "sim-path.h"
 #include "sim-ping-pair.h"
 
@@ -45,73 +46,113 @@ public:
 
   virtual void AddEvent(EventPointer simEvent) = 0;
 
-  virtual uint32_t GetEventCount() = 0;
+  // Puts the events added out of time order in place, has to be called once all events of an
+  // import are added
+  virtual void SortEvents() = 0;
+
+  virtual uint32_t GetEventCount() const = 0;
 
 protected:
-  SimVantagePoint(VantagePointType type, uint32_t nodeId) : m_type(type), m_nodeId(nodeId) {}
+  SimVantagePoint(VantagePointType type, uint32_t nodeId, SimArenaPointer arena)
+      : m_type(type), m_nodeId(nodeId), m_arena(std::move(arena))
+  {
+  }
+
+  // Arena for the flows, paths, and ping pairs created by AddEvent (nullptr: heap)
+  SimArenaPointer m_arena;
 };
 
 class SimHostVantagePoint : public SimVantagePoint
 {
 public:
-  SimHostVantagePoint(VantagePointType type, uint32_t nodeId);
+  SimHostVantagePoint(VantagePointType type, uint32_t nodeId, SimArenaPointer arena = nullptr);
 
+  // The filtered vantage point shares all flows the filter does not change with this one
   HostVantagePointPointer ApplyFilter(const SimFilter &filter);
+  // Whether ApplyFilter changes any flow, unaffected vantage points can be used as filtered ones
+  bool IsAffectedBy(const SimFilter &filter) const;
 
   virtual void AddEvent(EventPointer simEvent) override;
 
-  virtual uint32_t GetEventCount() override;
+  virtual void SortEvents() override;
+
+  // Moves all flows and events of other (same node) into this vantage point
+  void Merge(SimHostVantagePoint &other);
+
+  virtual uint32_t GetEventCount() const override;
 
   // Returns true if a flow with the specified id is found, false otherwise
-  bool TryGetFlow(uint32_t flowId, SimHostFlowPointer &hostFlow);
+  bool TryGetFlow(uint32_t flowId, SimHostFlowPointer &hostFlow) const;
 
-  std::set<uint32_t> GetFlowIds();
+  const std::set<uint32_t> &GetFlowIds() const { return m_flowIds; }
 
 protected:
-  typedef std::map<uint32_t, SimHostFlowPointer> SimHostFlowMap;
+  typedef SimIdMap<uint32_t, SimHostFlowPointer> SimHostFlowMap;
   SimHostFlowMap m_simFlows;
+  // The ids of m_simFlows, kept up to date so that GetFlowIds does not have to collect them
+  std::set<uint32_t> m_flowIds;
 
 private:
+  friend class SimSnapshot;
 };
 
 class SimObsvVantagePoint : public SimVantagePoint
 {
 public:
-  SimObsvVantagePoint(VantagePointType type, uint32_t nodeId);
+  SimObsvVantagePoint(VantagePointType type, uint32_t nodeId, SimArenaPointer arena = nullptr);
 
+  // The filtered vantage point shares all flows, paths, and ping pairs the filter does not change
+  // with this one
   ObsvVantagePointPointer ApplyFilter(const SimFilter &filter);
+  // Applies several filters in one pass over the flows, returns one vantage point per filter
+  std::vector<ObsvVantagePointPointer> ApplyFilters(const std::vector<SimFilter> &filters);
+  // Whether ApplyFilter changes any flow, unaffected vantage points can be used as filtered ones
+  bool IsAffectedBy(const SimFilter &filter) const;
 
   virtual void AddEvent(EventPointer simEvent) override;
 
-  virtual uint32_t GetEventCount() override;
+  virtual void SortEvents() override;
+
+  // Moves all flows, paths, ping pairs, and events of other (same node) into this vantage point
+  void Merge(SimObsvVantagePoint &other);
+
+  virtual uint32_t GetEventCount() const override;
 
   // Returns true if a flow with the specified id is found, false otherwise
-  bool TryGetFlow(uint32_t flowId, SimObsvFlowPointer &obsvFlow);
+  bool TryGetFlow(uint32_t flowId, SimObsvFlowPointer &obsvFlow) const;
 
   // Returns the flow associated with the specified id, throws exception if id not found
-  SimObsvFlowPointer GetFlow(uint32_t flowId);
+  SimObsvFlowPointer GetFlow(uint32_t flowId) const;
 
-  std::set<uint32_t> GetFlowIds();
+  const std::set<uint32_t> &GetFlowIds() const { return m_flowIds; }
 
-  SimPathPointer GetPath(uint32_t pathId);
+  SimPathPointer GetPath(uint32_t pathId) const;
 
-  std::set<uint32_t> GetPathIds();
+  const std::set<uint32_t> &GetPathIds() const { return m_pathIds; }
 
-  typedef std::map<uint32_t, SimPingPairPointer> SimPingPairMap;
+  typedef SimIdMap<uint32_t, SimObsvFlowPointer> SimObsvFlowMap;
+  const SimObsvFlowMap &GetFlows() const { return m_simFlows; }
+
+  typedef SimArenaMap<uint32_t, SimPingPairPointer> SimPingPairMap;
   const SimPingPairMap &GetClientPingPairs() const { return m_simPingClientPairs; }
   const SimPingPairMap &GetServerPingPairs() const { return m_simPingServerPairs; }
 
 protected:
-  typedef std::map<uint32_t, SimObsvFlowPointer> SimObsvFlowMap;
   SimObsvFlowMap m_simFlows;
 
-  typedef std::map<uint32_t, SimPathPointer> SimPathMap;
+  typedef SimArenaMap<uint32_t, SimPathPointer> SimPathMap;
   SimPathMap m_simPaths;
 
+  // The ids of m_simFlows and m_simPaths, kept up to date so that GetFlowIds and GetPathIds do not
+  // have to collect them
+  std::set<uint32_t> m_flowIds;
+  std::set<uint32_t> m_pathIds;
+
   SimPingPairMap m_simPingClientPairs;
   SimPingPairMap m_simPingServerPairs;
 
 private:
+  friend class SimSnapshot;
 };
 
 
@@ -0,0 +1,159 @@
+// Runs the same analysis configs sequentially and on several threads. The configs run as tasks of
+// their own and localize on several threads themselves, their results are collected per task and
+// merged in config order, so the output has to be the same as the one of the sequential run.
+
+#include <analysis-manager.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+#include <unistd.h>
+
+#include "test-checks.h"
+#include "test-sim-data.h"
+
+using namespace analysis;
+using json = nlohmann::json;
+
+namespace {
+
+const std::vector<std::vector<uint32_t>> paths = {{1, 2, 3},    {1, 2, 4}, {5, 2, 3},
+                                                  {5, 2, 4, 6}, {3, 6},    {1, 5}};
+const std::vector<TestFailedLink> failedLinks = {{2, 4, 0.05, 50}, {3, 2, 0.2, 5}};
+
+json CreateConfig(const json &methods, const json &selectionStrategies, uint32_t transients)
+{
+  return {{"storeMeasurements", transients == 0},
+          {"performLocalization", true},
+          {"classificationModes", {"PERFECT"}},
+          {"efmBitSets", {{"L"}, {"Q"}, {"T"}, {"SPIN"}, {"Q", "L"}}},
+          {"observerSets", {json::array(), {1, 2, 3}, {2, 4, 5, 6}}},
+          {"lossRateTh", 0.01},
+          {"delayThMs", 10},
+          {"localizationMethods", methods},
+          {"flowSelectionStrategies", selectionStrategies},
+          {"simFilter",
+           {{"lBitTriggeredMonitoring", false}, {"removeLastXSpinTransients", transients}}},
+          {"time_filter_ms", 0},
+          {"output_raw_values", false}};
+}
+
+std::vector<AnalysisConfig> CreateConfigs()
+{
+  json weights = {{"winc", 1.5},   {"wdec", 0.5},     {"wscale", 1.0},
+                  {"wthresh", 1.0}, {"pathscale", 1.0}};
+  json weightsLvl = {{"winc_lvl1", 1.5}, {"winc_lvl2", 2.0}, {"winc_lvl3", 2.5}, {"wdec", 0.5},
+                     {"wscale", 1.0},    {"wthresh", 1.0},   {"pathscale", 1.0}};
+  json random = {{"RANDOM", {{"flow_count", 2}}}};
+
+  json configs = {
+      CreateConfig({{"POSSIBLE", json::object()},
+                    {"PROBABLE", json::object()},
+                    {"DETECTION", json::object()},
+                    {"DLC", {{"dlcthresh", 0.7}}}},
+                   {{"ALL", json::object()}, {"COVERAGE", {{"flow_count", 2}}}}, 0),
+      CreateConfig({{"WEIGHT_ITER", weights}, {"WEIGHT_DIR", weights}, {"WEIGHT_BAD", weights}},
+                   random, 1),
+      CreateConfig({{"WEIGHT_ITER_LVL", weightsLvl},
+                    {"WEIGHT_DIR_LVL", weightsLvl},
+                    {"WEIGHT_BAD_LVL", weightsLvl}},
+                   {{"ALL", json::object()}}, 0),
+      CreateConfig({{"POSSIBLE", json::object()}, {"WEIGHT_DIR", weights}}, random, 2),
+      CreateConfig({{"PROBABLE", json::object()}, {"WEIGHT_ITER", weights}},
+                   {{"COVERAGE", {{"flow_count", 1}}}}, 2)};
+
+  // Classified on the measured loss rates and delays of filtered result sets, the time filter
+  // only keeps the spin bit delays of the first flows
+  json measured = CreateConfig({{"POSSIBLE", json::object()},
+                                {"DLC", {{"dlcthresh", 0.7}}},
+                                {"WEIGHT_DIR", weights},
+                                {"WEIGHT_ITER_LVL", weightsLvl}},
+                               {{"ALL", json::object()}}, 1);
+  measured["storeMeasurements"] = true;
+  measured["classificationModes"] = {"STATIC", "PERFECT"};
+  measured["time_filter_ms"] = 100;
+  configs.push_back(measured);
+
+  json linear = CreateConfig({{"LIN_LSQR", json::object()},
+                              {"LIN_LSQR_CORE_ONLY", json::object()},
+                              {"FLOW_COMBINATION", json::object()},
+                              {"FLOW_COMBINATION_FIXED_FLOWS", json::object()}},
+                             random, 2);
+  linear["classificationModes"] = {"STATIC"};
+  linear["simFilter"]["lBitTriggeredMonitoring"] = true;
+  linear["time_filter_ms"] = 1000;
+  configs.push_back(linear);
+
+  std::vector<AnalysisConfig> analysisConfigs;
+  for (const json &config : configs) analysisConfigs.push_back(config.get<AnalysisConfig>());
+  return analysisConfigs;
+}
+
+std::string RunAnalyses(simdata::SimResultSetPointer srs, const std::filesystem::path &outputDir,
+                        uint32_t numThreads)
+{
+  std::filesystem::path outputFile = outputDir / ("output-" + std::to_string(numThreads) + ".json");
+  // Random flow selection draws from rand(), every run starts from the same seed
+  srand(1);
+  AnalysisManager::RunAnalyses(srs, outputFile.string(), CreateConfigs(), numThreads);
+
+  std::ifstream is(outputFile, std::ios::in | std::ios::binary);
+  std::stringstream output;
+  output << is.rdbuf();
+  return output.str();
+}
+
+}  // namespace
+
+int main()
+{
+  TestEvents events;
+  events.lossEvents = true;
+  simdata::SimResultSetPointer srs = CreateTestResultSet(paths, 3, failedLinks, events);
+  // Not in the working directory, where ctest keeps the test binaries
+  std::filesystem::path outputDir = std::filesystem::temp_directory_path() /
+                                    ("analysis-concurrency-test-" + std::to_string(getpid()));
+
+  std::string serialOutput = RunAnalyses(srs, outputDir, 1);
+  json serialJson = json::parse(serialOutput);
+  const json &results = serialJson.at("localizationResults");
+  size_t resultCount = results.size();
+  // The measurements have to be localized on, or the threads only share the ground truth
+  std::set<std::string> measuredMethods;
+  for (const json &result : results)
+  {
+    if (result.at("config").at("classificationMode") != "STATIC")
+      continue;
+    for (const json &methodResult : result.at("results"))
+      measuredMethods.insert(methodResult.at("method").get<std::string>());
+  }
+  for (const char *method : {"POSSIBLE", "WEIGHT_DIR", "LIN_LSQR", "FLOW_COMBINATION_FIXED_FLOWS"})
+  {
+    if (measuredMethods.count(method) == 0)
+    {
+      Fail(std::string("the sequential run did not localize with ") + method +
+           " on measurements");
+      return 1;
+    }
+  }
+
+  for (uint32_t numThreads : {2, 4, 16})
+  {
+    if (RunAnalyses(srs, outputDir, numThreads) != serialOutput)
+    {
+      Fail("the output of " + std::to_string(numThreads) +
+           " threads differs from the sequential output");
+    }
+  }
+
+  std::filesystem::remove_all(outputDir);
+  if (AnyChecksFailed())
+    return 1;
+  std::cout << "Same output on 1, 2, 4, and 16 threads (" << resultCount
+            << " localization result sets)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,540 @@
+// Compares the link weight and link set kernels of the failure localization to straightforward
+// references on random path sets.
+
+#include <failure-localization.h>
+#include <link-weights.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "test-checks.h"
+
+using namespace analysis;
+using namespace analysis::link_weights;
+
+namespace {
+
+const double tolerance = 1e-9;
+
+uint32_t comparedSets = 0;  // Iterations whose failed links were compared
+uint32_t stoppedSets = 0;   // Iterations that stopped at a link without remaining paths
+uint32_t logWeightSets = 0;  // Log domain weights compared to the linear weights
+uint32_t fallbackSets = 0;   // Log domain weights that fell back to the linear weights
+
+bool IsClose(double a, double b)
+{
+  return std::abs(a - b) <= tolerance * std::max(std::abs(a), std::abs(b));
+}
+
+struct TestCase
+{
+  LinkVec allLinks;
+  ClassPathVec paths;
+};
+
+// Paths over the links of a random topology, normalization only applies if all path links are
+// topology links. The bad path weights of duplicate topology links are decreased twice per path.
+TestCase CreateTestCase(std::mt19937 &rng, bool pathLinksInTopology, bool duplicateTopologyLinks,
+                        size_t linkCount = 16)
+{
+  TestCase tc;
+  std::uniform_int_distribution<uint32_t> nodeDist(1, 6 + linkCount / 8);
+  std::set<Link> links;
+  while (links.size() < linkCount)
+  {
+    Link link(nodeDist(rng), nodeDist(rng));
+    if (link.first != link.second)
+      links.insert(link);
+  }
+  tc.allLinks.assign(links.begin(), links.end());
+  std::shuffle(tc.allLinks.begin(), tc.allLinks.end(), rng);
+  if (duplicateTopologyLinks)
+    tc.allLinks.push_back(tc.allLinks.front());
+
+  std::uniform_int_distribution<size_t> linkDist(0, tc.allLinks.size() - 1);
+  std::uniform_int_distribution<uint32_t> lengthDist(0, 5);
+  std::uniform_int_distribution<uint32_t> levelDist(0, 5);
+  uint32_t pathCount = std::uniform_int_distribution<uint32_t>(1, 2 * linkCount - 2)(rng);
+  for (uint32_t p = 0; p < pathCount; p++)
+  {
+    ClassifiedLinkPath cp{};
+    uint32_t length = lengthDist(rng);
+    for (uint32_t k = 0; k < length; k++)
+      cp.path.links.push_back(tc.allLinks[linkDist(rng)]);
+    if (!pathLinksInTopology && length > 0 && levelDist(rng) == 0)
+      cp.path.links.push_back(Link(100 + p, 200 + p));
+    uint32_t level = levelDist(rng);
+    cp.failed = level >= 3;
+    cp.small_failure = level == 3;
+    cp.medium_failure = level == 4;
+    cp.large_failure = level == 5;
+    tc.paths.push_back(cp);
+  }
+  return tc;
+}
+
+struct WeightParams
+{
+  double winc;
+  double wdec;
+  double wscale;
+  double pathscale;
+  double normalization;
+};
+
+const std::vector<WeightParams> weightParams = {
+    {1.5, 0.8, 1.0, 1.0, 0.0}, {0.5, 0.3, 0.5, 0.0, 0.0}, {1.5, 0.8, 1.0, 1.0, 1.0},
+    {2.0, 0.5, 0.5, 0.0, 1.0}, {1.0, 1.0, 1.0, 0.0, 0.0}, {1.5, 0.0, 1.0, 1.0, 0.0}};
+
+// Thresholds below, around and above the weights that occur for the params
+std::vector<double> Thresholds(const WeightParams &wp, size_t linkCount)
+{
+  if (wp.normalization == 1.0)
+    return {0.5 / linkCount, 1.5 / linkCount, 3.0 / linkCount, 0.5};
+  return {0.5, 1.0, 2.0, 8.0};
+}
+
+// Steps IncrementalLinkWeights through the removals of IterativeWeightedLinks_Recompute and compares
+// its weights to the recomputed ones after every removal, then compares the failed links of both
+template <typename IncFactor>
+void CheckIterativeWeights(const TestCase &tc, IncFactor incFactor, const WeightParams &wp,
+                           double wthresh, const std::string &name)
+{
+  std::optional<IncrementalLinkWeights> weights =
+      IncrementalLinkWeights::Create(tc.paths, tc.allLinks, incFactor, wp.wdec, wp.normalization);
+  if (!weights)
+  {
+    bool nonTopologyLinks = false;
+    for (const ClassifiedLinkPath &cp : tc.paths)
+    {
+      for (const Link &link : cp.path.links)
+      {
+        nonTopologyLinks |=
+            std::find(tc.allLinks.begin(), tc.allLinks.end(), link) == tc.allLinks.end();
+      }
+    }
+    if (wp.wdec > 0 && !(wp.normalization == 1.0 && nonTopologyLinks))
+      Fail(name + ": no incremental weights");
+    return;
+  }
+
+  ClassPathVec itPaths = tc.paths;
+  LinkSet markedLinks;
+  // Ties and weights at the threshold are decided by rounding, which differs between both
+  bool ambiguous = false;
+  while (true)
+  {
+    std::map<Link, double> expected =
+        AccumulateLinkWeights(itPaths, tc.allLinks, incFactor, wp.wdec, wp.normalization);
+    std::map<Link, double> actual = weights->GetWeights();
+    if (actual.size() != expected.size())
+    {
+      Fail(name + ": " + std::to_string(actual.size()) + " weights instead of " +
+           std::to_string(expected.size()));
+      return;
+    }
+    for (const auto &lw : expected)
+    {
+      auto it = actual.find(lw.first);
+      if (it == actual.end() || !IsClose(it->second, lw.second))
+      {
+        Fail(name + ": weight of " + LinkToString(lw.first) + " differs");
+        return;
+      }
+    }
+
+    double maxWeight = 0;
+    Link maxLink;
+    for (const auto &lw : expected)
+    {
+      if (lw.second > maxWeight)
+      {
+        maxLink = lw.first;
+        maxWeight = lw.second;
+      }
+    }
+    for (const auto &lw : expected)
+    {
+      if (lw.first != maxLink && IsClose(lw.second, maxWeight))
+        ambiguous = true;
+    }
+    if (IsClose(maxWeight, wthresh))
+      ambiguous = true;
+    if (!(maxWeight > wthresh))
+      break;
+    // The best link has no paths left, the iteration stops
+    if (!markedLinks.insert(maxLink).second)
+    {
+      stoppedSets++;
+      break;
+    }
+
+    itPaths.erase(std::remove_if(itPaths.begin(), itPaths.end(),
+                                 [&](const ClassifiedLinkPath &cp) {
+                                   return std::find(cp.path.links.begin(), cp.path.links.end(),
+                                                    maxLink) != cp.path.links.end();
+                                 }),
+                  itPaths.end());
+    const LinkVec &links = weights->GetIndex().links;
+    weights->RemovePaths(std::find(links.begin(), links.end(), maxLink) - links.begin(),
+                         [](uint32_t) {});
+  }
+
+  if (ambiguous)
+    return;
+  comparedSets++;
+  if (IterativeWeightedLinks(tc.paths, tc.allLinks, incFactor, wp.wdec, wthresh,
+                             wp.normalization) != markedLinks ||
+      IterativeWeightedLinks_Recompute(tc.paths, tc.allLinks, incFactor, wp.wdec, wthresh,
+                                       wp.normalization) != markedLinks)
+    Fail(name + ": different failed links");
+}
+
+void CheckIterativeWeights(const TestCase &tc, const std::string &name)
+{
+  for (size_t w = 0; w < weightParams.size(); w++)
+  {
+    const WeightParams &wp = weightParams[w];
+    for (double wthresh : Thresholds(wp, tc.allLinks.size()))
+    {
+      std::string caseName =
+          name + " params " + std::to_string(w) + " wthresh " + std::to_string(wthresh);
+      CheckIterativeWeights(tc, single_level_inc_factor(wp.winc, wp.wscale, wp.pathscale), wp,
+                            wthresh, caseName);
+      CheckIterativeWeights(
+          tc, three_level_inc_factor(wp.winc, 2 * wp.winc, 3 * wp.winc, wp.wscale, wp.pathscale),
+          wp, wthresh, caseName + " three level");
+    }
+  }
+}
+
+bool HasNonTopologyLinks(const TestCase &tc)
+{
+  for (const ClassifiedLinkPath &cp : tc.paths)
+  {
+    for (const Link &link : cp.path.links)
+    {
+      if (std::find(tc.allLinks.begin(), tc.allLinks.end(), link) == tc.allLinks.end())
+        return true;
+    }
+  }
+  return false;
+}
+
+bool HasGoodPaths(const TestCase &tc)
+{
+  for (const ClassifiedLinkPath &cp : tc.paths)
+  {
+    if (!cp.failed && !cp.path.links.empty())
+      return true;
+  }
+  return false;
+}
+
+// Compares the log weights of a log domain kernel to the weights of its linear kernel: the
+// weights have to match, and ordering the links by their log weights orders them by their weights
+void CheckLogWeights(const std::optional<std::map<Link, double>> &logWeights,
+                     const std::map<Link, double> &weights, bool fallback, const std::string &name)
+{
+  if (!logWeights)
+  {
+    if (!fallback)
+      Fail(name + ": unexpected fallback to the linear weights");
+    fallbackSets++;
+    return;
+  }
+  if (fallback)
+    Fail(name + ": log weights where the linear weights are needed");
+  if (logWeights->size() != weights.size())
+  {
+    Fail(name + ": " + std::to_string(logWeights->size()) + " log weights instead of " +
+         std::to_string(weights.size()));
+    return;
+  }
+
+  logWeightSets++;
+  std::vector<std::pair<double, Link>> ranking;
+  for (const auto &lw : *logWeights)
+  {
+    auto it = weights.find(lw.first);
+    if (it == weights.end() || !IsClose(std::exp(lw.second), it->second))
+    {
+      Fail(name + ": log weight of " + LinkToString(lw.first) + " differs");
+      return;
+    }
+    ranking.emplace_back(lw.second, lw.first);
+  }
+  std::sort(ranking.rbegin(), ranking.rend());
+  for (size_t r = 1; r < ranking.size(); r++)
+  {
+    double higher = weights.at(ranking[r - 1].second);
+    double lower = weights.at(ranking[r].second);
+    if (higher < lower && !IsClose(higher, lower))
+      Fail(name + ": " + LinkToString(ranking[r].second) + " ranked below a lighter link");
+  }
+}
+
+// The direct weight methods have to localize the same links in both domains. Only weights at the
+// threshold may be decided differently by rounding, the fallbacks use the same weights.
+template <typename Localize>
+void CheckLogDomainLinks(Localize localize, const std::map<Link, double> &weights,
+                         double wthresh, const std::string &name)
+{
+  for (const auto &lw : weights)
+  {
+    if (IsClose(lw.second, wthresh))
+      return;
+  }
+  if (localize(0.0) != localize(1.0))
+    Fail(name + ": different failed links in the log domain");
+}
+
+void CheckLogDomain(const TestCase &tc, const std::string &name)
+{
+  const bool nonTopologyLinks = HasNonTopologyLinks(tc);
+  const bool goodPaths = HasGoodPaths(tc);
+  const bool duplicateTopologyLinks =
+      std::set<Link>(tc.allLinks.begin(), tc.allLinks.end()).size() < tc.allLinks.size();
+  for (size_t w = 0; w < weightParams.size(); w++)
+  {
+    const WeightParams &wp = weightParams[w];
+    const double wincLvl2 = 2 * wp.winc;
+    const double wincLvl3 = 3 * wp.winc;
+    auto singleLevel = single_level_inc_factor(wp.winc, wp.wscale, wp.pathscale);
+    auto threeLevel = three_level_inc_factor(wp.winc, wincLvl2, wincLvl3, wp.wscale, wp.pathscale);
+    std::string paramsName = name + " params " + std::to_string(w);
+
+    // Non-positive factors have no log, and with normalization links that are not in all_links
+    // start into the normalization later
+    bool fallback = (goodPaths && !(wp.wdec > 0)) || (wp.normalization == 1.0 && nonTopologyLinks);
+    std::map<Link, double> weights =
+        AccumulateLinkWeights(tc.paths, tc.allLinks, singleLevel, wp.wdec, wp.normalization);
+    std::map<Link, double> weightsLvl =
+        AccumulateLinkWeights(tc.paths, tc.allLinks, threeLevel, wp.wdec, wp.normalization);
+    CheckLogWeights(
+        AccumulateLogLinkWeights(tc.paths, tc.allLinks, singleLevel, wp.wdec, wp.normalization),
+        weights, fallback, paramsName + " direct");
+    CheckLogWeights(
+        AccumulateLogLinkWeights(tc.paths, tc.allLinks, threeLevel, wp.wdec, wp.normalization),
+        weightsLvl, fallback, paramsName + " direct three level");
+
+    // The bad path weights decrease duplicate topology links twice per path
+    bool badFallback = !(wp.wdec > 0) || duplicateTopologyLinks;
+    std::map<Link, double> badWeights = AccumulateLinkWeights_BadPathsOnly(
+        tc.paths, tc.allLinks, singleLevel, wp.wdec, wp.normalization);
+    std::map<Link, double> badWeightsLvl = AccumulateLinkWeights_BadPathsOnly(
+        tc.paths, tc.allLinks, threeLevel, wp.wdec, wp.normalization);
+    CheckLogWeights(AccumulateLogLinkWeights_BadPathsOnly(tc.paths, tc.allLinks, singleLevel,
+                                                          wp.wdec, wp.normalization),
+                    badWeights, badFallback, paramsName + " bad paths");
+    CheckLogWeights(AccumulateLogLinkWeights_BadPathsOnly(tc.paths, tc.allLinks, threeLevel,
+                                                          wp.wdec, wp.normalization),
+                    badWeightsLvl, badFallback, paramsName + " bad paths three level");
+
+    for (double wthresh : Thresholds(wp, tc.allLinks.size()))
+    {
+      std::string caseName = paramsName + " wthresh " + std::to_string(wthresh);
+      CheckLogDomainLinks(
+          [&](double logdomain) {
+            return FailureLocalization::DirectWeightedFailedLinks(
+                tc.paths, tc.allLinks, wp.winc, wp.wdec, wp.wscale, wthresh, wp.pathscale,
+                wp.normalization, logdomain);
+          },
+          weights, wthresh, caseName + " WEIGHT_DIR");
+      CheckLogDomainLinks(
+          [&](double logdomain) {
+            return FailureLocalization::DirectWeightedFailedLinks_ThreeLevel(
+                tc.paths, tc.allLinks, wp.winc, wincLvl2, wincLvl3, wp.wdec, wp.wscale, wthresh,
+                wp.pathscale, wp.normalization, logdomain);
+          },
+          weightsLvl, wthresh, caseName + " WEIGHT_DIR_LVL");
+      CheckLogDomainLinks(
+          [&](double logdomain) {
+            return FailureLocalization::BadPathLinkWeight(tc.paths, tc.allLinks, wp.winc, wp.wdec,
+                                                          wp.wscale, wthresh, wp.pathscale,
+                                                          wp.normalization, logdomain);
+          },
+          badWeights, wthresh, caseName + " WEIGHT_BAD");
+      CheckLogDomainLinks(
+          [&](double logdomain) {
+            return FailureLocalization::BadPathLinkWeight_ThreeLevel(
+                tc.paths, tc.allLinks, wp.winc, wincLvl2, wincLvl3, wp.wdec, wp.wscale, wthresh,
+                wp.pathscale, wp.normalization, logdomain);
+          },
+          badWeightsLvl, wthresh, caseName + " WEIGHT_BAD_LVL");
+    }
+  }
+}
+
+// Set based implementations of the link set methods, as they were before the dense link index
+
+LinkSet ReferencePossibleFailedLinks(const ClassPathVec &paths)
+{
+  LinkSet goodLinks;
+  LinkSet badLinks;
+  for (auto &cp : paths)
+  {
+    if (cp.failed)
+    {
+      for (const Link &link : cp.path.links)
+      {
+        if (goodLinks.find(link) == goodLinks.end())
+          badLinks.insert(link);
+      }
+    }
+    else
+    {
+      for (const Link &link : cp.path.links)
+      {
+        goodLinks.insert(link);
+        badLinks.erase(link);
+      }
+    }
+  }
+  return badLinks;
+}
+
+LinkSet ReferenceProbableFailedLinks(const ClassPathVec &paths)
+{
+  LinkSet goodLinks;
+  for (auto &cp : paths)
+  {
+    if (!cp.failed)
+      goodLinks.insert(cp.path.links.begin(), cp.path.links.end());
+  }
+
+  LinkSet badLinks;
+  for (auto &cp : paths)
+  {
+    if (!cp.failed)
+      continue;
+    bool exactlyOneBad = false;
+    Link badLink;
+    for (const Link &link : cp.path.links)
+    {
+      if (goodLinks.find(link) == goodLinks.end())
+      {
+        if (exactlyOneBad)
+        {
+          exactlyOneBad = false;
+          break;
+        }
+        exactlyOneBad = true;
+        badLink = link;
+      }
+    }
+    if (exactlyOneBad)
+      badLinks.insert(badLink);
+  }
+  return badLinks;
+}
+
+LinkSet ReferenceDetectFailedLinks(const ClassPathVec &paths)
+{
+  LinkSet badLinks;
+  for (auto &cp : paths)
+  {
+    if (cp.failed)
+      badLinks.insert(cp.path.links.begin(), cp.path.links.end());
+  }
+  return badLinks;
+}
+
+std::map<Link, double> ReferenceLinkCounts(const ClassPathVec &paths)
+{
+  std::map<Link, double> linkCounts;
+  double overall_count = 0.0;
+  for (const ClassifiedLinkPath &cp : paths)
+  {
+    if (cp.path.links.size() == 0 || !cp.failed)
+      continue;
+    overall_count += 1;
+    for (const Link &link : cp.path.links)
+      linkCounts[link] += 1.0;
+  }
+  if (overall_count != 0)
+  {
+    for (auto &lc : linkCounts)
+      lc.second /= overall_count;
+  }
+  return linkCounts;
+}
+
+void CheckLinkSets(const TestCase &tc, const std::string &name)
+{
+  if (FailureLocalization::PossibleFailedLinks(tc.paths) != ReferencePossibleFailedLinks(tc.paths))
+    Fail(name + ": different POSSIBLE links");
+  if (FailureLocalization::ProbableFailedLinks(tc.paths) != ReferenceProbableFailedLinks(tc.paths))
+    Fail(name + ": different PROBABLE links");
+  if (FailureLocalization::DetectFailedLinks(tc.paths) != ReferenceDetectFailedLinks(tc.paths))
+    Fail(name + ": different DETECTION links");
+
+  // The counts are divided the same way, so they are compared exactly
+  std::map<Link, double> linkCounts = ReferenceLinkCounts(tc.paths);
+  if (CalculateLinkCounts(tc.paths) != linkCounts)
+    Fail(name + ": different link counts");
+  for (double dlcthresh : {0.0, 0.25, 0.5, 0.99})
+  {
+    LinkSet expected;
+    for (const auto &lc : linkCounts)
+    {
+      if (lc.second > dlcthresh)
+        expected.insert(lc.first);
+    }
+    if (FailureLocalization::DirectLinkCount(tc.paths, dlcthresh) != expected)
+      Fail(name + ": different DLC links for dlcthresh " + std::to_string(dlcthresh));
+  }
+}
+
+// With normalization, a marked link keeps its weight once its paths are removed, while the good
+// paths decrease the other links. Here the marked link (1, 2) ties with (3, 4) for the highest
+// weight after the first iteration and is selected again. The iteration has to stop instead of
+// selecting it forever.
+void CheckMarkedBestLink()
+{
+  LinkVec allLinks = {{1, 2}, {2, 3}, {3, 4}};
+  ClassPathVec paths(3);
+  paths[0].path.links = {{1, 2}};
+  paths[0].failed = true;
+  paths[1].path.links = {{2, 3}};
+  paths[2].path.links = {{2, 3}};
+  auto incFactor = single_level_inc_factor(1.0, 1.0, 0.0);  // Failed paths double their links
+  const LinkSet expected = {{1, 2}};
+
+  if (IterativeWeightedLinks(paths, allLinks, incFactor, 0.5, 0.3, 1.0) != expected)
+    Fail("incremental iteration over a marked best link");
+  if (IterativeWeightedLinks_Recompute(paths, allLinks, incFactor, 0.5, 0.3, 1.0) != expected)
+    Fail("recomputed iteration over a marked best link");
+}
+
+}  // namespace
+
+int main()
+{
+  CheckMarkedBestLink();
+
+  std::mt19937 rng(1);
+  for (uint32_t i = 0; i < 200; i++)
+  {
+    TestCase tc = CreateTestCase(rng, i % 2 == 0, i % 4 == 1);
+    CheckIterativeWeights(tc, "case " + std::to_string(i));
+    CheckLogDomain(tc, "case " + std::to_string(i));
+    CheckLinkSets(tc, "case " + std::to_string(i));
+  }
+  // Link bitsets of several words
+  for (uint32_t i = 0; i < 50; i++)
+  {
+    TestCase tc = CreateTestCase(rng, i % 2 == 0, false, 150);
+    CheckLinkSets(tc, "large case " + std::to_string(i));
+  }
+
+  if (AnyChecksFailed())
+    return 1;
+  std::cout << "Link weight kernels match their references (" << comparedSets
+            << " iterative failed link sets compared, " << stoppedSets
+            << " stopped at a marked link, " << logWeightSets << " log domain weight sets, "
+            << fallbackSets << " fallbacks)" << std::endl;
+  return 0;
+}
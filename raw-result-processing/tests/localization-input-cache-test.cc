@@ -0,0 +1,113 @@
+// Requests more localization inputs than a LocalizationInputCache keeps: cached sets are returned
+// again until they are dropped, dropped sets are built again, and sets requested in one batch or
+// by several threads are valid even if the batch or the threads exceed the limit.
+
+#include <localization-input-cache.h>
+
+#include <iostream>
+#include <thread>
+
+#include "test-checks.h"
+#include "test-sim-data.h"
+
+using namespace analysis;
+
+namespace {
+
+const std::vector<std::vector<uint32_t>> paths = {{1, 2, 3}, {1, 2, 4}, {5, 2, 3}, {3, 6}};
+const std::vector<TestFailedLink> failedLinks = {{2, 3, 0.1, 50}};
+const EfmBitSet bits = {EfmBit::Q, EfmBit::L};
+
+std::map<uint32_t, std::set<uint32_t>> SelectAllFlows(const simdata::SimResultSet &srs,
+                                                      const std::set<uint32_t> &observerIds)
+{
+  std::map<uint32_t, std::set<uint32_t>> flowSelectionMap;
+  for (uint32_t oid : observerIds) flowSelectionMap[oid] = srs.GetObserverFlowIds(oid);
+  return flowSelectionMap;
+}
+
+std::shared_ptr<const PathMeasurementSet> Measure(LocalizationInputCache &cache,
+                                                  const simdata::SimResultSet &srs,
+                                                  const std::set<uint32_t> &observerIds)
+{
+  return cache.GetPathMeasurementSet(srs, observerIds, SelectAllFlows(srs, observerIds), bits, 0,
+                                     ClassificationMode::PERFECT, 0);
+}
+
+size_t CountPaths(const PathMeasurementSet &measurements)
+{
+  size_t count = 0;
+  for (const auto &observerPaths : measurements.paths)
+  {
+    for (const auto &bitPaths : observerPaths.second) count += bitPaths.second.size();
+  }
+  return count;
+}
+
+}  // namespace
+
+int main()
+{
+  TestEvents events;
+  events.lossEvents = true;
+  simdata::SimResultSetPointer srs = CreateTestResultSet(paths, 2, failedLinks, events);
+  const std::vector<std::set<uint32_t>> observerSets = {{1, 2}, {2, 3}, {1, 5}, {2, 4}};
+
+  LocalizationInputCache cache(2);
+  auto first = Measure(cache, *srs, observerSets[0]);
+  Measure(cache, *srs, observerSets[1]);
+  if (Measure(cache, *srs, observerSets[0]) != first)
+    Fail("a cached set was built again");
+
+  Measure(cache, *srs, observerSets[2]);
+  Measure(cache, *srs, observerSets[3]);
+  auto rebuilt = Measure(cache, *srs, observerSets[0]);
+  if (rebuilt == first)
+    Fail("a dropped set was returned");
+  if (CountPaths(*rebuilt) != CountPaths(*first) || CountPaths(*first) == 0 ||
+      rebuilt->flowIds != first->flowIds)
+    Fail("a dropped set was built differently");
+
+  // More thresholds than the cache keeps are classified in one batch
+  std::vector<ClassificationThresholds> thresholds = {{0.01, 10}, {0.05, 20}, {0.1, 50}};
+  auto sets = cache.GetClassifiedPathSets(*srs, observerSets[1],
+                                          SelectAllFlows(*srs, observerSets[1]), bits, thresholds,
+                                          0, ClassificationMode::PERFECT, "", 2.0, 4.0, 0);
+  if (sets.size() != thresholds.size())
+    Fail("wrong number of classified path sets");
+  for (size_t i = 0; i < sets.size(); i++)
+  {
+    if (!sets[i] || sets[i]->GetConfig().lossRateTh != thresholds[i].lossRateTh)
+      Fail("wrong classified path set of thresholds " + std::to_string(i));
+  }
+
+  // Threads request more sets than the cache keeps, so that entries are dropped while other
+  // threads wait for them
+  LocalizationInputCache sharedCache(1);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < 8; t++)
+  {
+    threads.emplace_back([&, t]() {
+      try
+      {
+        for (uint32_t r = 0; r < 50; r++)
+        {
+          const std::set<uint32_t> &observerIds = observerSets[(t + r) % observerSets.size()];
+          auto measurements = Measure(sharedCache, *srs, observerIds);
+          if (!measurements || measurements->observerIds != observerIds)
+            Fail("wrong set returned to a concurrent request");
+        }
+      }
+      catch (const std::exception &e)
+      {
+        Fail(std::string("exception: ") + e.what());
+      }
+    });
+  }
+  for (std::thread &thread : threads) thread.join();
+
+  if (AnyChecksFailed())
+    return 1;
+  std::cout << "Cache limits checked" << std::endl;
+  return 0;
+}
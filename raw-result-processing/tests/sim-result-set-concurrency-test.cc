@@ -0,0 +1,132 @@
+// Reads a frozen SimResultSet from several threads at once: the id sets and flow paths created by
+// Freeze, the filtered views created on demand under the view lock, and the events of the views,
+// which are copied on write from the shared events of the unfiltered result set.
+
+#include <sim-result-set.h>
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#include "test-checks.h"
+#include "test-sim-data.h"
+
+using namespace simdata;
+
+namespace {
+
+// Even flows pass the observers in this order, odd flows in reverse order
+const std::vector<uint32_t> observerPath = {1, 2, 3};
+const uint32_t observerCount = observerPath.size();
+const uint32_t flowCount = 40;
+const uint32_t spinEventCount = 6;  // Spin bit edges and spin bit delays per flow and observer
+const uint32_t maxTransients = 4;   // Filters remove the last 1..maxTransients spin events
+
+std::vector<uint32_t> ExpectedPath(uint32_t flowId)
+{
+  std::vector<uint32_t> path = observerPath;
+  if (flowId % 2 == 1)
+    std::reverse(path.begin(), path.end());
+  return path;
+}
+
+// Events of a flow at each observer after removing the last transients spin bit edges and delays
+uint32_t ExpectedEventCount(uint32_t transients) { return 1 + 2 * (spinEventCount - transients); }
+
+void CheckResultSet(const SimResultSet &srs, uint32_t transients, const std::string &name)
+{
+  if (!srs.IsFrozen())
+    Fail(name + " is not frozen");
+
+  const std::set<uint32_t> &flowIds = srs.GetObserverFlowIds(true);
+  if (flowIds.size() != flowCount || srs.GetObserverFlowIds(false) != flowIds)
+    Fail(name + ": wrong observer flow ids");
+
+  for (uint32_t f = 0; f < flowCount; f++)
+  {
+    const SimResultSet::FlowPath &path = srs.GetFlowPath(f);
+    if (path.observerIds != ExpectedPath(f) || path.links.size() != observerCount - 1)
+      Fail(name + ": wrong path of flow " + std::to_string(f));
+
+    for (uint32_t o = 1; o <= observerCount; o++)
+    {
+      if (srs.GetObserverVP(o)->GetFlow(f)->GetEventCount() != ExpectedEventCount(transients))
+      {
+        Fail(name + ": wrong event count of flow " + std::to_string(f) + " at observer " +
+             std::to_string(o));
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main()
+{
+  // Only spin bit events besides the flow begins, so that the filters change every flow
+  TestEvents events;
+  events.spinEvents = spinEventCount;
+  SimResultSetPointer srs = CreateTestResultSet({observerPath}, flowCount / 2, {}, events);
+  ConstSimResultSetPointer frozen = srs->Freeze();
+
+  std::vector<SimFilter> filters(maxTransients + 1);
+  for (uint32_t t = 0; t <= maxTransients; t++) filters[t].removeLastXSpinTransients = t;
+
+  const uint32_t threadCount = std::max(8u, std::thread::hardware_concurrency());
+  const uint32_t rounds = 20;
+
+  // The views each thread got per filter, all threads have to get the same (cached) view
+  std::vector<std::vector<SimResultSetPointer>> views(threadCount);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < threadCount; t++)
+  {
+    threads.emplace_back([&, t]() {
+      try
+      {
+        views[t].resize(filters.size());
+        for (uint32_t r = 0; r < rounds; r++)
+        {
+          // Threads request the filters in different orders, so that views are created while
+          // other threads read the result set and the views created before
+          for (uint32_t i = 0; i < filters.size(); i++)
+          {
+            uint32_t transients = (i + t + r) % filters.size();
+            SimResultSetPointer view = frozen->ApplyFilter(filters[transients]);
+            if (!views[t][transients])
+              views[t][transients] = view;
+            else if (views[t][transients] != view)
+              Fail("ApplyFilter returned another view for the same filter");
+
+            CheckResultSet(*view, transients, "view " + std::to_string(transients));
+            CheckResultSet(*frozen, 0, "unfiltered result set");
+          }
+        }
+      }
+      catch (const std::exception &e)
+      {
+        Fail(std::string("exception: ") + e.what());
+      }
+    });
+  }
+  for (std::thread &thread : threads) thread.join();
+
+  for (uint32_t i = 0; i < filters.size(); i++)
+  {
+    SimResultSetPointer view = frozen->ApplyFilter(filters[i]);
+    if (filters[i].IsDefault() && view != srs)
+      Fail("the default filter did not return the result set itself");
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+      if (views[t][i] != view)
+        Fail("threads got different views for the same filter");
+    }
+  }
+
+  // Filtering copied the shared spin bit events before removing some, the originals are intact
+  CheckResultSet(*frozen, 0, "unfiltered result set after filtering");
+
+  if (AnyChecksFailed())
+    return 1;
+  std::cout << "Frozen result set read by " << threadCount << " threads" << std::endl;
+  return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef TEST_CHECKS_H
+#define TEST_CHECKS_H
+
+// Failed checks of the tests are reported with Fail and counted, so that a test continues after a
+// failed check and main returns 1 if AnyChecksFailed. Fail can be called from several threads.
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+inline std::atomic<uint32_t> failedChecks{0};
+
+/// @brief Counts a failed check, only the first ten messages are printed
+inline void Fail(const std::string &message)
+{
+  if (failedChecks++ < 10)
+    std::cerr << "FAILED: " << message << std::endl;
+}
+
+/// @brief Prints the number of failed checks, if any
+inline bool AnyChecksFailed()
+{
+  if (failedChecks == 0)
+    return false;
+  std::cerr << failedChecks << " checks failed" << std::endl;
+  return true;
+}
+
+#endif  // TEST_CHECKS_H
@@ -0,0 +1,224 @@
+#ifndef TEST_SIM_DATA_H
+#define TEST_SIM_DATA_H
+
+// Creates small simulation runs for the tests from a list of observer paths. Each path is passed
+// by bidirectional flows, the forward flows pass the observers in the order of the path, the
+// reverse flows in the opposite order. Each observer measures the flows with spin bit events and,
+// if requested, Q, L, and T bit events whose loss rates and delays follow from the links configured
+// to fail, so the runs can be classified with ClassificationMode::STATIC as well as with
+// ClassificationMode::PERFECT.
+
+#include <sim-result-set.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct TestFailedLink
+{
+  uint32_t sourceNodeId;
+  uint32_t destNodeId;
+  double lossRate;
+  uint32_t delayMs;
+};
+
+/// @brief The measurement events written for each flow at each observer besides the flow begin
+struct TestEvents
+{
+  uint32_t spinEvents = 4;  // Spin bit edges, each with a spin bit delay at the same time
+  bool lossEvents = false;  // Q bit loss, L bit set, and T bit full and half loss events
+};
+
+/// @brief Creates the QLOG of a run in which flowPairsPerPath flow pairs pass each path
+/// @param paths The observer ids on the path of each forward flow, at least two per path
+/// @param failedLinks The links configured to fail
+/// @param events The measurement events of the flows
+inline std::string CreateTestQlog(const std::vector<std::vector<uint32_t>> &paths,
+                                  uint32_t flowPairsPerPath,
+                                  const std::vector<TestFailedLink> &failedLinks,
+                                  const TestEvents &events = TestEvents())
+{
+  std::map<std::pair<uint32_t, uint32_t>, TestFailedLink> failures;
+  for (const TestFailedLink &link : failedLinks)
+    failures.emplace(std::make_pair(link.sourceNodeId, link.destNodeId), link);
+  // Loss rate and delay of the links from observer begin to observer end of a path, links that
+  // do not fail lose nothing and take 5 ms
+  auto pathLoss = [&failures](const std::vector<uint32_t> &path, size_t begin, size_t end) {
+    double delivered = 1.0;
+    for (size_t i = begin + 1; i <= end; i++)
+    {
+      auto it = failures.find({path[i - 1], path[i]});
+      if (it != failures.end())
+        delivered *= 1.0 - it->second.lossRate;
+    }
+    return 1.0 - delivered;
+  };
+  auto pathDelay = [&failures](const std::vector<uint32_t> &path, size_t begin, size_t end) {
+    uint32_t delay = 0;
+    for (size_t i = begin + 1; i <= end; i++)
+    {
+      auto it = failures.find({path[i - 1], path[i]});
+      delay += 5 + (it != failures.end() ? it->second.delayMs : 0);
+    }
+    return delay;
+  };
+
+  // Flow pair k has the forward flow 2k and the reverse flow 2k + 1
+  std::map<uint32_t, std::set<uint32_t>> observerFlows;
+  std::map<uint32_t, std::vector<std::pair<double, std::string>>> observerEvents;
+  std::set<std::pair<uint32_t, uint32_t>> links;
+  std::ostringstream flows;
+  for (uint32_t p = 0; p < paths.size(); p++)
+  {
+    const std::vector<uint32_t> &path = paths[p];
+    for (size_t i = 1; i < path.size(); i++)
+    {
+      links.emplace(path[i - 1], path[i]);
+      links.emplace(path[i], path[i - 1]);
+    }
+
+    for (uint32_t n = 0; n < flowPairsPerPath; n++)
+    {
+      uint32_t pair = p * flowPairsPerPath + n;
+      for (uint32_t direction = 0; direction < 2; direction++)
+      {
+        uint32_t flowId = 2 * pair + direction;
+        uint32_t client = 1000 + p;
+        uint32_t server = 2000 + p;
+        uint32_t clientPort = 10000 + pair;
+        flows << (flowId > 0 ? ", " : "") << "\"" << flowId << "\": {\"src_node_id\": "
+              << (direction == 0 ? client : server) << ", \"src_port\": "
+              << (direction == 0 ? clientPort : 443) << ", \"dst_node_id\": "
+              << (direction == 0 ? server : client) << ", \"dst_port\": "
+              << (direction == 0 ? 443 : clientPort) << ", \"prot\": 17}";
+
+        std::vector<uint32_t> flowPath = path;
+        if (direction == 1)
+          std::reverse(flowPath.begin(), flowPath.end());
+        std::vector<uint32_t> reversePath(flowPath.rbegin(), flowPath.rend());
+        size_t last = flowPath.size() - 1;
+
+        for (size_t i = 0; i < flowPath.size(); i++)
+        {
+          uint32_t observerId = flowPath[i];
+          // The flow begins define the order of the observers on the flow path
+          double begin = pair * 10.0 + direction * 5.0 + i * 0.1;
+          observerFlows[observerId].insert(flowId);
+          auto addEvent = [&](const std::string &name, double time, const std::string &data) {
+            observerEvents[observerId].emplace_back(
+                time, "{\"name\": \"efm_observer:" + name + "\", \"time\": " +
+                          std::to_string(time) + ", \"group_id\": {\"flow_id\": " +
+                          std::to_string(flowId) + "}, \"data\": {" + data + "}}");
+          };
+          addEvent("flow_begin", begin, "");
+
+          // L: end-to-end loss of 100 packets, one L bit per lost packet
+          uint32_t lBits = events.lossEvents ? std::lround(pathLoss(flowPath, 0, last) * 100) : 0;
+          for (uint32_t n = 0; n < lBits; n++)
+          {
+            addEvent("l_bit_set", begin + 1.0 + n * 0.01,
+                     "\"pkt_count\": " + std::to_string(100 * (n + 1) / lBits) +
+                         ", \"seq\": " + std::to_string(n));
+          }
+
+          // Spin: round-trip delay, and half of it from the observer to the server and back
+          uint32_t rtDelay = pathDelay(flowPath, 0, last) + pathDelay(reversePath, 0, last);
+          uint32_t halfDelay = pathDelay(flowPath, i, last) + pathDelay(reversePath, 0, last - i);
+          for (uint32_t n = 0; n < events.spinEvents; n++)
+          {
+            double time = begin + 2.0 + n * 0.1;
+            addEvent("spin_bit_edge", time,
+                     std::string("\"new_state\": ") + (n % 2 ? "true" : "false") +
+                         ", \"seq\": " + std::to_string(n));
+            addEvent("spin_bit_delay", time,
+                     "\"full_delay_ms\": " + std::to_string(rtDelay + n) +
+                         ", \"half_delay_ms\": " + std::to_string(halfDelay + n));
+          }
+
+          if (!events.lossEvents)
+            continue;
+
+          // Q: upstream loss in blocks of 64 packets
+          uint32_t qLoss = std::lround(pathLoss(flowPath, 0, i) * 64);
+          for (uint32_t n = 0; n < 4; n++)
+          {
+            addEvent("q_bit_loss", begin + 3.0 + n * 0.1,
+                     "\"pkt_count\": 64, \"loss\": " + std::to_string(qLoss));
+          }
+
+          // T: round-trip loss, and half of it up to the observer on the way back
+          double rtLoss = 1.0 - (1.0 - pathLoss(flowPath, 0, last)) *
+                                    (1.0 - pathLoss(reversePath, 0, last));
+          double halfLoss = 1.0 - (1.0 - pathLoss(flowPath, i, last)) *
+                                      (1.0 - pathLoss(reversePath, 0, last - i));
+          addEvent("t_bit_loss_full", begin + 3.5,
+                   "\"pkt_count\": 100, \"loss\": " + std::to_string(std::lround(rtLoss * 100)));
+          addEvent("t_bit_loss_half", begin + 3.5,
+                   "\"pkt_count\": 100, \"loss\": " +
+                       std::to_string(std::lround(halfLoss * 100)));
+        }
+      }
+    }
+  }
+
+  std::ostringstream qlog;
+  qlog << "{\"title\": \"test-run\", \"summary\": {\"client_stats\": {}, \"server_stats\": {}, "
+       << "\"observer_stats\": {";
+  for (auto it = observerFlows.begin(); it != observerFlows.end(); it++)
+  {
+    qlog << (it != observerFlows.begin() ? ", " : "") << "\"" << it->first << "\": {";
+    for (auto flowIt = it->second.begin(); flowIt != it->second.end(); flowIt++)
+    {
+      qlog << (flowIt != it->second.begin() ? ", " : "") << "\"" << *flowIt
+           << "\": {\"total_packets\": 100, \"total_efm_packets\": 100}";
+    }
+    qlog << "}";
+  }
+  qlog << "}, \"config\": {}, \"failed_links\": [";
+  for (size_t i = 0; i < failedLinks.size(); i++)
+  {
+    qlog << (i > 0 ? ", " : "") << "{\"nodeA\": " << failedLinks[i].sourceNodeId
+         << ", \"nodeB\": " << failedLinks[i].destNodeId
+         << ", \"lossRate\": " << failedLinks[i].lossRate
+         << ", \"delayMs\": " << failedLinks[i].delayMs << "}";
+  }
+  qlog << "], \"host_connections\": {}, \"observer_flows\": {" << flows.str()
+       << "}, \"observer_paths\": {}, \"ping_routes\": {}, \"link_sets\": {\"core_links\": [";
+  for (auto it = links.begin(); it != links.end(); it++)
+  {
+    qlog << (it != links.begin() ? ", " : "") << "{\"src\": " << it->first
+         << ", \"dst\": " << it->second << "}";
+  }
+  qlog << "], \"edge_links\": []}, \"gt_stats\": [], \"backbone_overrides\": []}, \"traces\": [";
+
+  for (auto it = observerEvents.begin(); it != observerEvents.end(); it++)
+  {
+    std::sort(it->second.begin(), it->second.end());
+    qlog << (it != observerEvents.begin() ? ", " : "") << "{\"vantage_point\": {\"name\": \""
+         << it->first << "/observer\", \"type\": \"network\"}, \"events\": [";
+    for (size_t i = 0; i < it->second.size(); i++)
+      qlog << (i > 0 ? ", " : "") << it->second[i].second;
+    qlog << "]}";
+  }
+  qlog << "]}";
+  return qlog.str();
+}
+
+/// @brief Imports a run created by CreateTestQlog
+inline simdata::SimResultSetPointer CreateTestResultSet(
+    const std::vector<std::vector<uint32_t>> &paths, uint32_t flowPairsPerPath,
+    const std::vector<TestFailedLink> &failedLinks, const TestEvents &events = TestEvents())
+{
+  simdjson::padded_string json(CreateTestQlog(paths, flowPairsPerPath, failedLinks, events));
+  simdjson::ondemand::parser parser;
+  simdjson::ondemand::document doc = parser.iterate(json);
+  simdjson::ondemand::object qlog = doc.get_object();
+  return std::make_shared<simdata::SimResultSet>(qlog);
+}
+
+#endif  // TEST_SIM_DATA_H